@@ -81,7 +81,7 @@ void Sound::RegisterObject(Context* context)
     context->RegisterFactory<Sound>();
 }
 
-bool Sound::Load(Deserializer& source)
+bool Sound::BeginLoad(Deserializer& source)
 {
     PROFILE(LoadSound);
     
@@ -93,13 +93,16 @@ bool Sound::Load(Deserializer& source)
     else
         success = LoadRaw(source);
     
-    // Load optional parameters
-    if (success)
-        LoadParameters();
-    
     return success;
 }
 
+bool Sound::EndLoad()
+{
+    // Load optional parameters
+    LoadParameters();
+    return true;
+}
+
 bool Sound::LoadOggVorbis(Deserializer& source)
 {
     unsigned dataSize = source.GetSize();
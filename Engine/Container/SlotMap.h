@@ -0,0 +1,211 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "HashMap.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+/// Map from unsigned integer keys to pointers, optimized for keys allocated sequentially from a base value. Keys inside a window of recently allocated keys are looked up through a directly indexed slot array, while sparse outliers go to a hash map. When sequential allocation has moved far past the oldest keys, the window slides forward and the remaining old keys move to the hash map. Values are stored densely for fast iteration.
+template <class T> class SlotMap
+{
+public:
+    /// Construct with base key.
+    SlotMap(unsigned base = 0) :
+        base_(base),
+        slotBase_(base)
+    {
+    }
+    
+    /// Insert or replace a value.
+    void Insert(unsigned key, T* value)
+    {
+        unsigned index = FindIndex(key);
+        if (index < values_.Size())
+        {
+            values_[index] = value;
+            return;
+        }
+        
+        index = values_.Size();
+        keys_.Push(key);
+        values_.Push(value);
+        
+        // Grow the slot array if it stays reasonably dense. Grow geometrically, as growing moves the hash map keys that
+        // now fit. If not dense, but the key follows the existing slots, the keys are being allocated sequentially while
+        // old ones are erased: slide the window forward, leaving room for as many new keys as there were before
+        unsigned slot = key - slotBase_;
+        unsigned maxSlots = (values_.Size() << 1) + MIN_SLOT_GROWTH;
+        if (slot >= slots_.Size())
+        {
+            if (slot < maxSlots)
+                GrowSlots(slot < (slots_.Size() << 1) ? slots_.Size() << 1 : slot + 1);
+            else if (slot < slots_.Size() + MIN_SLOT_GROWTH)
+            {
+                MoveSlots(key + 1 - (maxSlots >> 1), maxSlots);
+                slot = key - slotBase_;
+            }
+        }
+        if (slot < slots_.Size())
+            slots_[slot] = index + 1;
+        else
+            overflow_[key] = index;
+    }
+    
+    /// Erase a value. Return true if was found.
+    bool Erase(unsigned key)
+    {
+        unsigned index = FindIndex(key);
+        if (index >= values_.Size())
+            return false;
+        
+        SetIndex(key, NOT_FOUND);
+        
+        // Move the last value into the erased position to keep the value array dense
+        unsigned last = values_.Size() - 1;
+        if (index != last)
+        {
+            keys_[index] = keys_[last];
+            values_[index] = values_[last];
+            SetIndex(keys_[index], index);
+        }
+        keys_.Resize(last);
+        values_.Resize(last);
+        return true;
+    }
+    
+    /// Remove all values and release the slot array.
+    void Clear()
+    {
+        keys_.Clear();
+        values_.Clear();
+        slots_.Clear();
+        overflow_.Clear();
+        slotBase_ = base_;
+    }
+    
+    /// Return value for key, or null if not found.
+    T* Find(unsigned key) const
+    {
+        unsigned index = FindIndex(key);
+        return index < values_.Size() ? values_[index] : 0;
+    }
+    
+    /// Return whether contains a key.
+    bool Contains(unsigned key) const { return FindIndex(key) < values_.Size(); }
+    /// Return number of values.
+    unsigned Size() const { return values_.Size(); }
+    /// Return whether is empty.
+    bool Empty() const { return values_.Empty(); }
+    /// Return base key.
+    unsigned GetBase() const { return base_; }
+    /// Return all keys, in the same order as the values.
+    const PODVector<unsigned>& GetKeys() const { return keys_; }
+    /// Return all values. The order is not stable across erasures.
+    const PODVector<T*>& GetValues() const { return values_; }
+    
+private:
+    /// Return value array index for key, or NOT_FOUND.
+    unsigned FindIndex(unsigned key) const
+    {
+        unsigned slot = key - slotBase_;
+        if (slot < slots_.Size())
+            return slots_[slot] - 1;
+        else if (overflow_.Size())
+        {
+            HashMap<unsigned, unsigned>::ConstIterator i = overflow_.Find(key);
+            return i != overflow_.End() ? i->second_ : NOT_FOUND;
+        }
+        else
+            return NOT_FOUND;
+    }
+    
+    /// Set value array index for an existing key. NOT_FOUND removes the key.
+    void SetIndex(unsigned key, unsigned index)
+    {
+        unsigned slot = key - slotBase_;
+        if (slot < slots_.Size())
+            slots_[slot] = index + 1;
+        else if (index != NOT_FOUND)
+            overflow_[key] = index;
+        else
+            overflow_.Erase(key);
+    }
+    
+    /// Grow the slot array and move the hash map keys that now fit into it.
+    void GrowSlots(unsigned newSize)
+    {
+        unsigned oldSize = slots_.Size();
+        slots_.Resize(newSize);
+        for (unsigned i = oldSize; i < newSize; ++i)
+            slots_[i] = 0;
+        
+        for (HashMap<unsigned, unsigned>::Iterator i = overflow_.Begin(); i != overflow_.End();)
+        {
+            unsigned slot = i->first_ - slotBase_;
+            if (slot < newSize)
+            {
+                slots_[slot] = i->second_ + 1;
+                i = overflow_.Erase(i);
+            }
+            else
+                ++i;
+        }
+    }
+    
+    /// Move the slot array to start from a new key and rebuild it from all keys. Keys outside it go to the hash map.
+    void MoveSlots(unsigned newSlotBase, unsigned newSize)
+    {
+        slotBase_ = newSlotBase;
+        slots_.Resize(newSize);
+        for (unsigned i = 0; i < newSize; ++i)
+            slots_[i] = 0;
+        overflow_.Clear();
+        
+        for (unsigned i = 0; i < keys_.Size(); ++i)
+            SetIndex(keys_[i], i);
+    }
+    
+    /// Value array index for a key that is not found.
+    static const unsigned NOT_FOUND = 0xffffffff;
+    /// Minimum amount of empty slots that may be allocated ahead of the existing values.
+    static const unsigned MIN_SLOT_GROWTH = 1024;
+    
+    /// Base key.
+    unsigned base_;
+    /// Key of the first slot.
+    unsigned slotBase_;
+    /// Keys.
+    PODVector<unsigned> keys_;
+    /// Values.
+    PODVector<T*> values_;
+    /// Value array index plus one for each key relative to the first slot key, or zero if unused.
+    PODVector<unsigned> slots_;
+    /// Value array indices for keys outside the slot array.
+    HashMap<unsigned, unsigned> overflow_;
+};
+
+}
@@ -55,6 +55,13 @@ public:
     virtual void Get(const Serializable* ptr, Variant& dest) const {}
     /// Set the attribute.
     virtual void Set(Serializable* ptr, const Variant& src) {}
+    /// Compare the attribute to a value. Return true if equal. Default implementation gets the attribute into a temporary variant.
+    virtual bool Equals(const Serializable* ptr, const Variant& value) const
+    {
+        Variant current;
+        Get(ptr, current);
+        return current == value;
+    }
 };
 
 /// Description of an automatically serializable variable.
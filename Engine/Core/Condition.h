@@ -45,6 +45,8 @@ private:
     #ifndef WIN32
     /// Mutex for the event, necessary for pthreads-based implementation.
     void* mutex_;
+    /// Signaled flag, necessary for pthreads-based implementation so that a set before waiting is not lost.
+    bool signaled_;
     #endif
     /// Operating system specific event.
     void* event_;
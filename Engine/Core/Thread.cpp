@@ -51,6 +51,8 @@ void* ThreadFunctionStatic(void* data)
 }
 #endif
 
+unsigned long Thread::mainThreadID;
+
 Thread::Thread() :
     handle_(0),
     shouldRun_(false)
@@ -113,4 +115,22 @@ void Thread::SetPriority(int priority)
     #endif
 }
 
+void Thread::SetMainThread()
+{
+    #ifdef WIN32
+    mainThreadID = GetCurrentThreadId();
+    #else
+    mainThreadID = (unsigned long)pthread_self();
+    #endif
+}
+
+bool Thread::IsMainThread()
+{
+    #ifdef WIN32
+    return GetCurrentThreadId() == mainThreadID;
+    #else
+    return pthread_equal(pthread_self(), (pthread_t)mainThreadID) != 0;
+    #endif
+}
+
 }
@@ -47,11 +47,19 @@ public:
     /// Return whether thread exists.
     bool IsStarted() const { return handle_ != 0; }
     
+    /// Set the current thread as the main thread.
+    static void SetMainThread();
+    /// Return whether is executing in the main thread.
+    static bool IsMainThread();
+    
 protected:
     /// Thread handle.
     void* handle_;
     /// Running flag.
     volatile bool shouldRun_;
+    
+    /// Main thread's identifier.
+    static unsigned long mainThreadID;
 };
 
 }
@@ -629,6 +629,9 @@ template <class T> void RegisterResource(asIScriptEngine* engine, const char* cl
     engine->RegisterObjectMethod(className, "void set_name(const String&in) const", asMETHODPR(T, SetName, (const String&), void), asCALL_THISCALL);
     engine->RegisterObjectMethod(className, "const String& get_name() const", asMETHODPR(T, GetName, () const, const String&), asCALL_THISCALL);
     engine->RegisterObjectMethod(className, "uint get_memoryUse() const", asMETHODPR(T, GetMemoryUse, () const, unsigned), asCALL_THISCALL);
+    engine->RegisterObjectMethod(className, "uint get_gpuMemoryUse() const", asMETHODPR(T, GetGPUMemoryUse, () const, unsigned), asCALL_THISCALL);
+    engine->RegisterObjectMethod(className, "uint get_cpuMemoryUse() const", asMETHODPR(T, GetCPUMemoryUse, () const, unsigned), asCALL_THISCALL);
+    engine->RegisterObjectMethod(className, "uint get_lastUseFrame() const", asMETHODPR(T, GetLastUseFrame, () const, unsigned), asCALL_THISCALL);
     engine->RegisterObjectMethod(className, "uint get_useTimer()" ,asMETHODPR(T, GetUseTimer, (), unsigned), asCALL_THISCALL);
 }
 
@@ -28,6 +28,7 @@
 #include "DebugHud.h"
 #include "Engine.h"
 #include "FileSystem.h"
+#include "IOQueue.h"
 #include "Graphics.h"
 #include "Input.h"
 #include "Log.h"
@@ -145,8 +146,20 @@ bool Engine::Initialize(const VariantMap& parameters)
         LOGINFO(ToString("Created %u worker thread%s", numThreads, numThreads > 1 ? "s" : ""));
     }
     
-    // Add resource paths
+    // Create the I/O threads for asynchronous file reads
+    unsigned numIOThreads = GetParameter(parameters, "WorkerThreads", true).GetBool() ? GetParameter(parameters, "IOThreads",
+        1).GetInt() : 0;
+    if (numIOThreads)
+        GetSubsystem<IOQueue>()->CreateThreads(numIOThreads);
+    
+    // Create the background resource loader threads
     ResourceCache* cache = GetSubsystem<ResourceCache>();
+    unsigned numBackgroundLoadThreads = GetParameter(parameters, "WorkerThreads", true).GetBool() ? GetParameter(parameters,
+        "BackgroundLoadThreads", 1).GetInt() : 0;
+    if (numBackgroundLoadThreads)
+        cache->CreateBackgroundLoadThreads(numBackgroundLoadThreads);
+    
+    // Add resource paths
     FileSystem* fileSystem = GetSubsystem<FileSystem>();
     String exePath = fileSystem->GetProgramDir();
     
@@ -400,15 +413,19 @@ void Engine::DumpResources()
     {
         unsigned num = i->second_.resources_.Size();
         unsigned memoryUse = i->second_.memoryUse_;
+        unsigned gpuMemoryUse = i->second_.gpuMemoryUse_;
         
         if (num)
         {
             LOGRAW("Resource type " + i->second_.resources_.Begin()->second_->GetTypeName() +
-                ": count " + String(num) + " memory use " + String(memoryUse) + "\n");
+                ": count " + String(num) + " memory use " + String(memoryUse) + " (cpu " + String(memoryUse -
+                gpuMemoryUse) + " gpu " + String(gpuMemoryUse) + ") unused " + String(cache->GetNumUnusedResources(i->first_)) +
+                "\n");
         }
     }
     
-    LOGRAW("Total memory use of all resources " + String(cache->GetTotalMemoryUse()) + "\n\n");
+    LOGRAW("Total memory use of all resources " + String(cache->GetTotalMemoryUse()) + " (gpu " +
+        String(cache->GetTotalGPUMemoryUse()) + ")\n\n");
     #endif
 }
 
@@ -672,6 +689,7 @@ void Engine::RegisterSubsystems()
     context_->RegisterSubsystem(new Profiler(context_));
     #endif
     context_->RegisterSubsystem(new FileSystem(context_));
+    context_->RegisterSubsystem(new IOQueue(context_));
     context_->RegisterSubsystem(new ResourceCache(context_));
     context_->RegisterSubsystem(new Network(context_));
     
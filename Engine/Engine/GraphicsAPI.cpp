@@ -435,6 +435,9 @@ static void RegisterTextures(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Texture2D", "bool SetSize(int, int, uint, TextureUsage usage = TEXTURE_STATIC)", asMETHOD(Texture2D, SetSize), asCALL_THISCALL);
     engine->RegisterObjectMethod("Texture2D", "bool Load(Image@+, bool useAlpha = false)", asFUNCTION(Texture2DLoad), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Texture2D", "RenderSurface@+ get_renderSurface() const", asMETHOD(Texture2D, GetRenderSurface), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Texture2D", "bool get_streaming() const", asMETHOD(Texture2D, IsStreaming), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Texture2D", "bool SetStreamingLevel(uint)", asMETHOD(Texture2D, SetStreamingLevel), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Texture2D", "uint get_streamingLevel() const", asMETHOD(Texture2D, GetStreamingLevel), asCALL_THISCALL);
     
     RegisterTexture<TextureCube>(engine, "TextureCube");
     engine->RegisterObjectMethod("TextureCube", "bool SetSize(int, uint, TextureUsage usage = TEXTURE_STATIC)", asMETHOD(TextureCube, SetSize), asCALL_THISCALL);
@@ -1157,6 +1160,14 @@ static void RegisterRenderer(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Renderer", "TextureFilterMode get_textureFilterMode() const", asMETHOD(Renderer, GetTextureFilterMode), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void set_textureQuality(int)", asMETHOD(Renderer, SetTextureQuality), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "int get_textureQuality() const", asMETHOD(Renderer, GetTextureQuality), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "void set_textureStreaming(bool)", asMETHOD(Renderer, SetTextureStreaming), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "bool get_textureStreaming() const", asMETHOD(Renderer, GetTextureStreaming), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "void set_textureStreamingBudget(uint)", asMETHOD(Renderer, SetTextureStreamingBudget), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "uint get_textureStreamingBudget() const", asMETHOD(Renderer, GetTextureStreamingBudget), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "void set_maxStreamingUploads(int)", asMETHOD(Renderer, SetMaxStreamingUploads), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "int get_maxStreamingUploads() const", asMETHOD(Renderer, GetMaxStreamingUploads), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "uint get_textureStreamingMemoryUse() const", asMETHOD(Renderer, GetTextureStreamingMemoryUse), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "uint get_numStreamingTextures() const", asMETHOD(Renderer, GetNumStreamingTextures), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void set_materialQuality(int)", asMETHOD(Renderer, SetMaterialQuality), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "int get_materialQuality() const", asMETHOD(Renderer, GetMaterialQuality), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void set_drawShadows(bool)", asMETHOD(Renderer, SetDrawShadows), asCALL_THISCALL);
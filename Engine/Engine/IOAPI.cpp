@@ -322,6 +322,9 @@ void RegisterFileSystem(asIScriptEngine* engine)
     engine->RegisterObjectMethod("FileSystem", "bool Copy(const String&in, const String&in)", asMETHOD(FileSystem, Copy), asCALL_THISCALL);
     engine->RegisterObjectMethod("FileSystem", "bool Rename(const String&in, const String&in)", asMETHOD(FileSystem, Rename), asCALL_THISCALL);
     engine->RegisterObjectMethod("FileSystem", "bool Delete(const String&in)", asMETHOD(FileSystem, Delete), asCALL_THISCALL);
+    engine->RegisterObjectMethod("FileSystem", "bool IndexDir(const String&in)", asMETHODPR(FileSystem, IndexDir, (const String&), bool), asCALL_THISCALL);
+    engine->RegisterObjectMethod("FileSystem", "void RemoveIndexedDir(const String&in)", asMETHOD(FileSystem, RemoveIndexedDir), asCALL_THISCALL);
+    engine->RegisterObjectMethod("FileSystem", "bool IsIndexed(const String&in) const", asMETHOD(FileSystem, IsIndexed), asCALL_THISCALL);
     engine->RegisterObjectMethod("FileSystem", "String get_currentDir() const", asMETHOD(FileSystem, GetCurrentDir), asCALL_THISCALL);
     engine->RegisterObjectMethod("FileSystem", "void set_currentDir(const String&in)", asMETHOD(FileSystem, SetCurrentDir), asCALL_THISCALL);
     engine->RegisterObjectMethod("FileSystem", "String get_programDir() const", asMETHOD(FileSystem, GetProgramDir), asCALL_THISCALL);
@@ -360,6 +363,7 @@ static void RegisterPackageFile(asIScriptEngine* engine)
     engine->RegisterObjectMethod("PackageFile", "uint get_numFiles() const", asMETHOD(PackageFile, GetNumFiles), asCALL_THISCALL);
     engine->RegisterObjectMethod("PackageFile", "uint get_totalSize() const", asMETHOD(PackageFile, GetTotalSize), asCALL_THISCALL);
     engine->RegisterObjectMethod("PackageFile", "uint get_checksum() const", asMETHOD(PackageFile, GetChecksum), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PackageFile", "bool get_compressed() const", asMETHOD(PackageFile, IsCompressed), asCALL_THISCALL);
 }
 
 void RegisterIOAPI(asIScriptEngine* engine)
@@ -41,6 +41,27 @@ static Resource* ResourceCacheGetResource(const String& type, const String& name
     return ptr->GetResource(type, name);
 }
 
+static bool ResourceCacheBackgroundLoadResource(const String& type, const String& name, bool sendEventOnFailure, ResourceCache* ptr)
+{
+    return ptr->BackgroundLoadResource(type, name, sendEventOnFailure);
+}
+
+static bool ResourceCacheSaveManifest(File* file, ResourceCache* ptr)
+{
+    if (file)
+        return ptr->SaveManifest(*file);
+    else
+        return false;
+}
+
+static bool ResourceCacheSaveMemoryReport(File* file, bool csv, ResourceCache* ptr)
+{
+    if (file)
+        return ptr->SaveMemoryReport(*file, csv);
+    else
+        return false;
+}
+
 static File* ResourceCacheGetFile(const String& name, ResourceCache* ptr)
 {
     SharedPtr<File> file = ptr->GetFile(name);
@@ -81,6 +102,16 @@ static unsigned ResourceCacheGetMemoryUse(const String& type, ResourceCache* ptr
     return ptr->GetMemoryUse(type);
 }
 
+static unsigned ResourceCacheGetGPUMemoryUse(const String& type, ResourceCache* ptr)
+{
+    return ptr->GetGPUMemoryUse(type);
+}
+
+static unsigned ResourceCacheGetNumUnusedResources(const String& type, ResourceCache* ptr)
+{
+    return ptr->GetNumUnusedResources(type);
+}
+
 static ResourceCache* GetResourceCache()
 {
     return GetScriptContext()->GetSubsystem<ResourceCache>();
@@ -96,6 +127,43 @@ static CScriptArray* ResourceCacheGetPackageFiles(ResourceCache* ptr)
     return VectorToHandleArray<PackageFile>(ptr->GetPackageFiles(), "Array<PackageFile@>");
 }
 
+static Vector<String> ResourceCacheArrayToNames(CScriptArray* arr)
+{
+    Vector<String> names;
+    if (arr)
+    {
+        for (unsigned i = 0; i < arr->GetSize(); ++i)
+            names.Push(*static_cast<String*>(arr->At(i)));
+    }
+    return names;
+}
+
+static unsigned ResourceCacheReloadChangedFiles(CScriptArray* fileNames, ResourceCache* ptr)
+{
+    return ptr->ReloadChangedFiles(ResourceCacheArrayToNames(fileNames));
+}
+
+static CScriptArray* ResourceCacheGetDependencies(const String& name, ResourceCache* ptr)
+{
+    Vector<String> result;
+    ptr->GetDependencies(name, result);
+    return VectorToArray<String>(result, "Array<String>");
+}
+
+static CScriptArray* ResourceCacheGetDependents(const String& name, ResourceCache* ptr)
+{
+    Vector<String> result;
+    ptr->GetDependents(name, result);
+    return VectorToArray<String>(result, "Array<String>");
+}
+
+static CScriptArray* ResourceCacheGetReloadOrder(CScriptArray* fileNames, ResourceCache* ptr)
+{
+    Vector<String> result;
+    ptr->GetReloadOrder(ResourceCacheArrayToNames(fileNames), result);
+    return VectorToArray<String>(result, "Array<String>");
+}
+
 static void RegisterResourceCache(asIScriptEngine* engine)
 {
     RegisterObject<ResourceCache>(engine, "ResourceCache");
@@ -110,22 +178,41 @@ static void RegisterResourceCache(asIScriptEngine* engine)
     engine->RegisterObjectMethod("ResourceCache", "void ReleaseResources(const String&in, const String&in, bool force = false)", asFUNCTION(ResourceCacheReleaseResourcesPartial), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("ResourceCache", "void ReleaseAllResources(bool force = false)", asMETHOD(ResourceCache, ReleaseAllResources), asCALL_THISCALL);
     engine->RegisterObjectMethod("ResourceCache", "bool ReloadResource(Resource@+)", asMETHOD(ResourceCache, ReloadResource), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "uint ReloadChangedFiles(Array<String>@+)", asFUNCTION(ResourceCacheReloadChangedFiles), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("ResourceCache", "bool Exists(const String&in) const", asMETHODPR(ResourceCache, Exists, (const String&) const, bool), asCALL_THISCALL);
     engine->RegisterObjectMethod("ResourceCache", "File@ GetFile(const String&in)", asFUNCTION(ResourceCacheGetFile), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("ResourceCache", "String GetPreferredResourceDir(const String&in) const", asMETHOD(ResourceCache, GetPreferredResourceDir), asCALL_THISCALL);
     engine->RegisterObjectMethod("ResourceCache", "String SanitateResourceName(const String&in) const", asMETHOD(ResourceCache, SanitateResourceName), asCALL_THISCALL);
     engine->RegisterObjectMethod("ResourceCache", "const String& GetResourceName(StringHash) const", asMETHOD(ResourceCache, GetResourceName), asCALL_THISCALL);
     engine->RegisterObjectMethod("ResourceCache", "String GetResourceFileName(const String&in) const", asMETHOD(ResourceCache, GetResourceFileName), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "Array<String>@ GetDependencies(const String&in) const", asFUNCTION(ResourceCacheGetDependencies), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("ResourceCache", "Array<String>@ GetDependents(const String&in) const", asFUNCTION(ResourceCacheGetDependents), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("ResourceCache", "Array<String>@ GetReloadOrder(Array<String>@+) const", asFUNCTION(ResourceCacheGetReloadOrder), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("ResourceCache", "Resource@+ GetResource(const String&in, const String&in)", asFUNCTION(ResourceCacheGetResource), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("ResourceCache", "Resource@+ GetResource(ShortStringHash, StringHash)", asMETHODPR(ResourceCache, GetResource, (ShortStringHash, StringHash), Resource*), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "bool BackgroundLoadResource(const String&in, const String&in, bool sendEventOnFailure = true)", asFUNCTION(ResourceCacheBackgroundLoadResource), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("ResourceCache", "void set_memoryBudget(const String&in, uint)", asFUNCTION(ResourceCacheSetMemoryBudget), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("ResourceCache", "uint get_memoryBudget(const String&in) const", asFUNCTION(ResourceCacheGetMemoryBudget), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("ResourceCache", "uint get_memoryUse(const String&in) const", asFUNCTION(ResourceCacheGetMemoryUse), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("ResourceCache", "uint get_totalMemoryUse() const", asMETHOD(ResourceCache, GetTotalMemoryUse), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "uint get_gpuMemoryUse(const String&in) const", asFUNCTION(ResourceCacheGetGPUMemoryUse), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("ResourceCache", "uint get_totalGPUMemoryUse() const", asMETHOD(ResourceCache, GetTotalGPUMemoryUse), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "uint get_numUnusedResources(const String&in) const", asFUNCTION(ResourceCacheGetNumUnusedResources), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("ResourceCache", "Array<String>@ get_resourceDirs() const", asFUNCTION(ResourceCacheGetResourceDirs), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("ResourceCache", "Array<PackageFile@>@ get_packageFiles() const", asFUNCTION(ResourceCacheGetPackageFiles), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("ResourceCache", "void set_autoReloadResources(bool)", asMETHOD(ResourceCache, SetAutoReloadResources), asCALL_THISCALL);
     engine->RegisterObjectMethod("ResourceCache", "bool get_autoReloadResources() const", asMETHOD(ResourceCache, GetAutoReloadResources), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "void set_autoReloadDelay(float)", asMETHOD(ResourceCache, SetAutoReloadDelay), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "float get_autoReloadDelay() const", asMETHOD(ResourceCache, GetAutoReloadDelay), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "void set_finishBackgroundResourcesMs(int)", asMETHOD(ResourceCache, SetFinishBackgroundResourcesMs), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "int get_finishBackgroundResourcesMs() const", asMETHOD(ResourceCache, GetFinishBackgroundResourcesMs), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "uint get_numBackgroundLoadResources() const", asMETHOD(ResourceCache, GetNumBackgroundLoadResources), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "void ClearManifest()", asMETHOD(ResourceCache, ClearManifest), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "bool SaveManifest(File@+)", asFUNCTION(ResourceCacheSaveManifest), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("ResourceCache", "bool SaveMemoryReport(File@+, bool csv = false)", asFUNCTION(ResourceCacheSaveMemoryReport), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("ResourceCache", "void set_recordManifest(bool)", asMETHOD(ResourceCache, SetRecordManifest), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "bool get_recordManifest() const", asMETHOD(ResourceCache, GetRecordManifest), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "uint get_numManifestResources() const", asMETHOD(ResourceCache, GetNumManifestResources), asCALL_THISCALL);
     engine->RegisterGlobalFunction("ResourceCache@+ get_resourceCache()", asFUNCTION(GetResourceCache), asCALL_CDECL);
     engine->RegisterGlobalFunction("ResourceCache@+ get_cache()", asFUNCTION(GetResourceCache), asCALL_CDECL);
 }
@@ -310,11 +397,19 @@ static XMLElement XMLFileGetRootDefault(XMLFile* ptr)
     return ptr->GetRoot();
 }
 
+static unsigned ResourceCachePreloadManifest(XMLFile* manifest, ResourceCache* ptr)
+{
+    return ptr->PreloadManifest(manifest);
+}
+
 static void RegisterXMLFile(asIScriptEngine* engine)
 {
     engine->RegisterObjectMethod("XMLFile", "XMLElement CreateRoot(const String&in)", asMETHOD(XMLFile, CreateRoot), asCALL_THISCALL);
     engine->RegisterObjectMethod("XMLFile", "XMLElement GetRoot(const String&in name = String())", asMETHOD(XMLFile, GetRoot), asCALL_THISCALL);
     engine->RegisterObjectMethod("XMLFile", "XMLElement get_root()", asFUNCTION(XMLFileGetRootDefault), asCALL_CDECL_OBJLAST);
+
+    // Register ResourceCache functions that need the XMLFile type
+    engine->RegisterObjectMethod("ResourceCache", "uint PreloadManifest(XMLFile@+)", asFUNCTION(ResourceCachePreloadManifest), asCALL_CDECL_OBJLAST);
 }
 
 void RegisterResourceAPI(asIScriptEngine* engine)
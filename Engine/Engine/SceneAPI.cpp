@@ -23,8 +23,10 @@
 #include "Precompiled.h"
 #include "APITemplates.h"
 #include "PackageFile.h"
+#include "Prefab.h"
 #include "Scene.h"
 #include "SmoothedTransform.h"
+#include "WorldPartition.h"
 #include "Sort.h"
 
 namespace Urho3D
@@ -63,6 +65,8 @@ static void RegisterNode(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Node", "void SetEnabled(bool, bool)", asMETHODPR(Node, SetEnabled, (bool, bool), void), asCALL_THISCALL);
     engine->RegisterObjectMethod("Node", "void set_enabled(bool)", asMETHODPR(Node, SetEnabled, (bool), void), asCALL_THISCALL);
     engine->RegisterObjectMethod("Node", "bool get_enabled() const", asMETHOD(Node, IsEnabled), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Node", "void set_temporary(bool)", asMETHOD(Node, SetTemporary), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Node", "bool get_temporary() const", asMETHOD(Node, IsTemporary), asCALL_THISCALL);
     engine->RegisterObjectMethod("Node", "bool SaveXML(File@+)", asFUNCTION(NodeSaveXML), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Node", "Node@+ Clone(CreateMode mode = REPLICATED)", asMETHOD(Node, Clone), asCALL_THISCALL);
     RegisterObjectConstructor<Node>(engine, "Node");
@@ -93,6 +97,14 @@ static bool SceneSaveXML(File* file, Scene* ptr)
         return false;
 }
 
+static bool SceneSavePacked(File* file, bool compress, Scene* ptr)
+{
+    if (file)
+        return ptr->SavePacked(*file, compress);
+    else
+        return false;
+}
+
 static Node* SceneInstantiate(File* file, const Vector3& position, const Quaternion& rotation, CreateMode mode, Scene* ptr)
 {
     if (file)
@@ -117,6 +129,30 @@ static Node* SceneInstantiateXMLFile(XMLFile* xml, const Vector3& position, cons
         return 0;
 }
 
+static CScriptArray* SceneInstantiatePrefabs(Prefab* prefab, unsigned count, const Vector3& position, const Quaternion& rotation, CreateMode mode, Scene* ptr)
+{
+    PODVector<Node*> nodes;
+    ptr->InstantiatePrefab(nodes, prefab, count, position, rotation, mode);
+    return VectorToHandleArray<Node>(nodes, "Array<Node@>");
+}
+
+static CScriptArray* SceneGetComponentsOfType(const String& typeName, Scene* ptr)
+{
+    return VectorToHandleArray<Component>(ptr->GetComponentsOfType(ShortStringHash(typeName)), "Array<Component@>");
+}
+
+static unsigned SceneGetJournalHash(Scene* ptr)
+{
+    AttributeJournal* journal = ptr->GetJournal();
+    return journal ? journal->GetHash() : 0;
+}
+
+static unsigned SceneGetJournalNetworkHash(Scene* ptr)
+{
+    AttributeJournal* journal = ptr->GetJournal();
+    return journal ? journal->GetNetworkHash() : 0;
+}
+
 static CScriptArray* SceneGetRequiredPackageFiles(Scene* ptr)
 {
     return VectorToHandleArray<PackageFile>(ptr->GetRequiredPackageFiles(), "Array<PackageFile@>");
@@ -168,6 +204,46 @@ static void RegisterSmoothedTransform(asIScriptEngine* engine)
     engine->RegisterObjectMethod("SmoothedTransform", "bool get_inProgress() const", asMETHOD(SmoothedTransform, IsInProgress), asCALL_THISCALL);
 }
 
+static void RegisterWorldPartition(asIScriptEngine* engine)
+{
+    RegisterComponent<WorldPartition>(engine, "WorldPartition", true, false);
+    engine->RegisterObjectMethod("WorldPartition", "void Update()", asMETHOD(WorldPartition, Update), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "void FinishLoading()", asMETHOD(WorldPartition, FinishLoading), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "void UnloadAllCells()", asMETHOD(WorldPartition, UnloadAllCells), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "void AddFocus(Node@+)", asMETHOD(WorldPartition, AddFocus), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "void RemoveFocus(Node@+)", asMETHOD(WorldPartition, RemoveFocus), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "void RemoveAllFocus()", asMETHOD(WorldPartition, RemoveAllFocus), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "IntVector2 GetCellCoords(const Vector3&in) const", asMETHOD(WorldPartition, GetCellCoords), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "Node@+ GetCellNode(int, int) const", asMETHOD(WorldPartition, GetCellNode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "String GetCellFileName(int, int) const", asMETHOD(WorldPartition, GetCellFileName), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "void set_cellSize(float)", asMETHOD(WorldPartition, SetCellSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "float get_cellSize() const", asMETHOD(WorldPartition, GetCellSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "void set_loadDistance(float)", asMETHOD(WorldPartition, SetLoadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "float get_loadDistance() const", asMETHOD(WorldPartition, GetLoadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "void set_unloadDistance(float)", asMETHOD(WorldPartition, SetUnloadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "float get_unloadDistance() const", asMETHOD(WorldPartition, GetUnloadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "void set_cellPath(const String&in)", asMETHOD(WorldPartition, SetCellPath), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "const String& get_cellPath() const", asMETHOD(WorldPartition, GetCellPath), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "void set_cellExtension(const String&in)", asMETHOD(WorldPartition, SetCellExtension), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "const String& get_cellExtension() const", asMETHOD(WorldPartition, GetCellExtension), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "void set_maxLoadTime(int)", asMETHOD(WorldPartition, SetMaxLoadTime), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "int get_maxLoadTime() const", asMETHOD(WorldPartition, GetMaxLoadTime), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "void set_releaseResources(bool)", asMETHOD(WorldPartition, SetReleaseResources), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "bool get_releaseResources() const", asMETHOD(WorldPartition, GetReleaseResources), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "uint get_numFocusNodes() const", asMETHOD(WorldPartition, GetNumFocusNodes), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "uint get_numLoadedCells() const", asMETHOD(WorldPartition, GetNumLoadedCells), asCALL_THISCALL);
+    engine->RegisterObjectMethod("WorldPartition", "bool get_loading() const", asMETHOD(WorldPartition, IsLoading), asCALL_THISCALL);
+}
+
+static void RegisterPrefab(asIScriptEngine* engine)
+{
+    RegisterResource<Prefab>(engine, "Prefab");
+    engine->RegisterObjectMethod("Prefab", "bool Define(Node@+)", asMETHOD(Prefab, Define), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Prefab", "bool get_defined() const", asMETHOD(Prefab, IsDefined), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Prefab", "uint get_numNodes() const", asMETHOD(Prefab, GetNumNodes), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Prefab", "uint get_numComponents() const", asMETHOD(Prefab, GetNumComponents), asCALL_THISCALL);
+}
+
 static void RegisterScene(asIScriptEngine* engine)
 {
     engine->RegisterGlobalProperty("const uint FIRST_REPLICATED_ID", (void*)&FIRST_REPLICATED_ID);
@@ -180,13 +256,16 @@ static void RegisterScene(asIScriptEngine* engine)
     RegisterNamedObjectConstructor<Scene>(engine, "Scene");
     engine->RegisterObjectMethod("Scene", "bool LoadXML(File@+)", asFUNCTION(SceneLoadXML), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Scene", "bool SaveXML(File@+)", asFUNCTION(SceneSaveXML), asCALL_CDECL_OBJLAST);
-    engine->RegisterObjectMethod("Scene", "bool LoadAsync(File@+)", asMETHOD(Scene, LoadAsync), asCALL_THISCALL);
-    engine->RegisterObjectMethod("Scene", "bool LoadAsyncXML(File@+)", asMETHOD(Scene, LoadAsyncXML), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "bool SavePacked(File@+, bool compress = true)", asFUNCTION(SceneSavePacked), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("Scene", "bool LoadAsync(File@+, XMLFile@+ manifest = null)", asMETHOD(Scene, LoadAsync), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "bool LoadAsyncXML(File@+, XMLFile@+ manifest = null)", asMETHOD(Scene, LoadAsyncXML), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void StopAsyncLoading()", asMETHOD(Scene, StopAsyncLoading), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "Node@+ Instantiate(File@+, const Vector3&in, const Quaternion&in, CreateMode mode = REPLICATED)", asFUNCTION(SceneInstantiate), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Scene", "Node@+ InstantiateXML(File@+, const Vector3&in, const Quaternion&in, CreateMode mode = REPLICATED)", asFUNCTION(SceneInstantiateXML), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Scene", "Node@+ InstantiateXML(XMLFile@+, const Vector3&in, const Quaternion&in, CreateMode mode = REPLICATED)", asFUNCTION(SceneInstantiateXMLFile), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Scene", "Node@+ InstantiateXML(const XMLElement&in, const Vector3&in, const Quaternion&in, CreateMode mode = REPLICATED)", asMETHODPR(Scene, InstantiateXML, (const XMLElement&, const Vector3&, const Quaternion&, CreateMode), Node*), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "Node@+ InstantiatePrefab(Prefab@+, const Vector3&in, const Quaternion&in, CreateMode mode = REPLICATED)", asMETHODPR(Scene, InstantiatePrefab, (Prefab*, const Vector3&, const Quaternion&, CreateMode), Node*), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "Array<Node@>@ InstantiatePrefab(Prefab@+, uint, const Vector3&in, const Quaternion&in, CreateMode mode = REPLICATED)", asFUNCTION(SceneInstantiatePrefabs), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Scene", "void Clear()", asMETHOD(Scene, Clear), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void AddRequiredPackageFile(PackageFile@+)", asMETHOD(Scene, AddRequiredPackageFile), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void ClearRequiredPackageFiles()", asMETHOD(Scene, ClearRequiredPackageFiles), asCALL_THISCALL);
@@ -195,8 +274,10 @@ static void RegisterScene(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Scene", "void UnregisterAllVars(const String&in)", asMETHOD(Scene, UnregisterAllVars), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "Component@+ GetComponent(uint)", asMETHODPR(Scene, GetComponent, (unsigned) const, Component*), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "Node@+ GetNode(uint)", asMETHOD(Scene, GetNode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "Array<Component@>@ GetComponentsOfType(const String&in) const", asFUNCTION(SceneGetComponentsOfType), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Scene", "const String& GetVarName(ShortStringHash) const", asMETHOD(Scene, GetVarName), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void Update(float)", asMETHOD(Scene, Update), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void UpdateTransforms()", asMETHOD(Scene, UpdateTransforms), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_updateEnabled(bool)", asMETHOD(Scene, SetUpdateEnabled), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "bool get_updateEnabled() const", asMETHOD(Scene, IsUpdateEnabled), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_timeScale(float)", asMETHOD(Scene, SetTimeScale), asCALL_THISCALL);
@@ -207,6 +288,21 @@ static void RegisterScene(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Scene", "float get_smoothingConstant() const", asMETHOD(Scene, GetSmoothingConstant), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_snapThreshold(float)", asMETHOD(Scene, SetSnapThreshold), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "float get_snapThreshold() const", asMETHOD(Scene, GetSnapThreshold), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_transformBatching(bool)", asMETHOD(Scene, SetTransformBatching), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "bool get_transformBatching() const", asMETHOD(Scene, GetTransformBatching), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_fixedUpdateFps(int)", asMETHOD(Scene, SetFixedUpdateFps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "int get_fixedUpdateFps() const", asMETHOD(Scene, GetFixedUpdateFps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_maxFixedSteps(int)", asMETHOD(Scene, SetMaxFixedSteps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "int get_maxFixedSteps() const", asMETHOD(Scene, GetMaxFixedSteps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_updateBudget(int)", asMETHOD(Scene, SetUpdateBudget), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "int get_updateBudget() const", asMETHOD(Scene, GetUpdateBudget), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "float get_fixedUpdateAlpha() const", asMETHOD(Scene, GetFixedUpdateAlpha), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "uint get_fixedTick() const", asMETHOD(Scene, GetFixedTick), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "uint get_numDroppedFixedSteps() const", asMETHOD(Scene, GetNumDroppedFixedSteps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_journalSize(uint)", asMETHOD(Scene, SetJournalSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "uint get_journalSize() const", asMETHOD(Scene, GetJournalSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "uint get_journalHash() const", asFUNCTION(SceneGetJournalHash), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("Scene", "uint get_journalNetworkHash() const", asFUNCTION(SceneGetJournalNetworkHash), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Scene", "bool get_asyncLoading() const", asMETHOD(Scene, IsAsyncLoading), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "float get_asyncProgress() const", asMETHOD(Scene, GetAsyncProgress), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "uint get_checksum() const", asMETHOD(Scene, GetChecksum), asCALL_THISCALL);
@@ -227,6 +323,8 @@ void RegisterSceneAPI(asIScriptEngine* engine)
     RegisterSerializable(engine);
     RegisterNode(engine);
     RegisterSmoothedTransform(engine);
+    RegisterWorldPartition(engine);
+    RegisterPrefab(engine);
     RegisterScene(engine);
 }
 
@@ -75,7 +75,7 @@ void Animation::RegisterObject(Context* context)
     context->RegisterFactory<Animation>();
 }
 
-bool Animation::Load(Deserializer& source)
+bool Animation::BeginLoad(Deserializer& source)
 {
     PROFILE(LoadAnimation);
     
@@ -124,6 +124,23 @@ bool Animation::Load(Deserializer& source)
         }
     }
     
+    // If loading in the background, queue also the triggers XML file for background loading
+    if (GetAsyncLoadState() == ASYNC_LOADING)
+    {
+        ResourceCache* cache = GetSubsystem<ResourceCache>();
+        String xmlName = ReplaceExtension(GetName(), ".xml");
+        if (cache->Exists(xmlName))
+            cache->BackgroundLoadResource<XMLFile>(xmlName, false, this);
+    }
+    
+    SetMemoryUse(memoryUse);
+    return true;
+}
+
+bool Animation::EndLoad()
+{
+    unsigned memoryUse = GetMemoryUse();
+    
     // Optionally read triggers from an XML file
     ResourceCache* cache = GetSubsystem<ResourceCache>();
     String xmlName = ReplaceExtension(GetName(), ".xml");
@@ -25,6 +25,7 @@
 #include "RenderSurface.h"
 #include "Ptr.h"
 #include "Texture.h"
+#include "TextureStreaming.h"
 
 namespace Urho3D
 {
@@ -44,8 +45,12 @@ public:
     /// Register object factory.
     static void RegisterObject(Context* context);
     
-    /// Load resource. Return true if successful.
-    virtual bool Load(Deserializer& source);
+    using Resource::Load;
+    
+    /// Load resource from stream. May be called from a worker thread. Return true if successful.
+    virtual bool BeginLoad(Deserializer& source);
+    /// Finish resource loading. Always called from the main thread. Return true if successful.
+    virtual bool EndLoad();
     /// Release default pool resources.
     virtual void OnDeviceLost();
     /// Recreate default pool resources.
@@ -59,11 +64,19 @@ public:
     bool SetData(unsigned level, int x, int y, int width, int height, const void* data);
     /// Load from an image. Return true if successful.
     bool Load(SharedPtr<Image> image, bool useAlpha = false);
+    /// Upload the mip levels of the streaming image starting from a level, clamped to the streamable range. Return true if successful.
+    bool SetStreamingLevel(unsigned level);
     
     /// Get data from a mip level. The destination buffer must be big enough. Return true if successful.
     bool GetData(unsigned level, void* dest) const;
     /// Return render surface.
     RenderSurface* GetRenderSurface() const { return renderSurface_; }
+    /// Return whether mip levels are streamed from a retained compressed image.
+    bool IsStreaming() const { return streamingImage_.NotNull(); }
+    /// Return the highest resolution mip level currently uploaded from the streaming image.
+    unsigned GetStreamingLevel() const { return streamingLevel_; }
+    /// Return mip streaming state.
+    TextureStreamingInfo& GetStreamingInfo() { return streamingInfo_; }
     
 private:
     /// Create texture.
@@ -73,6 +86,14 @@ private:
     
     /// Render surface.
     SharedPtr<RenderSurface> renderSurface_;
+    /// Image loaded in BeginLoad(), to be uploaded in EndLoad().
+    SharedPtr<Image> loadImage_;
+    /// Compressed image retained for mip streaming.
+    SharedPtr<Image> streamingImage_;
+    /// Mip streaming state.
+    TextureStreamingInfo streamingInfo_;
+    /// Highest resolution mip level uploaded from the streaming image.
+    unsigned streamingLevel_;
 };
 
 }
@@ -122,7 +122,7 @@ void Material::RegisterObject(Context* context)
     context->RegisterFactory<Material>();
 }
 
-bool Material::Load(Deserializer& source)
+bool Material::BeginLoad(Deserializer& source)
 {
     PROFILE(LoadMaterial);
     
@@ -131,15 +131,53 @@ bool Material::Load(Deserializer& source)
     if (!graphics)
         return true;
     
+    loadXMLFile_ = new XMLFile(context_);
+    if (!loadXMLFile_->Load(source))
+    {
+        loadXMLFile_.Reset();
+        return false;
+    }
+    
+    // If loading in the background, queue also the techniques and textures for background loading. The material
+    // will be finished only after them
+    if (GetAsyncLoadState() == ASYNC_LOADING)
+    {
+        ResourceCache* cache = GetSubsystem<ResourceCache>();
+        XMLElement rootElem = loadXMLFile_->GetRoot();
+        
+        XMLElement techniqueElem = rootElem.GetChild("technique");
+        while (techniqueElem)
+        {
+            cache->BackgroundLoadResource<Technique>(techniqueElem.GetAttribute("name"), true, this);
+            techniqueElem = techniqueElem.GetNext("technique");
+        }
+        
+        XMLElement textureElem = rootElem.GetChild("texture");
+        while (textureElem)
+        {
+            String name = textureElem.GetAttribute("name");
+            if (GetExtension(name) == ".xml")
+                cache->BackgroundLoadResource<TextureCube>(name, true, this);
+            else
+                cache->BackgroundLoadResource<Texture2D>(name, true, this);
+            textureElem = textureElem.GetNext("texture");
+        }
+    }
+    
+    return true;
+}
+
+bool Material::EndLoad()
+{
+    // In headless mode, do not actually load the material, just return success
+    if (!loadXMLFile_)
+        return true;
+    
     ResetToDefaults();
     
     ResourceCache* cache = GetSubsystem<ResourceCache>();
     
-    SharedPtr<XMLFile> xml(new XMLFile(context_));
-    if (!xml->Load(source))
-        return false;
-    
-    XMLElement rootElem = xml->GetRoot();
+    XMLElement rootElem = loadXMLFile_->GetRoot();
     XMLElement techniqueElem = rootElem.GetChild("technique");
     techniques_.Clear();
     while (techniqueElem)
@@ -217,6 +255,8 @@ bool Material::Load(Deserializer& source)
     
     SetMemoryUse(memoryUse);
     CheckOcclusion();
+    
+    loadXMLFile_.Reset();
     return true;
 }
 
@@ -35,6 +35,7 @@ class Technique;
 class Texture;
 class Texture2D;
 class TextureCube;
+class XMLFile;
 
 /// %Material's shader parameter definition.
 struct MaterialShaderParameter
@@ -76,8 +77,10 @@ public:
     /// Register object factory.
     static void RegisterObject(Context* context);
     
-    /// Load resource. Return true if successful.
-    virtual bool Load(Deserializer& source);
+    /// Load resource from stream. May be called from a worker thread. Return true if successful.
+    virtual bool BeginLoad(Deserializer& source);
+    /// Finish resource loading. Always called from the main thread. Return true if successful.
+    virtual bool EndLoad();
     /// Save resource. Return true if successful.
     virtual bool Save(Serializer& dest) const;
     
@@ -160,6 +163,8 @@ private:
     CullMode shadowCullMode_;
     /// Depth bias parameters.
     BiasParameters depthBias_;
+    /// XML file loaded in BeginLoad(), to be parsed in EndLoad().
+    SharedPtr<XMLFile> loadXMLFile_;
     /// Last auxiliary view rendered frame number.
     unsigned auxViewFrameNumber_;
     /// Render occlusion flag.
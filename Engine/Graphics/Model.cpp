@@ -75,7 +75,7 @@ void Model::RegisterObject(Context* context)
     context->RegisterFactory<Model>();
 }
 
-bool Model::Load(Deserializer& source)
+bool Model::BeginLoad(Deserializer& source)
 {
     PROFILE(LoadModel);
     
@@ -95,54 +95,44 @@ bool Model::Load(Deserializer& source)
     
     unsigned memoryUse = sizeof(Model);
     
-    // Read vertex buffers
+    // Read vertex buffers. The GPU buffers are created in EndLoad()
     unsigned numVertexBuffers = source.ReadUInt();
-    vertexBuffers_.Reserve(numVertexBuffers);
+    loadVBData_.Resize(numVertexBuffers);
     morphRangeStarts_.Resize(numVertexBuffers);
     morphRangeCounts_.Resize(numVertexBuffers);
     for (unsigned i = 0; i < numVertexBuffers; ++i)
     {
-        unsigned vertexCount = source.ReadUInt();
-        unsigned elementMask = source.ReadUInt();
+        VertexBufferDesc& desc = loadVBData_[i];
+        desc.vertexCount_ = source.ReadUInt();
+        desc.elementMask_ = source.ReadUInt();
         morphRangeStarts_[i] = source.ReadUInt();
         morphRangeCounts_[i] = source.ReadUInt();
         
-        SharedPtr<VertexBuffer> buffer(new VertexBuffer(context_));
-        buffer->SetShadowed(true);
-        buffer->SetSize(vertexCount, elementMask);
-        
-        void* dest = buffer->Lock(0, vertexCount);
-        unsigned vertexSize = buffer->GetVertexSize();
-        source.Read(dest, vertexCount * vertexSize);
-        buffer->Unlock();
+        unsigned vertexSize = VertexBuffer::GetVertexSize(desc.elementMask_);
+        desc.data_ = new unsigned char[desc.vertexCount_ * vertexSize];
+        source.Read(desc.data_.Get(), desc.vertexCount_ * vertexSize);
         
-        memoryUse += sizeof(VertexBuffer) + vertexCount * vertexSize;
-        vertexBuffers_.Push(buffer);
+        memoryUse += sizeof(VertexBuffer) + desc.vertexCount_ * vertexSize;
     }
 
     // Read index buffers
     unsigned numIndexBuffers = source.ReadUInt();
-    indexBuffers_.Reserve(numIndexBuffers);
+    loadIBData_.Resize(numIndexBuffers);
     for (unsigned i = 0; i < numIndexBuffers; ++i)
     {
-        unsigned indexCount = source.ReadUInt();
-        unsigned indexSize = source.ReadUInt();
+        IndexBufferDesc& desc = loadIBData_[i];
+        desc.indexCount_ = source.ReadUInt();
+        desc.indexSize_ = source.ReadUInt();
         
-        SharedPtr<IndexBuffer> buffer(new IndexBuffer(context_));
-        buffer->SetShadowed(true);
-        buffer->SetSize(indexCount, indexSize > sizeof(unsigned short));
+        desc.data_ = new unsigned char[desc.indexCount_ * desc.indexSize_];
+        source.Read(desc.data_.Get(), desc.indexCount_ * desc.indexSize_);
         
-        void* dest = buffer->Lock(0, indexCount);
-        source.Read(dest, indexCount * indexSize);
-        buffer->Unlock();
-        
-        memoryUse += sizeof(IndexBuffer) + indexCount * indexSize;
-        indexBuffers_.Push(buffer);
+        memoryUse += sizeof(IndexBuffer) + desc.indexCount_ * desc.indexSize_;
     }
     
     // Read geometries
     unsigned numGeometries = source.ReadUInt();
-    geometries_.Reserve(numGeometries);
+    loadGeometries_.Resize(numGeometries);
     geometryBoneMappings_.Reserve(numGeometries);
     geometryCenters_.Reserve(numGeometries);
     for (unsigned i = 0; i < numGeometries; ++i)
@@ -155,41 +145,38 @@ bool Model::Load(Deserializer& source)
         geometryBoneMappings_.Push(boneMapping);
         
         unsigned numLodLevels = source.ReadUInt();
-        Vector<SharedPtr<Geometry> > geometryLodLevels;
-        geometryLodLevels.Reserve(numLodLevels);
+        loadGeometries_[i].Resize(numLodLevels);
         
         for (unsigned j = 0; j < numLodLevels; ++j)
         {
-            float distance = source.ReadFloat();
-            PrimitiveType type = (PrimitiveType)source.ReadUInt();
+            GeometryDesc& desc = loadGeometries_[i][j];
+            desc.lodDistance_ = source.ReadFloat();
+            desc.type_ = (PrimitiveType)source.ReadUInt();
             
-            unsigned vertexBufferRef = source.ReadUInt();
-            unsigned indexBufferRef = source.ReadUInt();
-            unsigned indexStart = source.ReadUInt();
-            unsigned indexCount = source.ReadUInt();
+            desc.vbRef_ = source.ReadUInt();
+            desc.ibRef_ = source.ReadUInt();
+            desc.indexStart_ = source.ReadUInt();
+            desc.indexCount_ = source.ReadUInt();
             
-            if (vertexBufferRef >= vertexBuffers_.Size())
+            if (desc.vbRef_ >= numVertexBuffers)
             {
                 LOGERROR("Vertex buffer index out of bounds");
+                loadVBData_.Clear();
+                loadIBData_.Clear();
+                loadGeometries_.Clear();
                 return false;
             }
-            if (indexBufferRef >= indexBuffers_.Size())
+            if (desc.ibRef_ >= numIndexBuffers)
             {
                 LOGERROR("Index buffer index out of bounds");
+                loadVBData_.Clear();
+                loadIBData_.Clear();
+                loadGeometries_.Clear();
                 return false;
             }
             
-            SharedPtr<Geometry> geometry(new Geometry(context_));
-            geometry->SetVertexBuffer(0, vertexBuffers_[vertexBufferRef]);
-            geometry->SetIndexBuffer(indexBuffers_[indexBufferRef]);
-            geometry->SetDrawRange(type, indexStart, indexCount);
-            geometry->SetLodDistance(distance);
-            
-            geometryLodLevels.Push(geometry);
             memoryUse += sizeof(Geometry);
         }
-        
-        geometries_.Push(geometryLodLevels);
     }
     
     // Read morphs
@@ -241,16 +228,79 @@ bool Model::Load(Deserializer& source)
     boundingBox_ = source.ReadBoundingBox();
     
     // Read geometry centers
-    for (unsigned i = 0; i < geometries_.Size() && !source.IsEof(); ++i)
+    for (unsigned i = 0; i < numGeometries && !source.IsEof(); ++i)
         geometryCenters_.Push(source.ReadVector3());
-    while (geometryCenters_.Size() < geometries_.Size())
+    while (geometryCenters_.Size() < numGeometries)
         geometryCenters_.Push(Vector3::ZERO);
-    memoryUse += sizeof(Vector3) * geometries_.Size();
+    memoryUse += sizeof(Vector3) * numGeometries;
     
     SetMemoryUse(memoryUse);
     return true;
 }
 
+bool Model::EndLoad()
+{
+    // The shadow copies were already counted in BeginLoad(); count the uploaded buffers separately as GPU memory
+    unsigned gpuMemoryUse = 0;
+    
+    // Upload vertex buffer data
+    vertexBuffers_.Reserve(loadVBData_.Size());
+    for (unsigned i = 0; i < loadVBData_.Size(); ++i)
+    {
+        const VertexBufferDesc& desc = loadVBData_[i];
+        SharedPtr<VertexBuffer> buffer(new VertexBuffer(context_));
+        buffer->SetShadowed(true);
+        buffer->SetSize(desc.vertexCount_, desc.elementMask_);
+        buffer->SetData(desc.data_.Get());
+        if (buffer->GetGPUObject())
+            gpuMemoryUse += buffer->GetVertexCount() * buffer->GetVertexSize();
+        vertexBuffers_.Push(buffer);
+    }
+    
+    // Upload index buffer data
+    indexBuffers_.Reserve(loadIBData_.Size());
+    for (unsigned i = 0; i < loadIBData_.Size(); ++i)
+    {
+        const IndexBufferDesc& desc = loadIBData_[i];
+        SharedPtr<IndexBuffer> buffer(new IndexBuffer(context_));
+        buffer->SetShadowed(true);
+        buffer->SetSize(desc.indexCount_, desc.indexSize_ > sizeof(unsigned short));
+        buffer->SetData(desc.data_.Get());
+        if (buffer->GetGPUObject())
+            gpuMemoryUse += buffer->GetIndexCount() * buffer->GetIndexSize();
+        indexBuffers_.Push(buffer);
+    }
+    
+    // Create geometries
+    geometries_.Reserve(loadGeometries_.Size());
+    for (unsigned i = 0; i < loadGeometries_.Size(); ++i)
+    {
+        Vector<SharedPtr<Geometry> > geometryLodLevels;
+        geometryLodLevels.Reserve(loadGeometries_[i].Size());
+        
+        for (unsigned j = 0; j < loadGeometries_[i].Size(); ++j)
+        {
+            const GeometryDesc& desc = loadGeometries_[i][j];
+            SharedPtr<Geometry> geometry(new Geometry(context_));
+            geometry->SetVertexBuffer(0, vertexBuffers_[desc.vbRef_]);
+            geometry->SetIndexBuffer(indexBuffers_[desc.ibRef_]);
+            geometry->SetDrawRange(desc.type_, desc.indexStart_, desc.indexCount_);
+            geometry->SetLodDistance(desc.lodDistance_);
+            geometryLodLevels.Push(geometry);
+        }
+        
+        geometries_.Push(geometryLodLevels);
+    }
+    
+    loadVBData_.Clear();
+    loadIBData_.Clear();
+    loadGeometries_.Clear();
+    
+    SetMemoryUse(GetMemoryUse() + gpuMemoryUse);
+    SetGPUMemoryUse(gpuMemoryUse);
+    return true;
+}
+
 bool Model::Save(Serializer& dest) const
 {
     // Write ID
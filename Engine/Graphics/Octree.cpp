@@ -392,10 +392,14 @@ void Octree::Resize(const BoundingBox& box, unsigned numLevels)
 
 void Octree::Update(const FrameInfo& frame)
 {
+    // Apply batched transform changes first, so that moved drawables are queued for update
+    Scene* scene = GetScene();
+    if (scene)
+        scene->UpdateTransforms();
+
     UpdateDrawables(frame);
 
     // Notify drawable update being finished. Custom animation (eg. IK) can be done at this point
-    Scene* scene = GetScene();
     if (scene)
     {
         using namespace SceneDrawableUpdateFinished;
@@ -404,6 +408,7 @@ void Octree::Update(const FrameInfo& frame)
         eventData[P_SCENE] = (void*)scene;
         eventData[P_TIMESTEP] = frame.timeStep_;
         scene->SendEvent(E_SCENEDRAWABLEUPDATEFINISHED, eventData);
+        scene->UpdateTransforms();
     }
 
     ReinsertDrawables(frame);
@@ -30,6 +30,7 @@
 #include "Renderer.h"
 #include "ResourceCache.h"
 #include "Texture2D.h"
+#include "WorkQueue.h"
 
 #include "DebugNew.h"
 
@@ -39,7 +40,8 @@ namespace Urho3D
 OBJECTTYPESTATIC(Texture2D);
 
 Texture2D::Texture2D(Context* context) :
-    Texture(context)
+    Texture(context),
+    streamingLevel_(0)
 {
     target_ = GL_TEXTURE_2D;
 }
@@ -54,7 +56,7 @@ void Texture2D::RegisterObject(Context* context)
     context->RegisterFactory<Texture2D>();
 }
 
-bool Texture2D::Load(Deserializer& source)
+bool Texture2D::BeginLoad(Deserializer& source)
 {
     PROFILE(LoadTexture2D);
     
@@ -63,25 +65,60 @@ bool Texture2D::Load(Deserializer& source)
     if (!graphics)
         return true;
     
+    // Load the image data here, the texture is created in EndLoad()
+    loadImage_ = new Image(context_);
+    if (!loadImage_->Load(source))
+    {
+        loadImage_.Reset();
+        return false;
+    }
+    
+    // When loading in the background, generate the mip levels here so that EndLoad() only needs to upload them
+    if (GetAsyncLoadState() == ASYNC_LOADING)
+        loadImage_->PrecalculateLevels();
+    
+    return true;
+}
+
+bool Texture2D::EndLoad()
+{
+    // In headless mode, do not actually load the texture, just return success
+    if (!graphics_ || !loadImage_)
+        return true;
+    
     // If device is lost, retry later
     if (graphics_->IsDeviceLost())
     {
         LOGWARNING("Texture load while device is lost");
         dataPending_ = true;
+        loadImage_.Reset();
         return true;
     }
     
     // If over the texture budget, see if materials can be freed to allow textures to be freed
     CheckTextureBudget(GetTypeStatic());
     
-    SharedPtr<Image> image(new Image(context_));
-    if (!image->Load(source))
-        return false;
-    
     // Before actually loading the texture, get optional parameters from an XML description file
     LoadParameters();
     
-    return Load(image);
+    // With texture streaming, retain the compressed image to upload higher resolution mip levels later, and start from the
+    // lowest resolution resident level
+    streamingImage_.Reset();
+    Renderer* renderer = GetSubsystem<Renderer>();
+    if (renderer && renderer->GetTextureStreaming())
+    {
+        bool decompress = loadImage_->IsCompressed() && !graphics_->GetFormat(loadImage_->GetCompressedFormat());
+        if (streamingInfo_.Define(loadImage_, mipsToSkip_[renderer->GetTextureQuality()], decompress))
+        {
+            streamingImage_ = loadImage_;
+            streamingLevel_ = streamingInfo_.maxLevel_;
+            renderer->AddStreamingTexture(this);
+        }
+    }
+    
+    bool success = Load(loadImage_);
+    loadImage_.Reset();
+    return success;
 }
 
 void Texture2D::OnDeviceLost()
@@ -248,6 +285,10 @@ bool Texture2D::Load(SharedPtr<Image> image, bool useAlpha)
         return false;
     }
     
+    // Loading any other image ends mip streaming
+    if (image != streamingImage_)
+        streamingImage_.Reset();
+    
     unsigned memoryUse = sizeof(Texture2D);
     
     int quality = QUALITY_HIGH;
@@ -323,7 +364,7 @@ bool Texture2D::Load(SharedPtr<Image> image, bool useAlpha)
             needDecompress = true;
         }
         
-        unsigned mipsToSkip = mipsToSkip_[quality];
+        unsigned mipsToSkip = streamingImage_ ? streamingLevel_ : mipsToSkip_[quality];
         if (mipsToSkip >= levels)
             mipsToSkip = levels - 1;
         while (mipsToSkip && (width / (1 << mipsToSkip) < 4 || height / (1 << mipsToSkip) < 4))
@@ -345,7 +386,7 @@ bool Texture2D::Load(SharedPtr<Image> image, bool useAlpha)
             else
             {
                 unsigned char* rgbaData = new unsigned char[level.width_ * level.height_ * 4];
-                level.Decompress(rgbaData);
+                level.Decompress(rgbaData, GetSubsystem<WorkQueue>());
                 SetData(i, 0, 0, level.width_, level.height_, rgbaData);
                 memoryUse += level.width_ * level.height_ * 4;
                 delete[] rgbaData;
@@ -353,10 +394,28 @@ bool Texture2D::Load(SharedPtr<Image> image, bool useAlpha)
         }
     }
     
-    SetMemoryUse(memoryUse);
+    // The retained streaming image counts as CPU memory
+    SetMemoryUse(memoryUse + (streamingImage_ ? streamingImage_->GetMemoryUse() : 0));
+    SetGPUMemoryUse(memoryUse - sizeof(Texture2D));
     return true;
 }
 
+bool Texture2D::SetStreamingLevel(unsigned level)
+{
+    if (!streamingImage_)
+    {
+        LOGERROR("Texture is not streaming, can not set streaming mip level");
+        return false;
+    }
+    
+    level = Clamp((int)level, (int)streamingInfo_.minLevel_, (int)streamingInfo_.maxLevel_);
+    if (level == streamingLevel_ && object_)
+        return true;
+    
+    streamingLevel_ = level;
+    return Load(streamingImage_);
+}
+
 bool Texture2D::GetData(unsigned level, void* dest) const
 {
     #ifndef GL_ES_VERSION_2_0
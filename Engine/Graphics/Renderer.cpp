@@ -40,6 +40,7 @@
 #include "Scene.h"
 #include "Shader.h"
 #include "ShaderVariation.h"
+#include "Sort.h"
 #include "Technique.h"
 #include "Texture2D.h"
 #include "TextureCube.h"
@@ -253,6 +254,11 @@ static const char* lightPSVariations[] =
 static const unsigned INSTANCING_BUFFER_MASK = MASK_INSTANCEMATRIX1 | MASK_INSTANCEMATRIX2 | MASK_INSTANCEMATRIX3;
 static const unsigned MAX_BUFFER_AGE = 2000;
 
+static bool CompareStreamingTextures(Texture2D* lhs, Texture2D* rhs)
+{
+    return lhs->GetStreamingInfo().screenSize_ > rhs->GetStreamingInfo().screenSize_;
+}
+
 OBJECTTYPESTATIC(Renderer);
 
 Renderer::Renderer(Context* context) :
@@ -263,6 +269,9 @@ Renderer::Renderer(Context* context) :
     textureFilterMode_(FILTER_TRILINEAR),
     textureQuality_(QUALITY_HIGH),
     materialQuality_(QUALITY_HIGH),
+    textureStreamingBudget_(0),
+    textureStreamingMemoryUse_(0),
+    maxStreamingUploads_(4),
     shadowMapSize_(1024),
     shadowQuality_(SHADOWQUALITY_HIGH_16BIT),
     maxShadowMaps_(1),
@@ -281,6 +290,7 @@ Renderer::Renderer(Context* context) :
     drawShadows_(true),
     reuseShadowMaps_(true),
     dynamicInstancing_(true),
+    textureStreaming_(false),
     shadersDirty_(true),
     initialized_(false)
 {
@@ -349,6 +359,27 @@ void Renderer::SetTextureQuality(int quality)
     }
 }
 
+void Renderer::SetTextureStreaming(bool enable)
+{
+    if (enable != textureStreaming_)
+    {
+        textureStreaming_ = enable;
+        if (!enable)
+            streamingTextures_.Clear();
+        ReloadTextures();
+    }
+}
+
+void Renderer::SetTextureStreamingBudget(unsigned budget)
+{
+    textureStreamingBudget_ = budget;
+}
+
+void Renderer::SetMaxStreamingUploads(int uploads)
+{
+    maxStreamingUploads_ = Max(uploads, 1);
+}
+
 void Renderer::SetMaterialQuality(int quality)
 {
     materialQuality_ = Clamp(quality, QUALITY_LOW, QUALITY_MAX);
@@ -648,6 +679,10 @@ void Renderer::Update(float timeStep)
     }
     
     queuedViews_.Clear();
+    
+    // The views have now requested the mip levels they need; update the streaming textures
+    if (textureStreaming_)
+        UpdateTextureStreaming();
 }
 
 void Renderer::Render()
@@ -765,6 +800,20 @@ void Renderer::QueueRenderSurface(RenderSurface* renderTarget)
     }
 }
 
+void Renderer::AddStreamingTexture(Texture2D* texture)
+{
+    if (!texture)
+        return;
+    
+    for (unsigned i = 0; i < streamingTextures_.Size(); ++i)
+    {
+        if (streamingTextures_[i] == texture)
+            return;
+    }
+    
+    streamingTextures_.Push(WeakPtr<Texture2D>(texture));
+}
+
 void Renderer::QueueViewport(RenderSurface* renderTarget, Viewport* viewport)
 {
     if (viewport)
@@ -1620,6 +1669,63 @@ void Renderer::ReloadTextures()
         cache_->ReloadResource(textures[i]);
 }
 
+void Renderer::UpdateTextureStreaming()
+{
+    PROFILE(UpdateTextureStreaming);
+    
+    PODVector<Texture2D*> textures;
+    PODVector<TextureStreamingInfo*> infos;
+    
+    for (Vector<WeakPtr<Texture2D> >::Iterator i = streamingTextures_.Begin(); i != streamingTextures_.End();)
+    {
+        Texture2D* texture = *i;
+        if (!texture || !texture->IsStreaming())
+        {
+            i = streamingTextures_.Erase(i);
+            continue;
+        }
+        
+        // A texture not requested on this frame keeps its current level, but with zero on-screen size it is the first
+        // to lose its levels if over the budget
+        TextureStreamingInfo& info = texture->GetStreamingInfo();
+        if (!info.requested_)
+        {
+            info.desiredLevel_ = texture->GetStreamingLevel();
+            info.screenSize_ = 0.0f;
+        }
+        
+        textures.Push(texture);
+        infos.Push(&info);
+        ++i;
+    }
+    
+    textureStreamingMemoryUse_ = AssignStreamingLevels(infos, textureStreamingBudget_);
+    
+    // Dropping levels frees memory, so do it immediately. Limit the higher resolution uploads per frame to avoid stalls,
+    // and upload for the largest on-screen textures first
+    PODVector<Texture2D*> uploads;
+    for (unsigned i = 0; i < textures.Size(); ++i)
+    {
+        Texture2D* texture = textures[i];
+        unsigned level = texture->GetStreamingInfo().assignedLevel_;
+        if (level > texture->GetStreamingLevel())
+            texture->SetStreamingLevel(level);
+        else if (level < texture->GetStreamingLevel())
+            uploads.Push(texture);
+    }
+    
+    if (uploads.Size() > (unsigned)maxStreamingUploads_)
+    {
+        Sort(uploads.Begin(), uploads.End(), CompareStreamingTextures);
+        uploads.Resize(maxStreamingUploads_);
+    }
+    for (unsigned i = 0; i < uploads.Size(); ++i)
+        uploads[i]->SetStreamingLevel(uploads[i]->GetStreamingInfo().assignedLevel_);
+    
+    for (unsigned i = 0; i < infos.Size(); ++i)
+        infos[i]->requested_ = false;
+}
+
 void Renderer::CreateGeometries()
 {
     SharedPtr<VertexBuffer> dlvb(new VertexBuffer(context_));
@@ -179,6 +179,12 @@ public:
     void SetTextureFilterMode(TextureFilterMode mode);
     /// Set texture quality level.
     void SetTextureQuality(int quality);
+    /// Set texture mip streaming on/off. When on, compressed textures are first loaded at low resolution and refined according to their on-screen size.
+    void SetTextureStreaming(bool enable);
+    /// Set memory budget in bytes for mip streaming textures. Zero (default) is unlimited.
+    void SetTextureStreamingBudget(unsigned budget);
+    /// Set maximum number of streaming textures uploaded at higher resolution per frame.
+    void SetMaxStreamingUploads(int uploads);
     /// Set material quality level.
     void SetMaterialQuality(int quality);
     /// Set shadows on/off.
@@ -226,6 +232,16 @@ public:
     TextureFilterMode GetTextureFilterMode() const { return textureFilterMode_; }
     /// Return texture quality level.
     int GetTextureQuality() const { return textureQuality_; }
+    /// Return whether texture mip streaming is enabled.
+    bool GetTextureStreaming() const { return textureStreaming_; }
+    /// Return memory budget for mip streaming textures.
+    unsigned GetTextureStreamingBudget() const { return textureStreamingBudget_; }
+    /// Return maximum number of streaming textures uploaded at higher resolution per frame.
+    int GetMaxStreamingUploads() const { return maxStreamingUploads_; }
+    /// Return memory use of mip streaming textures at the levels assigned on the last frame.
+    unsigned GetTextureStreamingMemoryUse() const { return textureStreamingMemoryUse_; }
+    /// Return number of mip streaming textures.
+    unsigned GetNumStreamingTextures() const { return streamingTextures_.Size(); }
     /// Return material quality level.
     int GetMaterialQuality() const { return materialQuality_; }
     /// Return shadow map resolution.
@@ -303,6 +319,8 @@ public:
     void QueueRenderSurface(RenderSurface* renderTarget);
     /// Queue a viewport for rendering. Null surface means backbuffer.
     void QueueViewport(RenderSurface* renderTarget, Viewport* viewport);
+    /// Add a texture for mip streaming. Called by Texture2D.
+    void AddStreamingTexture(Texture2D* texture);
     
     /// Populate light volume shaders.
     void GetLightVolumeShaders(PODVector<ShaderVariation*>& lightVS, PODVector<ShaderVariation*>& lightPS, const String& vsName, const String& psName);
@@ -352,6 +370,8 @@ private:
     void ReleaseMaterialShaders();
     /// Reload textures.
     void ReloadTextures();
+    /// Assign mip levels to streaming textures according to the requests from views and the budget, and upload changed levels.
+    void UpdateTextureStreaming();
     /// Create light volume geometries.
     void CreateGeometries();
     /// Create instancing vertex buffer.
@@ -435,6 +455,8 @@ private:
     Vector<SharedPtr<View> > views_;
     /// Octrees that have been updated during the frame.
     HashSet<Octree*> updatedOctrees_;
+    /// Mip streaming textures.
+    Vector<WeakPtr<Texture2D> > streamingTextures_;
     /// Techniques for which missing shader error has been displayed.
     HashSet<Technique*> shaderErrorDisplayed_;
     /// Mutex for shadow camera allocation.
@@ -451,6 +473,12 @@ private:
     int textureQuality_;
     /// Material quality level.
     int materialQuality_;
+    /// Memory budget for mip streaming textures.
+    unsigned textureStreamingBudget_;
+    /// Memory use of mip streaming textures.
+    unsigned textureStreamingMemoryUse_;
+    /// Maximum number of higher resolution streaming texture uploads per frame.
+    int maxStreamingUploads_;
     /// Shadow map resolution.
     int shadowMapSize_;
     /// Shadow quality.
@@ -493,6 +521,8 @@ private:
     bool reuseShadowMaps_;
     /// Dynamic instancing flag.
     bool dynamicInstancing_;
+    /// Texture mip streaming flag.
+    bool textureStreaming_;
     /// Shaders need reloading flag.
     bool shadersDirty_;
     /// Initialized flag.
@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Precompiled.h"
+#include "Image.h"
+#include "MathDefs.h"
+#include "Sort.h"
+#include "TextureStreaming.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Mip level which can be dropped from a streaming texture, with the resulting blur factor.
+struct StreamingDrop
+{
+    /// Texture streaming info.
+    TextureStreamingInfo* info_;
+    /// Ratio of on-screen size to the texture size after dropping the level.
+    float blur_;
+};
+
+static bool CompareStreamingDrops(const StreamingDrop& lhs, const StreamingDrop& rhs)
+{
+    return lhs.blur_ < rhs.blur_;
+}
+
+bool TextureStreamingInfo::Define(Image* image, unsigned mipsToSkip, bool decompress)
+{
+    if (!image || !image->IsCompressed())
+        return false;
+    
+    int width = image->GetWidth();
+    int height = image->GetHeight();
+    numLevels_ = Min((int)image->GetNumCompressedLevels(), (int)MAX_STREAMING_LEVELS);
+    size_ = Max(width, height);
+    
+    for (unsigned i = 0; i < numLevels_; ++i)
+    {
+        CompressedLevel level = image->GetCompressedLevel(i);
+        levelSizes_[i] = decompress ? level.width_ * level.height_ * 4 : level.dataSize_;
+    }
+    
+    // Apply the same limits to skipping mip levels as when loading the texture
+    if (mipsToSkip >= numLevels_)
+        mipsToSkip = numLevels_ - 1;
+    while (mipsToSkip && (width / (1 << mipsToSkip) < 4 || height / (1 << mipsToSkip) < 4))
+        --mipsToSkip;
+    minLevel_ = mipsToSkip;
+    
+    maxLevel_ = minLevel_;
+    while (maxLevel_ + 1 < numLevels_ && (size_ >> maxLevel_) > STREAMING_RESIDENT_SIZE && width >> (maxLevel_ + 1) >= 4 &&
+        height >> (maxLevel_ + 1) >= 4)
+        ++maxLevel_;
+    
+    desiredLevel_ = maxLevel_;
+    assignedLevel_ = maxLevel_;
+    screenSize_ = 0.0f;
+    requested_ = false;
+    
+    return maxLevel_ > minLevel_;
+}
+
+void TextureStreamingInfo::Request(unsigned level, float screenSize)
+{
+    if (!requested_)
+    {
+        desiredLevel_ = level;
+        screenSize_ = screenSize;
+        requested_ = true;
+    }
+    else
+    {
+        desiredLevel_ = Min((int)desiredLevel_, (int)level);
+        screenSize_ = Max(screenSize_, screenSize);
+    }
+}
+
+unsigned TextureStreamingInfo::GetNeededLevel(float screenSize) const
+{
+    // Assume the texture is mapped once over the object: each halving of the on-screen size allows dropping one level
+    unsigned level = 0;
+    while (level + 1 < numLevels_ && (float)(size_ >> (level + 1)) >= screenSize)
+        ++level;
+    
+    return Clamp((int)level, (int)minLevel_, (int)maxLevel_);
+}
+
+unsigned TextureStreamingInfo::GetMemoryUse(unsigned level) const
+{
+    unsigned total = 0;
+    for (unsigned i = level; i < numLevels_; ++i)
+        total += levelSizes_[i];
+    return total;
+}
+
+unsigned AssignStreamingLevels(const PODVector<TextureStreamingInfo*>& infos, unsigned budget)
+{
+    unsigned total = 0;
+    for (unsigned i = 0; i < infos.Size(); ++i)
+    {
+        TextureStreamingInfo* info = infos[i];
+        info->assignedLevel_ = Clamp((int)info->desiredLevel_, (int)info->minLevel_, (int)info->maxLevel_);
+        total += info->GetMemoryUse(info->assignedLevel_);
+    }
+    
+    if (!budget || total <= budget)
+        return total;
+    
+    // Collect all levels that could be dropped. The blur grows for each further level dropped from the same texture,
+    // so sorting by blur also keeps the drops of each texture in order
+    PODVector<StreamingDrop> drops;
+    for (unsigned i = 0; i < infos.Size(); ++i)
+    {
+        TextureStreamingInfo* info = infos[i];
+        for (unsigned j = info->assignedLevel_; j < info->maxLevel_; ++j)
+        {
+            StreamingDrop drop;
+            drop.info_ = info;
+            drop.blur_ = info->screenSize_ / (float)Max(info->size_ >> (j + 1), 1);
+            drops.Push(drop);
+        }
+    }
+    
+    Sort(drops.Begin(), drops.End(), CompareStreamingDrops);
+    
+    for (unsigned i = 0; i < drops.Size() && total > budget; ++i)
+    {
+        TextureStreamingInfo* info = drops[i].info_;
+        total -= info->levelSizes_[info->assignedLevel_];
+        ++info->assignedLevel_;
+    }
+    
+    return total;
+}
+
+}
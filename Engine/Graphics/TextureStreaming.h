@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+class Image;
+
+/// Maximum number of mip levels tracked for a streaming texture.
+static const unsigned MAX_STREAMING_LEVELS = 16;
+/// Largest dimension in pixels of the lowest resolution mip level that is always kept resident.
+static const int STREAMING_RESIDENT_SIZE = 64;
+
+/// Mip streaming state of a texture, used to fit the streaming textures into the texture memory budget.
+struct TextureStreamingInfo
+{
+    /// Construct empty.
+    TextureStreamingInfo() :
+        size_(0),
+        numLevels_(0),
+        minLevel_(0),
+        maxLevel_(0),
+        desiredLevel_(0),
+        assignedLevel_(0),
+        screenSize_(0.0f),
+        requested_(false)
+    {
+    }
+    
+    /// Define from a compressed image and the mip levels to skip according to texture quality. The level data sizes are those of the image, or of RGBA data if the texture needs to be decompressed. Return true if the image has enough mip levels for streaming.
+    bool Define(Image* image, unsigned mipsToSkip, bool decompress);
+    /// Request a mip level on the current frame with the on-screen size in pixels of the object using the texture. The highest resolution request wins.
+    void Request(unsigned level, float screenSize);
+    /// Return the mip level needed to show the texture at an on-screen size in pixels.
+    unsigned GetNeededLevel(float screenSize) const;
+    /// Return memory use in bytes when the mip chain starts from a level.
+    unsigned GetMemoryUse(unsigned level) const;
+    
+    /// Data size in bytes of each mip level.
+    unsigned levelSizes_[MAX_STREAMING_LEVELS];
+    /// Largest dimension of the full resolution mip level.
+    int size_;
+    /// Number of mip levels.
+    unsigned numLevels_;
+    /// Highest resolution mip level allowed by the texture quality.
+    unsigned minLevel_;
+    /// Lowest resolution mip level, which is always resident.
+    unsigned maxLevel_;
+    /// Highest resolution mip level requested on the current frame.
+    unsigned desiredLevel_;
+    /// Mip level assigned within the memory budget.
+    unsigned assignedLevel_;
+    /// Largest on-screen size in pixels requested on the current frame. Zero if not visible.
+    float screenSize_;
+    /// Requested on the current frame flag.
+    bool requested_;
+};
+
+/// Assign mip levels to streaming textures within a memory budget, zero meaning unlimited. Textures start from their desired levels and the mip levels which would cause the least blurring relative to the on-screen size are dropped first, so textures not visible are dropped to their resident level before visible ones lose detail. Return the resulting memory use.
+unsigned AssignStreamingLevels(const PODVector<TextureStreamingInfo*>& infos, unsigned budget);
+
+}
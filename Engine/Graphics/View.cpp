@@ -922,6 +922,10 @@ void View::GetBatches()
     {
         PROFILE(GetBaseBatches);
         
+        // Pixels per world unit at unit distance, for converting drawable sizes to on-screen sizes for mip streaming
+        bool textureStreaming = renderer_->GetTextureStreaming();
+        float pixelsPerUnit = (float)viewSize_.y_ * 0.5f / camera_->GetHalfViewSize();
+        
         for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
         {
             Drawable* drawable = *i;
@@ -932,6 +936,14 @@ void View::GetBatches()
             if (!drawableVertexLights.Empty())
                 drawable->LimitVertexLights();
             
+            float screenSize = 0.0f;
+            if (textureStreaming)
+            {
+                screenSize = drawable->GetWorldBoundingBox().Size().Length() * pixelsPerUnit;
+                if (!camera_->IsOrthographic())
+                    screenSize /= Max(drawable->GetDistance(), M_EPSILON);
+            }
+            
             for (unsigned j = 0; j < batches.Size(); ++j)
             {
                 const SourceBatch& srcBatch = batches[j];
@@ -941,6 +953,9 @@ void View::GetBatches()
                 if (srcBatch.material_ && srcBatch.material_->GetAuxViewFrameNumber() != frame_.frameNumber_ && !renderTarget_)
                     CheckMaterialForAuxView(srcBatch.material_);
                 
+                if (textureStreaming && srcBatch.material_)
+                    RequestTextureLevels(srcBatch.material_, screenSize);
+                
                 Technique* tech = GetTechnique(drawable, srcBatch.material_);
                 if (!srcBatch.geometry_ || !tech)
                     continue;
@@ -2361,6 +2376,25 @@ void View::CheckMaterialForAuxView(Material* material)
     material->MarkForAuxView(frame_.frameNumber_);
 }
 
+void View::RequestTextureLevels(Material* material, float screenSize)
+{
+    const SharedPtr<Texture>* textures = material->GetTextures();
+    
+    for (unsigned i = 0; i < MAX_MATERIAL_TEXTURE_UNITS; ++i)
+    {
+        Texture* texture = textures[i];
+        if (texture && texture->GetType() == Texture2D::GetTypeStatic())
+        {
+            Texture2D* tex2D = static_cast<Texture2D*>(texture);
+            if (tex2D->IsStreaming())
+            {
+                TextureStreamingInfo& info = tex2D->GetStreamingInfo();
+                info.Request(info.GetNeededLevel(screenSize), screenSize);
+            }
+        }
+    }
+}
+
 void View::AddBatchToQueue(BatchQueue& batchQueue, Batch& batch, Technique* tech, bool allowInstancing, bool allowShadows)
 {
     if (!batch.material_)
@@ -189,6 +189,8 @@ private:
     Technique* GetTechnique(Drawable* drawable, Material* material);
     /// Check if material should render an auxiliary view (if it has a camera attached.)
     void CheckMaterialForAuxView(Material* material);
+    /// Request mip levels for the streaming textures of a material according to the on-screen size in pixels.
+    void RequestTextureLevels(Material* material, float screenSize);
     /// Choose shaders for a batch and add it to queue.
     void AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing = true, bool allowShadows = true);
     /// Prepare instancing buffer by filling it with all instance transforms.
@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Precompiled.h"
+#include "BitReader.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+static const float SMALLEST_THREE_RANGE = 0.707107f;
+
+static float DequantizeFloat(unsigned value, float min, float max, unsigned numBits)
+{
+    double steps = (double)(M_MAX_UNSIGNED >> (32 - numBits));
+    return (float)(min + (double)value / steps * ((double)max - min));
+}
+
+BitReader::BitReader(const void* data, unsigned size) :
+    data_((const unsigned char*)data),
+    size_(data ? size : 0),
+    position_(0)
+{
+}
+
+BitReader::BitReader(const PODVector<unsigned char>& data) :
+    data_(data.Size() ? &data[0] : 0),
+    size_(data.Size()),
+    position_(0)
+{
+}
+
+unsigned BitReader::ReadBits(unsigned numBits)
+{
+    if (numBits > 32)
+        numBits = 32;
+    
+    unsigned ret = 0;
+    unsigned retBits = 0;
+    unsigned totalBits = size_ << 3;
+    
+    while (retBits < numBits && position_ < totalBits)
+    {
+        unsigned bitOffset = position_ & 7;
+        unsigned bitsToRead = 8 - bitOffset;
+        if (bitsToRead > numBits - retBits)
+            bitsToRead = numBits - retBits;
+        
+        unsigned bits = (data_[position_ >> 3] >> bitOffset) & ((1U << bitsToRead) - 1);
+        ret |= bits << retBits;
+        retBits += bitsToRead;
+        position_ += bitsToRead;
+    }
+    
+    return ret;
+}
+
+bool BitReader::ReadBool()
+{
+    return ReadBits(1) != 0;
+}
+
+unsigned BitReader::ReadVarUInt()
+{
+    unsigned ret = 0;
+    
+    for (unsigned shift = 0; shift < 35 && !IsEof(); shift += 7)
+    {
+        unsigned byte = ReadBits(8);
+        ret |= (byte & 0x7f) << shift;
+        if (byte < 0x80)
+            break;
+    }
+    
+    return ret;
+}
+
+int BitReader::ReadVarInt()
+{
+    unsigned value = ReadVarUInt();
+    return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+float BitReader::ReadQuantizedFloat(float min, float max, unsigned numBits)
+{
+    if (!numBits)
+        return min;
+    if (numBits > 32)
+        numBits = 32;
+    
+    return DequantizeFloat(ReadBits(numBits), min, max, numBits);
+}
+
+Vector3 BitReader::ReadQuantizedVector3(float min, float max, unsigned numBits)
+{
+    Vector3 ret;
+    ret.x_ = ReadQuantizedFloat(min, max, numBits);
+    ret.y_ = ReadQuantizedFloat(min, max, numBits);
+    ret.z_ = ReadQuantizedFloat(min, max, numBits);
+    return ret;
+}
+
+Vector3 BitReader::ReadNormalizedVector3(unsigned numBits)
+{
+    float x = ReadQuantizedFloat(-1.0f, 1.0f, numBits);
+    float y = ReadQuantizedFloat(-1.0f, 1.0f, numBits);
+    float z = 1.0f - Abs(x) - Abs(y);
+    
+    // Unfold the lower hemisphere
+    if (z < 0.0f)
+    {
+        float unfoldedX = (1.0f - Abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float unfoldedY = (1.0f - Abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = unfoldedX;
+        y = unfoldedY;
+    }
+    
+    return Vector3(x, y, z).Normalized();
+}
+
+Quaternion BitReader::ReadQuaternion(unsigned numBits)
+{
+    unsigned largest = ReadBits(2);
+    float components[4];
+    float sumSquared = 0.0f;
+    
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+        {
+            components[i] = ReadQuantizedFloat(-SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE, numBits);
+            sumSquared += components[i] * components[i];
+        }
+    }
+    
+    components[largest] = sqrtf(Max(1.0f - sumSquared, 0.0f));
+    return Quaternion(components[0], components[1], components[2], components[3]).Normalized();
+}
+
+void BitReader::Align()
+{
+    position_ = (position_ + 7) & ~7U;
+}
+
+void BitReader::Seek(unsigned bitPosition)
+{
+    unsigned totalBits = size_ << 3;
+    position_ = bitPosition < totalBits ? bitPosition : totalBits;
+}
+
+}
@@ -0,0 +1,78 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Quaternion.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+/// Bit-level stream reader for data written by BitWriter.
+class BitReader
+{
+public:
+    /// Construct with a pointer and size in bytes. The data must stay valid while reading.
+    BitReader(const void* data, unsigned size);
+    /// Construct from a vector, which must not go out of scope before the reader.
+    BitReader(const PODVector<unsigned char>& data);
+    
+    /// Read bits into the lowest bits of the return value. Up to 32 bits can be read at once. Reading past the end returns zero bits.
+    unsigned ReadBits(unsigned numBits);
+    /// Read a single bit as a bool.
+    bool ReadBool();
+    /// Read a variable-length encoded unsigned integer.
+    unsigned ReadVarUInt();
+    /// Read a zigzag and variable-length encoded signed integer.
+    int ReadVarInt();
+    /// Read a float quantized to the given number of bits over a range.
+    float ReadQuantizedFloat(float min, float max, unsigned numBits);
+    /// Read a Vector3 with each component quantized to the given number of bits over a range.
+    Vector3 ReadQuantizedVector3(float min, float max, unsigned numBits);
+    /// Read an octahedral encoded unit-length Vector3.
+    Vector3 ReadNormalizedVector3(unsigned numBits);
+    /// Read a quaternion encoded as the smallest three components.
+    Quaternion ReadQuaternion(unsigned numBits);
+    /// Skip to the next byte boundary.
+    void Align();
+    /// Set read position in bits from the beginning.
+    void Seek(unsigned bitPosition);
+    
+    /// Return read position in bits.
+    unsigned GetPosition() const { return position_; }
+    /// Return total size in bits.
+    unsigned GetNumBits() const { return size_ << 3; }
+    /// Return whether all bits have been read.
+    bool IsEof() const { return position_ >= (size_ << 3); }
+    
+private:
+    /// Data pointer.
+    const unsigned char* data_;
+    /// Size in bytes.
+    unsigned size_;
+    /// Read position in bits.
+    unsigned position_;
+};
+
+}
@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Precompiled.h"
+#include "BitWriter.h"
+#include "Serializer.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+static const float SMALLEST_THREE_RANGE = 0.707107f;
+
+static unsigned QuantizeFloat(float value, float min, float max, unsigned numBits)
+{
+    if (max <= min)
+        return 0;
+    
+    double steps = (double)(M_MAX_UNSIGNED >> (32 - numBits));
+    double normalized = ((double)Clamp(value, min, max) - min) / ((double)max - min);
+    return (unsigned)(normalized * steps + 0.5);
+}
+
+BitWriter::BitWriter() :
+    numBits_(0)
+{
+}
+
+void BitWriter::WriteBits(unsigned value, unsigned numBits)
+{
+    if (!numBits)
+        return;
+    if (numBits > 32)
+        numBits = 32;
+    if (numBits < 32)
+        value &= (1U << numBits) - 1;
+    
+    data_.Resize((numBits_ + numBits + 7) >> 3);
+    
+    while (numBits)
+    {
+        unsigned byteIndex = numBits_ >> 3;
+        unsigned bitOffset = numBits_ & 7;
+        unsigned bitsToWrite = 8 - bitOffset;
+        if (bitsToWrite > numBits)
+            bitsToWrite = numBits;
+        
+        // Assign a new byte whole, as the resized buffer is uninitialized. This also leaves the padding bits zero
+        unsigned char mask = (unsigned char)(((1U << bitsToWrite) - 1) << bitOffset);
+        if (bitOffset)
+            data_[byteIndex] = (unsigned char)((data_[byteIndex] & ~mask) | ((value << bitOffset) & mask));
+        else
+            data_[byteIndex] = (unsigned char)(value & mask);
+        
+        value >>= bitsToWrite;
+        numBits -= bitsToWrite;
+        numBits_ += bitsToWrite;
+    }
+}
+
+void BitWriter::WriteBool(bool value)
+{
+    WriteBits(value ? 1 : 0, 1);
+}
+
+void BitWriter::WriteVarUInt(unsigned value)
+{
+    while (value >= 0x80)
+    {
+        WriteBits((value & 0x7f) | 0x80, 8);
+        value >>= 7;
+    }
+    WriteBits(value, 8);
+}
+
+void BitWriter::WriteVarInt(int value)
+{
+    WriteVarUInt(((unsigned)value << 1) ^ (unsigned)(value >> 31));
+}
+
+void BitWriter::WriteQuantizedFloat(float value, float min, float max, unsigned numBits)
+{
+    if (!numBits)
+        return;
+    if (numBits > 32)
+        numBits = 32;
+    
+    WriteBits(QuantizeFloat(value, min, max, numBits), numBits);
+}
+
+void BitWriter::WriteQuantizedVector3(const Vector3& value, float min, float max, unsigned numBits)
+{
+    WriteQuantizedFloat(value.x_, min, max, numBits);
+    WriteQuantizedFloat(value.y_, min, max, numBits);
+    WriteQuantizedFloat(value.z_, min, max, numBits);
+}
+
+void BitWriter::WriteNormalizedVector3(const Vector3& value, unsigned numBits)
+{
+    // Project onto the octahedron, then fold the lower hemisphere over the upper
+    float sum = Abs(value.x_) + Abs(value.y_) + Abs(value.z_);
+    float x = sum > 0.0f ? value.x_ / sum : 0.0f;
+    float y = sum > 0.0f ? value.y_ / sum : 0.0f;
+    if (value.z_ < 0.0f)
+    {
+        float foldedX = (1.0f - Abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - Abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    
+    WriteQuantizedFloat(x, -1.0f, 1.0f, numBits);
+    WriteQuantizedFloat(y, -1.0f, 1.0f, numBits);
+}
+
+void BitWriter::WriteQuaternion(const Quaternion& value, unsigned numBits)
+{
+    Quaternion normalized = value.Normalized();
+    const float* components = normalized.Data();
+    
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largest]))
+            largest = i;
+    }
+    
+    // q and -q represent the same rotation, so flip the sign to make the omitted component positive
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    
+    WriteBits(largest, 2);
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+            WriteQuantizedFloat(components[i] * sign, -SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE, numBits);
+    }
+}
+
+void BitWriter::Align()
+{
+    numBits_ = (numBits_ + 7) & ~7U;
+}
+
+bool BitWriter::WriteTo(Serializer& dest)
+{
+    Align();
+    return dest.WriteBuffer(data_);
+}
+
+void BitWriter::Clear()
+{
+    data_.Clear();
+    numBits_ = 0;
+}
+
+}
@@ -0,0 +1,78 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Quaternion.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+class Serializer;
+
+/// Bit-level stream writer for compact encoding of scene and network data. Bits are written least significant first.
+class BitWriter
+{
+public:
+    /// Construct empty.
+    BitWriter();
+    
+    /// Write the lowest bits of a value. Up to 32 bits can be written at once.
+    void WriteBits(unsigned value, unsigned numBits);
+    /// Write a bool as a single bit.
+    void WriteBool(bool value);
+    /// Write a variable-length encoded unsigned integer in groups of 7 bits plus a continuation bit.
+    void WriteVarUInt(unsigned value);
+    /// Write a zigzag and variable-length encoded signed integer, so that small negative values are also short.
+    void WriteVarInt(int value);
+    /// Write a float quantized to the given number of bits over a range. Values outside the range are clamped.
+    void WriteQuantizedFloat(float value, float min, float max, unsigned numBits);
+    /// Write a Vector3 with each component quantized to the given number of bits over a range.
+    void WriteQuantizedVector3(const Vector3& value, float min, float max, unsigned numBits);
+    /// Write a unit-length Vector3 using octahedral encoding with two components of the given number of bits.
+    void WriteNormalizedVector3(const Vector3& value, unsigned numBits);
+    /// Write a quaternion using the smallest three components of the given number of bits, plus 2 bits for the index of the largest.
+    void WriteQuaternion(const Quaternion& value, unsigned numBits);
+    /// Pad with zero bits to the next byte boundary.
+    void Align();
+    /// Write the data to a stream with size encoded as VLE. The data is padded to a byte boundary first.
+    bool WriteTo(Serializer& dest);
+    /// Clear the written data.
+    void Clear();
+    
+    /// Return the data. The last byte may be partially written.
+    const PODVector<unsigned char>& GetData() const { return data_; }
+    /// Return number of bits written.
+    unsigned GetNumBits() const { return numBits_; }
+    /// Return number of bytes used.
+    unsigned GetSize() const { return data_.Size(); }
+    
+private:
+    /// Data buffer.
+    PODVector<unsigned char> data_;
+    /// Number of bits written.
+    unsigned numBits_;
+};
+
+}
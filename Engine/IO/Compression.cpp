@@ -0,0 +1,223 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Precompiled.h"
+#include "Compression.h"
+
+#include <cstring>
+
+#include "DebugNew.h"
+
+// Compressor and decompressor for the LZ4 block format, see http://code.google.com/p/lz4/
+
+namespace Urho3D
+{
+
+static const unsigned MIN_MATCH = 4;
+static const unsigned LAST_LITERALS = 5;
+static const unsigned MF_LIMIT = 12;
+static const unsigned MAX_OFFSET = 65535;
+static const unsigned RUN_MASK = 15;
+static const unsigned HASH_BITS = 12;
+
+static inline unsigned ReadSequence(const unsigned char* ptr)
+{
+    unsigned value;
+    memcpy(&value, ptr, sizeof value);
+    return value;
+}
+
+static inline unsigned HashSequence(unsigned sequence)
+{
+    return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static inline unsigned char* WriteLength(unsigned char* dest, unsigned length)
+{
+    while (length >= 255)
+    {
+        *dest++ = 255;
+        length -= 255;
+    }
+    *dest++ = (unsigned char)length;
+    return dest;
+}
+
+static inline bool ReadLength(const unsigned char*& src, const unsigned char* srcEnd, unsigned& length)
+{
+    unsigned char byte;
+    do
+    {
+        if (src >= srcEnd)
+            return false;
+        byte = *src++;
+        length += byte;
+    }
+    while (byte == 255);
+    
+    return true;
+}
+
+static unsigned char* WriteSequence(unsigned char* dest, const unsigned char* literals, unsigned numLiterals)
+{
+    unsigned char* token = dest++;
+    *token = (unsigned char)((numLiterals < RUN_MASK ? numLiterals : RUN_MASK) << 4);
+    if (numLiterals >= RUN_MASK)
+        dest = WriteLength(dest, numLiterals - RUN_MASK);
+    memcpy(dest, literals, numLiterals);
+    return dest + numLiterals;
+}
+
+unsigned EstimateCompressBound(unsigned srcSize)
+{
+    return srcSize + srcSize / 255 + 16;
+}
+
+unsigned CompressData(void* dest, const void* src, unsigned srcSize)
+{
+    if (!dest || !src || !srcSize)
+        return 0;
+    
+    const unsigned char* base = (const unsigned char*)src;
+    const unsigned char* srcPtr = base;
+    const unsigned char* srcEnd = base + srcSize;
+    const unsigned char* anchor = base;
+    unsigned char* destPtr = (unsigned char*)dest;
+    
+    if (srcSize > MF_LIMIT)
+    {
+        // Matches may not start within the last 12 bytes, and the last 5 bytes must always be literals
+        const unsigned char* matchStartLimit = srcEnd - MF_LIMIT;
+        const unsigned char* matchEndLimit = srcEnd - LAST_LITERALS;
+        unsigned hashTable[1 << HASH_BITS];
+        memset(hashTable, 0, sizeof hashTable);
+        
+        while (srcPtr < matchStartLimit)
+        {
+            unsigned sequence = ReadSequence(srcPtr);
+            unsigned hash = HashSequence(sequence);
+            const unsigned char* ref = base + hashTable[hash];
+            hashTable[hash] = srcPtr - base;
+            
+            if (ref >= srcPtr || (unsigned)(srcPtr - ref) > MAX_OFFSET || ReadSequence(ref) != sequence)
+            {
+                ++srcPtr;
+                continue;
+            }
+            
+            // Extend the match backward over pending literals, then forward
+            while (srcPtr > anchor && ref > base && srcPtr[-1] == ref[-1])
+            {
+                --srcPtr;
+                --ref;
+            }
+            const unsigned char* matchEnd = srcPtr + MIN_MATCH;
+            const unsigned char* refEnd = ref + MIN_MATCH;
+            while (matchEnd < matchEndLimit && *matchEnd == *refEnd)
+            {
+                ++matchEnd;
+                ++refEnd;
+            }
+            
+            unsigned char* token = destPtr;
+            destPtr = WriteSequence(destPtr, anchor, srcPtr - anchor);
+            unsigned offset = srcPtr - ref;
+            *destPtr++ = (unsigned char)(offset & 0xff);
+            *destPtr++ = (unsigned char)(offset >> 8);
+            unsigned matchLength = matchEnd - srcPtr - MIN_MATCH;
+            *token |= (unsigned char)(matchLength < RUN_MASK ? matchLength : RUN_MASK);
+            if (matchLength >= RUN_MASK)
+                destPtr = WriteLength(destPtr, matchLength - RUN_MASK);
+            
+            srcPtr = matchEnd;
+            anchor = srcPtr;
+            // Hash a position inside the match to improve the chance of finding the next match
+            hashTable[HashSequence(ReadSequence(srcPtr - 2))] = srcPtr - 2 - base;
+        }
+    }
+    
+    // Write the remaining data as literals
+    destPtr = WriteSequence(destPtr, anchor, srcEnd - anchor);
+    return destPtr - (unsigned char*)dest;
+}
+
+unsigned DecompressData(void* dest, const void* src, unsigned destSize, unsigned srcSize)
+{
+    if (!dest || !src || !srcSize)
+        return 0;
+    
+    const unsigned char* srcPtr = (const unsigned char*)src;
+    const unsigned char* srcEnd = srcPtr + srcSize;
+    unsigned char* destStart = (unsigned char*)dest;
+    unsigned char* destPtr = destStart;
+    unsigned char* destEnd = destStart + destSize;
+    
+    for (;;)
+    {
+        unsigned token = *srcPtr++;
+        
+        unsigned numLiterals = token >> 4;
+        if (numLiterals == RUN_MASK && !ReadLength(srcPtr, srcEnd, numLiterals))
+            return 0;
+        if (numLiterals > (unsigned)(srcEnd - srcPtr) || numLiterals > (unsigned)(destEnd - destPtr))
+            return 0;
+        memcpy(destPtr, srcPtr, numLiterals);
+        srcPtr += numLiterals;
+        destPtr += numLiterals;
+        
+        // The last sequence contains only literals
+        if (srcPtr == srcEnd)
+            break;
+        
+        if (srcEnd - srcPtr < 2)
+            return 0;
+        unsigned offset = srcPtr[0] | (srcPtr[1] << 8);
+        srcPtr += 2;
+        if (!offset || offset > (unsigned)(destPtr - destStart))
+            return 0;
+        
+        unsigned matchLength = token & RUN_MASK;
+        if (matchLength == RUN_MASK && !ReadLength(srcPtr, srcEnd, matchLength))
+            return 0;
+        matchLength += MIN_MATCH;
+        if (matchLength > (unsigned)(destEnd - destPtr) || srcPtr >= srcEnd)
+            return 0;
+        
+        // Matches may overlap the output, in which case copy byte by byte
+        const unsigned char* matchPtr = destPtr - offset;
+        if (offset >= matchLength)
+        {
+            memcpy(destPtr, matchPtr, matchLength);
+            destPtr += matchLength;
+        }
+        else
+        {
+            for (unsigned i = 0; i < matchLength; ++i)
+                *destPtr++ = *matchPtr++;
+        }
+    }
+    
+    return destPtr == destEnd ? destSize : 0;
+}
+
+}
@@ -0,0 +1,36 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+namespace Urho3D
+{
+
+/// Return worst case LZ4 compressed output size in bytes for the given input size.
+unsigned EstimateCompressBound(unsigned srcSize);
+/// Compress data into the LZ4 block format. Return the compressed size in bytes. The destination buffer must be at least EstimateCompressBound() bytes.
+unsigned CompressData(void* dest, const void* src, unsigned srcSize);
+/// Decompress LZ4 block format data. The decompressed size must be known in advance. Return the decompressed size, or 0 if the data is corrupt.
+unsigned DecompressData(void* dest, const void* src, unsigned destSize, unsigned srcSize);
+
+}
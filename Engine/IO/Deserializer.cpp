@@ -379,6 +379,27 @@ unsigned Deserializer::ReadVLE()
     return ret;
 }
 
+unsigned Deserializer::ReadVarUInt()
+{
+    unsigned ret = 0;
+    
+    for (unsigned shift = 0; shift < 35 && !IsEof(); shift += 7)
+    {
+        unsigned char byte = ReadUByte();
+        ret |= ((unsigned)(byte & 0x7f)) << shift;
+        if (byte < 0x80)
+            break;
+    }
+    
+    return ret;
+}
+
+int Deserializer::ReadVarInt()
+{
+    unsigned value = ReadVarUInt();
+    return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
 unsigned Deserializer::ReadNetID()
 {
     unsigned ret = 0;
@@ -117,6 +117,10 @@ public:
     VariantMap ReadVariantMap();
     /// Read a variable-length encoded unsigned integer, which can use 29 bits maximum.
     unsigned ReadVLE();
+    /// Read a variable-length encoded unsigned integer using 1-5 bytes.
+    unsigned ReadVarUInt();
+    /// Read a zigzag and variable-length encoded signed integer.
+    int ReadVarInt();
     /// Read a 24-bit network object ID.
     unsigned ReadNetID();
     /// Read a text line.
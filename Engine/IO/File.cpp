@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "Compression.h"
 #include "File.h"
 #include "FileSystem.h"
 #include "Log.h"
@@ -62,9 +63,11 @@ File::File(Context* context) :
     handle_(0),
     #ifdef ANDROID
     assetHandle_(0),
+    #endif
     readBufferOffset_(0),
     readBufferSize_(0),
-    #endif
+    readBufferBlock_(M_MAX_UNSIGNED),
+    blockSize_(0),
     offset_(0),
     checksum_(0)
 {
@@ -76,9 +79,11 @@ File::File(Context* context, const String& fileName, FileMode mode) :
     handle_(0),
     #ifdef ANDROID
     assetHandle_(0),
+    #endif
     readBufferOffset_(0),
     readBufferSize_(0),
-    #endif
+    readBufferBlock_(M_MAX_UNSIGNED),
+    blockSize_(0),
     offset_(0),
     checksum_(0)
 {
@@ -91,9 +96,11 @@ File::File(Context* context, PackageFile* package, const String& fileName) :
     handle_(0),
     #ifdef ANDROID
     assetHandle_(0),
+    #endif
     readBufferOffset_(0),
     readBufferSize_(0),
-    #endif
+    readBufferBlock_(M_MAX_UNSIGNED),
+    blockSize_(0),
     offset_(0),
     checksum_(0)
 {
@@ -159,6 +166,10 @@ bool File::Open(const String& fileName, FileMode mode)
         return false;
     }
     
+    // A new file may have been created
+    if (mode != FILE_READ && fileSystem)
+        fileSystem->RefreshIndexedPath(fileName);
+    
     fileName_ = fileName;
     mode_ = mode;
     position_ = 0;
@@ -201,6 +212,28 @@ bool File::Open(PackageFile* package, const String& fileName)
     size_ = entry->size_;
     
     fseek((FILE*)handle_, offset_, SEEK_SET);
+    
+    // Compressed entries begin with a table of block offsets, which allows to seek without decompressing preceding data
+    if (entry->compressed_)
+    {
+        unsigned blockSize = package->GetBlockSize();
+        unsigned numBlocks = (size_ + blockSize - 1) / blockSize;
+        blockOffsets_.Resize(numBlocks + 1);
+        if (fread(&blockOffsets_[0], blockOffsets_.Size() * sizeof(unsigned), 1, (FILE*)handle_) != 1 ||
+            blockOffsets_.Back() > entry->packedSize_)
+        {
+            LOGERROR("Could not read block table of compressed file " + fileName);
+            Close();
+            return false;
+        }
+        
+        blockSize_ = blockSize;
+        readBuffer_ = new unsigned char[blockSize_];
+        inputBuffer_ = new unsigned char[blockSize_];
+        readBufferSize_ = 0;
+        readBufferBlock_ = M_MAX_UNSIGNED;
+    }
+    
     return true;
 }
 
@@ -250,6 +283,31 @@ unsigned File::Read(void* dest, unsigned size)
         return 0;
     }
     
+    if (blockSize_)
+    {
+        unsigned sizeLeft = size;
+        unsigned char* destPtr = (unsigned char*)dest;
+        
+        while (sizeLeft)
+        {
+            unsigned blockIndex = position_ / blockSize_;
+            if (blockIndex != readBufferBlock_ && !ReadBlock(blockIndex))
+            {
+                LOGERROR("Error while decompressing file " + GetName());
+                return size - sizeLeft;
+            }
+            
+            unsigned blockOffset = position_ - blockIndex * blockSize_;
+            unsigned copySize = Min((int)(readBufferSize_ - blockOffset), (int)sizeLeft);
+            memcpy(destPtr, readBuffer_.Get() + blockOffset, copySize);
+            destPtr += copySize;
+            sizeLeft -= copySize;
+            position_ += copySize;
+        }
+        
+        return size;
+    }
+    
     size_t ret = fread(dest, size, 1, (FILE*)handle_);
     if (ret != 1)
     {
@@ -286,7 +344,9 @@ unsigned File::Seek(unsigned position)
         return 0;
     }
     
-    fseek((FILE*)handle_, position + offset_, SEEK_SET);
+    // For compressed entries the block containing the new position is read on demand
+    if (!blockSize_)
+        fseek((FILE*)handle_, position + offset_, SEEK_SET);
     position_ = position;
     return position_;
 }
@@ -355,10 +415,15 @@ void File::Close()
     {
         SDL_RWclose(assetHandle_);
         assetHandle_ = 0;
-        readBuffer_.Reset();
     }
     #endif
     
+    readBuffer_.Reset();
+    inputBuffer_.Reset();
+    blockOffsets_.Clear();
+    readBufferBlock_ = M_MAX_UNSIGNED;
+    blockSize_ = 0;
+    
     if (handle_)
     {
         fclose((FILE*)handle_);
@@ -381,4 +446,36 @@ void File::SetName(const String& name)
     fileName_ = name;
 }
 
+bool File::ReadBlock(unsigned index)
+{
+    if (index + 1 >= blockOffsets_.Size())
+        return false;
+    
+    unsigned unpackedSize = Min((int)blockSize_, (int)(size_ - index * blockSize_));
+    unsigned packedSize = blockOffsets_[index + 1] - blockOffsets_[index];
+    if (!packedSize || packedSize > unpackedSize)
+        return false;
+    
+    readBufferBlock_ = M_MAX_UNSIGNED;
+    fseek((FILE*)handle_, offset_ + blockOffsets_[index], SEEK_SET);
+    
+    // Blocks which did not compress are stored as is
+    if (packedSize == unpackedSize)
+    {
+        if (fread(readBuffer_.Get(), packedSize, 1, (FILE*)handle_) != 1)
+            return false;
+    }
+    else
+    {
+        if (fread(inputBuffer_.Get(), packedSize, 1, (FILE*)handle_) != 1)
+            return false;
+        if (DecompressData(readBuffer_.Get(), inputBuffer_.Get(), unpackedSize, packedSize) != unpackedSize)
+            return false;
+    }
+    
+    readBufferSize_ = unpackedSize;
+    readBufferBlock_ = index;
+    return true;
+}
+
 }
@@ -22,13 +22,12 @@
 
 #pragma once
 
+#include "ArrayPtr.h"
 #include "Deserializer.h"
 #include "Serializer.h"
 #include "Object.h"
 
 #ifdef ANDROID
-#include "ArrayPtr.h"
-
 #include <SDL_rwops.h>
 #endif
 
@@ -90,8 +89,13 @@ public:
     void* GetHandle() const { return handle_; }
     /// Return whether the file originates from a package.
     bool IsPackaged() const { return offset_ != 0; }
+    /// Return whether the file is a compressed package entry.
+    bool IsCompressed() const { return blockSize_ != 0; }
     
 private:
+    /// Read and decompress a block of a compressed package entry into the read buffer. Return true if successful.
+    bool ReadBlock(unsigned index);
+    
     /// File name.
     String fileName_;
     /// Open mode.
@@ -101,13 +105,21 @@ private:
     #ifdef ANDROID
     /// SDL RWops context for Android asset loading.
     SDL_RWops* assetHandle_;
-    /// Read buffer for Android asset loading.
+    #endif
+    /// Read buffer for Android asset loading and compressed package entries.
     SharedArrayPtr<unsigned char> readBuffer_;
+    /// Compressed data buffer for compressed package entries.
+    SharedArrayPtr<unsigned char> inputBuffer_;
+    /// Block offsets of a compressed package entry, relative to the entry start.
+    PODVector<unsigned> blockOffsets_;
     /// Read buffer position.
     unsigned readBufferOffset_;
     /// Bytes in the current read buffer.
     unsigned readBufferSize_;
-    #endif
+    /// Index of the compressed block in the read buffer, M_MAX_UNSIGNED if none.
+    unsigned readBufferBlock_;
+    /// Uncompressed block size of a compressed package entry, 0 if not compressed.
+    unsigned blockSize_;
     /// Start position within a package file, 0 for regular files.
     unsigned offset_;
     /// Content checksum.
@@ -26,6 +26,8 @@
 #include "File.h"
 #include "FileSystem.h"
 #include "Log.h"
+#include "Thread.h"
+#include "WorkQueue.h"
 
 #include <cstdio>
 #include <cstring>
@@ -63,6 +65,197 @@ extern "C" const char* SDL_IOS_GetResourceDir();
 namespace Urho3D
 {
 
+static const int DIRS_PER_WORK_ITEM = 16;
+
+/// Directory read task for the directory indexer.
+struct DirScanTask
+{
+    /// Directory path with trailing slash.
+    String path_;
+    /// Entries found.
+    Vector<DirIndexEntry> entries_;
+    /// Whether the directory could be opened.
+    bool success_;
+};
+
+/// Return the directory index key for a path.
+static String GetIndexKey(const String& pathName)
+{
+    // Windows filesystems are case-insensitive
+    #ifdef WIN32
+    return GetInternalPath(pathName).ToLower();
+    #else
+    return GetInternalPath(pathName);
+    #endif
+}
+
+/// Read the entries of a single directory, excluding . and .. Return true if the directory could be opened.
+static bool ReadDirEntries(const String& path, Vector<DirIndexEntry>& entries)
+{
+    entries.Clear();
+    
+    #ifdef WIN32
+    WIN32_FIND_DATAW info;
+    HANDLE handle = FindFirstFileW(WString(path + "*").CString(), &info);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+    
+    do
+    {
+        String fileName(info.cFileName);
+        if (!fileName.Empty() && fileName != "." && fileName != "..")
+        {
+            entries.Push(DirIndexEntry(fileName, (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0,
+                (info.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) != 0));
+        }
+    }
+    while (FindNextFileW(handle, &info));
+    
+    FindClose(handle);
+    return true;
+    #else
+    DIR *dir;
+    struct dirent *de;
+    struct stat st;
+    dir = opendir(GetNativePath(path).CString());
+    if (!dir)
+        return false;
+    
+    while ((de = readdir(dir)))
+    {
+        /// \todo Filename may be unnormalized Unicode on Mac OS X. Re-normalize as necessary
+        String fileName(de->d_name);
+        if (fileName == "." || fileName == "..")
+            continue;
+        String pathAndName = path + fileName;
+        if (!stat(pathAndName.CString(), &st))
+            entries.Push(DirIndexEntry(fileName, (st.st_mode & S_IFDIR) != 0, fileName.StartsWith(".")));
+    }
+    
+    closedir(dir);
+    return true;
+    #endif
+}
+
+/// Read the directory index entry for a single file or directory. Return true if it exists.
+static bool ReadPathEntry(const String& pathName, DirIndexEntry& entry)
+{
+    entry.name_ = pathName.Substring(GetPath(pathName).Length());
+    
+    #ifdef WIN32
+    DWORD attributes = GetFileAttributesW(GetWideNativePath(pathName).CString());
+    if (attributes == INVALID_FILE_ATTRIBUTES)
+        return false;
+    entry.directory_ = (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    entry.hidden_ = (attributes & FILE_ATTRIBUTE_HIDDEN) != 0;
+    #else
+    struct stat st;
+    if (stat(GetNativePath(pathName).CString(), &st))
+        return false;
+    entry.directory_ = (st.st_mode & S_IFDIR) != 0;
+    entry.hidden_ = entry.name_.StartsWith(".");
+    #endif
+    
+    return true;
+}
+
+void ReadDirEntriesWork(const WorkItem* item, unsigned threadIndex)
+{
+    DirScanTask* start = reinterpret_cast<DirScanTask*>(item->start_);
+    DirScanTask* end = reinterpret_cast<DirScanTask*>(item->end_);
+    
+    while (start != end)
+    {
+        start->success_ = ReadDirEntries(start->path_, start->entries_);
+        ++start;
+    }
+}
+
+/// Read a directory tree one level at a time. Use worker threads if a work queue is given. Return true if the root directory could be opened.
+static bool ReadDirTree(const String& rootPath, HashMap<String, Vector<DirIndexEntry> >& dirs, WorkQueue* queue)
+{
+    Vector<String> pending;
+    pending.Push(rootPath);
+    
+    while (pending.Size())
+    {
+        Vector<DirScanTask> tasks;
+        tasks.Resize(pending.Size());
+        for (unsigned i = 0; i < pending.Size(); ++i)
+            tasks[i].path_ = pending[i];
+        
+        if (queue && queue->GetNumThreads() && tasks.Size() > 1)
+        {
+            WorkItem item;
+            item.workFunction_ = ReadDirEntriesWork;
+            
+            Vector<DirScanTask>::Iterator start = tasks.Begin();
+            while (start != tasks.End())
+            {
+                Vector<DirScanTask>::Iterator end = tasks.End();
+                if (end - start > DIRS_PER_WORK_ITEM)
+                    end = start + DIRS_PER_WORK_ITEM;
+                
+                item.start_ = &(*start);
+                item.end_ = &(*end);
+                queue->AddWorkItem(item);
+                
+                start = end;
+            }
+            
+            queue->Complete(M_MAX_UNSIGNED);
+        }
+        else
+        {
+            for (unsigned i = 0; i < tasks.Size(); ++i)
+                tasks[i].success_ = ReadDirEntries(tasks[i].path_, tasks[i].entries_);
+        }
+        
+        pending.Clear();
+        for (unsigned i = 0; i < tasks.Size(); ++i)
+        {
+            const DirScanTask& task = tasks[i];
+            if (!task.success_)
+            {
+                if (task.path_ == rootPath)
+                    return false;
+                continue;
+            }
+            
+            for (unsigned j = 0; j < task.entries_.Size(); ++j)
+            {
+                if (task.entries_[j].directory_)
+                    pending.Push(task.path_ + task.entries_[j].name_ + "/");
+            }
+            dirs[GetIndexKey(task.path_)] = task.entries_;
+        }
+    }
+    
+    return true;
+}
+
+/// Collect the non-hidden file names of a directory tree that has been read, relative to the tree root.
+static void CollectDirTreeFiles(const HashMap<String, Vector<DirIndexEntry> >& dirs, const String& key, const String& relativePath,
+    Vector<String>& fileNames)
+{
+    HashMap<String, Vector<DirIndexEntry> >::ConstIterator i = dirs.Find(key);
+    if (i == dirs.End())
+        return;
+    
+    const Vector<DirIndexEntry>& entries = i->second_;
+    for (unsigned j = 0; j < entries.Size(); ++j)
+    {
+        const DirIndexEntry& entry = entries[j];
+        if (entry.hidden_)
+            continue;
+        
+        if (entry.directory_)
+            CollectDirTreeFiles(dirs, key + GetIndexKey(entry.name_) + "/", relativePath + entry.name_ + "/", fileNames);
+        else
+            fileNames.Push(relativePath + entry.name_);
+    }
+}
+
 OBJECTTYPESTATIC(FileSystem);
 
 FileSystem::FileSystem(Context* context) :
@@ -114,7 +307,10 @@ bool FileSystem::CreateDir(const String& pathName)
     #endif
     
     if (success)
+    {
+        RefreshIndexedPath(pathName);
         LOGDEBUG("Created directory " + pathName);
+    }
     else
         LOGERROR("Failed to create directory " + pathName);
     
@@ -273,10 +469,18 @@ bool FileSystem::Rename(const String& srcFileName, const String& destFileName)
     }
     
     #ifdef WIN32
-    return MoveFileW(GetWideNativePath(srcFileName).CString(), GetWideNativePath(destFileName).CString()) != 0;
+    bool success = MoveFileW(GetWideNativePath(srcFileName).CString(), GetWideNativePath(destFileName).CString()) != 0;
     #else
-    return rename(GetNativePath(srcFileName).CString(), GetNativePath(destFileName).CString()) == 0;
+    bool success = rename(GetNativePath(srcFileName).CString(), GetNativePath(destFileName).CString()) == 0;
     #endif
+    
+    if (success)
+    {
+        RefreshIndexedPath(srcFileName);
+        RefreshIndexedPath(destFileName);
+    }
+    
+    return success;
 }
 
 bool FileSystem::Delete(const String& fileName)
@@ -288,10 +492,15 @@ bool FileSystem::Delete(const String& fileName)
     }
     
     #ifdef WIN32
-    return DeleteFileW(GetWideNativePath(fileName).CString()) != 0;
+    bool success = DeleteFileW(GetWideNativePath(fileName).CString()) != 0;
     #else
-    return remove(GetNativePath(fileName).CString()) == 0;
+    bool success = remove(GetNativePath(fileName).CString()) == 0;
     #endif
+    
+    if (success)
+        RefreshIndexedPath(fileName);
+    
+    return success;
 }
 
 String FileSystem::GetCurrentDir() const
@@ -363,6 +572,18 @@ bool FileSystem::FileExists(const String& fileName) const
     if (!CheckAccess(GetPath(fileName)))
         return false;
     
+    {
+        MutexLock lock(indexMutex_);
+        if (!indexRoots_.Empty())
+        {
+            // Files written by other means than File or FileSystem are missing from the index unless a watcher
+            // has seen them, so check the disk on a miss
+            String key = GetIndexKey(RemoveTrailingSlash(fileName));
+            if (IsIndexedInternal(key) && (fileIndex_.Contains(key) || IsWatchedInternal(key)))
+                return fileIndex_.Contains(key);
+        }
+    }
+    
     String fixedName = GetNativePath(RemoveTrailingSlash(fileName));
     
     #ifdef ANDROID
@@ -402,7 +623,17 @@ bool FileSystem::DirExists(const String& pathName) const
     if (pathName == "/")
 	return true;
     #endif
-
+    
+    {
+        MutexLock lock(indexMutex_);
+        if (!indexRoots_.Empty())
+        {
+            String key = GetIndexKey(AddTrailingSlash(pathName));
+            if (IsIndexedInternal(key) && (dirIndex_.Contains(key) || IsWatchedInternal(key)))
+                return dirIndex_.Contains(key);
+        }
+    }
+    
     String fixedName = GetNativePath(RemoveTrailingSlash(pathName));
 
     #ifdef ANDROID
@@ -435,6 +666,12 @@ void FileSystem::ScanDir(Vector<String>& result, const String& pathName, const S
     }
 }
 
+bool FileSystem::IsIndexed(const String& pathName) const
+{
+    MutexLock lock(indexMutex_);
+    return IsIndexedInternal(GetIndexKey(pathName));
+}
+
 String FileSystem::GetProgramDir() const
 {
     #if defined(ANDROID)
@@ -493,6 +730,150 @@ void FileSystem::RegisterPath(const String& pathName)
     allowedPaths_.Insert(AddTrailingSlash(pathName));
 }
 
+bool FileSystem::IndexDir(const String& pathName)
+{
+    Vector<String> fileNames;
+    return IndexDir(pathName, fileNames);
+}
+
+bool FileSystem::IndexDir(const String& pathName, Vector<String>& fileNames)
+{
+    fileNames.Clear();
+    
+    if (!CheckAccess(pathName))
+    {
+        LOGERROR("Access denied to " + pathName);
+        return false;
+    }
+    
+    String rootPath = AddTrailingSlash(pathName);
+    
+    // The work queue may only be used from the main thread
+    HashMap<String, Vector<DirIndexEntry> > dirs;
+    if (!ReadDirTree(rootPath, dirs, Thread::IsMainThread() ? GetSubsystem<WorkQueue>() : 0))
+    {
+        LOGERROR("Could not index directory " + pathName);
+        return false;
+    }
+    
+    {
+        MutexLock lock(indexMutex_);
+        
+        String rootKey = GetIndexKey(rootPath);
+        RemoveFromIndex(rootKey);
+        AddToIndex(dirs);
+        if (!indexRoots_.Contains(rootKey))
+            indexRoots_.Push(rootKey);
+    }
+    
+    CollectDirTreeFiles(dirs, GetIndexKey(rootPath), String::EMPTY, fileNames);
+    
+    LOGDEBUG("Indexed " + String(dirs.Size()) + " directories in " + rootPath);
+    return true;
+}
+
+void FileSystem::RemoveIndexedDir(const String& pathName)
+{
+    MutexLock lock(indexMutex_);
+    
+    String rootKey = GetIndexKey(AddTrailingSlash(pathName));
+    if (!indexRoots_.Remove(rootKey))
+        return;
+    
+    // Keep the contents if still inside another indexed directory
+    if (!IsIndexedInternal(rootKey))
+        RemoveFromIndex(rootKey);
+}
+
+void FileSystem::RefreshIndexedPath(const String& pathName)
+{
+    String fixedPath = RemoveTrailingSlash(GetInternalPath(pathName));
+    String key = GetIndexKey(fixedPath);
+    
+    {
+        MutexLock lock(indexMutex_);
+        if (!IsIndexedInternal(key))
+            return;
+    }
+    
+    // Access the disk before locking the index, as a new directory may need to be scanned
+    DirIndexEntry entry;
+    HashMap<String, Vector<DirIndexEntry> > dirs;
+    bool exists = ReadPathEntry(fixedPath, entry);
+    if (exists && entry.directory_)
+        ReadDirTree(fixedPath + "/", dirs, 0);
+    
+    MutexLock lock(indexMutex_);
+    
+    // If the parent directory is not indexed, it is yet to be refreshed itself
+    String parentKey = GetIndexKey(GetPath(fixedPath));
+    HashMap<String, Vector<DirIndexEntry> >::Iterator parent = dirIndex_.Find(parentKey);
+    if (parent == dirIndex_.End())
+        return;
+    
+    bool wasDirectory = false;
+    Vector<DirIndexEntry>& entries = parent->second_;
+    for (Vector<DirIndexEntry>::Iterator i = entries.Begin(); i != entries.End(); ++i)
+    {
+        if (parentKey + GetIndexKey(i->name_) == key)
+        {
+            wasDirectory = i->directory_;
+            entries.Erase(i);
+            break;
+        }
+    }
+    
+    // Only a directory has a subtree to remove. Walk it instead of searching the whole index
+    fileIndex_.Erase(key);
+    String dirKey = key + "/";
+    if (wasDirectory || dirIndex_.Contains(dirKey))
+        RemoveSubtreeFromIndex(dirKey);
+    
+    if (exists)
+    {
+        entries.Push(entry);
+        if (entry.directory_)
+            AddToIndex(dirs);
+        else
+            fileIndex_.Insert(key);
+    }
+}
+
+void FileSystem::AddIndexWatcher(const String& pathName)
+{
+    String rootPath = AddTrailingSlash(pathName);
+    String rootKey = GetIndexKey(rootPath);
+    
+    // If the tree is indexed later, the index is read while already watched. Otherwise files may have been written by
+    // other means since the tree was indexed, so read it again now that it is watched
+    bool indexed;
+    {
+        MutexLock lock(indexMutex_);
+        indexed = IsIndexedInternal(rootKey);
+    }
+    
+    HashMap<String, Vector<DirIndexEntry> > dirs;
+    if (indexed && !ReadDirTree(rootPath, dirs, Thread::IsMainThread() ? GetSubsystem<WorkQueue>() : 0))
+        return;
+    
+    MutexLock lock(indexMutex_);
+    if (indexed)
+    {
+        RemoveFromIndex(rootKey);
+        AddToIndex(dirs);
+    }
+    ++indexWatchers_[rootKey];
+}
+
+void FileSystem::RemoveIndexWatcher(const String& pathName)
+{
+    MutexLock lock(indexMutex_);
+    
+    HashMap<String, unsigned>::Iterator i = indexWatchers_.Find(GetIndexKey(AddTrailingSlash(pathName)));
+    if (i != indexWatchers_.End() && !--i->second_)
+        indexWatchers_.Erase(i);
+}
+
 void FileSystem::ScanDirInternal(Vector<String>& result, String path, const String& startPath,
     const String& filter, unsigned flags, bool recursive) const
 {
@@ -505,70 +886,135 @@ void FileSystem::ScanDirInternal(Vector<String>& result, String path, const Stri
     if (filterExtension.Contains('*'))
         filterExtension.Clear();
     
-    #ifdef WIN32
-    WIN32_FIND_DATAW info;
-    HANDLE handle = FindFirstFileW(WString(path + "*").CString(), &info);
-    if (handle != INVALID_HANDLE_VALUE)
+    // Use the directory index if a watcher keeps it current, else read from disk
+    Vector<DirIndexEntry> entries;
+    bool indexed = false;
+    bool found = false;
     {
-        do
+        MutexLock lock(indexMutex_);
+        if (!indexRoots_.Empty())
         {
-            String fileName(info.cFileName);
-            if (!fileName.Empty())
+            String key = GetIndexKey(path);
+            if (IsIndexedInternal(key) && IsWatchedInternal(key))
             {
-                if (info.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN && !(flags & SCAN_HIDDEN))
-                    continue;
-                if (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                indexed = true;
+                HashMap<String, Vector<DirIndexEntry> >::ConstIterator i = dirIndex_.Find(key);
+                if (i != dirIndex_.End())
                 {
-                    if (flags & SCAN_DIRS)
-                        result.Push(deltaPath + fileName);
-                    if (recursive && fileName != "." && fileName != "..")
-                        ScanDirInternal(result, path + fileName, startPath, filter, flags, recursive);
-                }
-                else if (flags & SCAN_FILES)
-                {
-                    if (filterExtension.Empty() || fileName.EndsWith(filterExtension))
-                        result.Push(deltaPath + fileName);
+                    entries = i->second_;
+                    found = true;
                 }
             }
-        } 
-        while (FindNextFileW(handle, &info));
+        }
+    }
+    if (!indexed)
+        found = ReadDirEntries(path, entries);
+    if (!found)
+        return;
+    
+    if (flags & SCAN_DIRS)
+    {
+        result.Push(deltaPath + ".");
+        result.Push(deltaPath + "..");
+    }
+    
+    for (unsigned i = 0; i < entries.Size(); ++i)
+    {
+        const DirIndexEntry& entry = entries[i];
+        if (entry.hidden_ && !(flags & SCAN_HIDDEN))
+            continue;
         
-        FindClose(handle);
+        if (entry.directory_)
+        {
+            if (flags & SCAN_DIRS)
+                result.Push(deltaPath + entry.name_);
+            if (recursive)
+                ScanDirInternal(result, path + entry.name_, startPath, filter, flags, recursive);
+        }
+        else if (flags & SCAN_FILES)
+        {
+            if (filterExtension.Empty() || entry.name_.EndsWith(filterExtension))
+                result.Push(deltaPath + entry.name_);
+        }
     }
-    #else
-    DIR *dir;
-    struct dirent *de;
-    struct stat st;
-    dir = opendir(GetNativePath(path).CString());
-    if (dir)
+}
+
+bool FileSystem::IsIndexedInternal(const String& key) const
+{
+    // Paths with relative components can not be matched against the index
+    if (key.Contains("./"))
+        return false;
+    
+    for (unsigned i = 0; i < indexRoots_.Size(); ++i)
+    {
+        if (key.StartsWith(indexRoots_[i]))
+            return true;
+    }
+    
+    return false;
+}
+
+bool FileSystem::IsWatchedInternal(const String& key) const
+{
+    for (HashMap<String, unsigned>::ConstIterator i = indexWatchers_.Begin(); i != indexWatchers_.End(); ++i)
+    {
+        if (key.StartsWith(i->first_))
+            return true;
+    }
+    
+    return false;
+}
+
+void FileSystem::AddToIndex(const HashMap<String, Vector<DirIndexEntry> >& dirs)
+{
+    for (HashMap<String, Vector<DirIndexEntry> >::ConstIterator i = dirs.Begin(); i != dirs.End(); ++i)
     {
-        while ((de = readdir(dir)))
+        dirIndex_[i->first_] = i->second_;
+        for (unsigned j = 0; j < i->second_.Size(); ++j)
         {
-            /// \todo Filename may be unnormalized Unicode on Mac OS X. Re-normalize as necessary
-            String fileName(de->d_name);
-            bool normalEntry = fileName != "." && fileName != "..";
-            if (normalEntry && !(flags & SCAN_HIDDEN) && fileName.StartsWith("."))
-                continue;
-            String pathAndName = path + fileName;
-            if (!stat(pathAndName.CString(), &st))
-            {
-                if (st.st_mode & S_IFDIR)
-                {
-                    if (flags & SCAN_DIRS)
-                        result.Push(deltaPath + fileName);
-                    if (recursive && normalEntry)
-                        ScanDirInternal(result, path + fileName, startPath, filter, flags, recursive);
-                }
-                else if (flags & SCAN_FILES)
-                {
-                    if (filterExtension.Empty() || fileName.EndsWith(filterExtension))
-                        result.Push(deltaPath + fileName);
-                }
-            }
+            if (!i->second_[j].directory_)
+                fileIndex_.Insert(i->first_ + GetIndexKey(i->second_[j].name_));
         }
-        closedir(dir);
     }
-    #endif
+}
+
+void FileSystem::RemoveSubtreeFromIndex(const String& key)
+{
+    HashMap<String, Vector<DirIndexEntry> >::Iterator i = dirIndex_.Find(key);
+    if (i == dirIndex_.End())
+        return;
+    
+    // Take the entries before erasing the directory, then remove its files and subdirectories
+    Vector<DirIndexEntry> entries;
+    entries.Swap(i->second_);
+    dirIndex_.Erase(i);
+    
+    for (unsigned j = 0; j < entries.Size(); ++j)
+    {
+        String entryKey = key + GetIndexKey(entries[j].name_);
+        if (entries[j].directory_)
+            RemoveSubtreeFromIndex(entryKey + "/");
+        else
+            fileIndex_.Erase(entryKey);
+    }
+}
+
+void FileSystem::RemoveFromIndex(const String& key)
+{
+    for (HashMap<String, Vector<DirIndexEntry> >::Iterator i = dirIndex_.Begin(); i != dirIndex_.End();)
+    {
+        if (i->first_.StartsWith(key))
+            i = dirIndex_.Erase(i);
+        else
+            ++i;
+    }
+    for (HashSet<String>::Iterator i = fileIndex_.Begin(); i != fileIndex_.End();)
+    {
+        if (i->StartsWith(key))
+            i = fileIndex_.Erase(i);
+        else
+            ++i;
+    }
 }
 
 void SplitPath(const String& fullPath, String& pathName, String& fileName, String& extension)
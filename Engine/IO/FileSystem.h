@@ -24,6 +24,7 @@
 
 #include "Object.h"
 #include "HashSet.h"
+#include "Mutex.h"
 
 namespace Urho3D
 {
@@ -35,6 +36,30 @@ static const unsigned SCAN_DIRS = 0x2;
 /// Return also hidden files.
 static const unsigned SCAN_HIDDEN = 0x4;
 
+/// %Directory entry in the directory index.
+struct DirIndexEntry
+{
+    /// Construct undefined.
+    DirIndexEntry()
+    {
+    }
+    
+    /// Construct with values.
+    DirIndexEntry(const String& name, bool directory, bool hidden) :
+        name_(name),
+        directory_(directory),
+        hidden_(hidden)
+    {
+    }
+    
+    /// File or directory name without path.
+    String name_;
+    /// Directory flag.
+    bool directory_;
+    /// Hidden flag.
+    bool hidden_;
+};
+
 /// Subsystem for file and directory operations and access control.
 class FileSystem : public Object
 {
@@ -64,6 +89,18 @@ public:
     bool Delete(const String& fileName);
     /// Register a path as allowed to access. If no paths are registered, all are allowed.
     void RegisterPath(const String& pathName);
+    /// Scan a directory tree into the in-memory directory index, using worker threads if available. Afterward existence checks inside it that find the path do not access the disk. Misses and scans use the index only while a file watcher keeps it current. Return true if successful.
+    bool IndexDir(const String& pathName);
+    /// Index a directory tree and return the names of its non-hidden files relative to it, as a recursive scan would, without reading the tree twice. Return true if successful.
+    bool IndexDir(const String& pathName, Vector<String>& fileNames);
+    /// Remove a directory tree from the directory index.
+    void RemoveIndexedDir(const String& pathName);
+    /// Update the directory index after a file or directory has been created, deleted or renamed. No-op if the path is not inside an indexed directory. Can be called from any thread.
+    void RefreshIndexedPath(const String& pathName);
+    /// Register a recursive file watcher that keeps the directory index current for a directory tree. If the tree is already indexed, read it again. Called by FileWatcher.
+    void AddIndexWatcher(const String& pathName);
+    /// Unregister a file watcher of the directory index. Called by FileWatcher.
+    void RemoveIndexWatcher(const String& pathName);
     
     /// Return the absolute current working directory.
     String GetCurrentDir() const;
@@ -77,6 +114,8 @@ public:
     bool FileExists(const String& fileName) const;
     /// Check if a directory exists.
     bool DirExists(const String& pathName) const;
+    /// Check if a path is inside an indexed directory.
+    bool IsIndexed(const String& pathName) const;
     /// Scan a directory for specified files.
     void ScanDir(Vector<String>& result, const String& pathName, const String& filter, unsigned flags, bool recursive) const;
     /// Return the program's directory.
@@ -87,9 +126,29 @@ public:
 private:
     /// Scan directory, called internally.
     void ScanDirInternal(Vector<String>& result, String path, const String& startPath, const String& filter, unsigned flags, bool recursive) const;
+    /// Return whether an index key is inside an indexed directory. Index mutex must be held.
+    bool IsIndexedInternal(const String& key) const;
+    /// Return whether an index key is inside a directory watched for changes. Index mutex must be held.
+    bool IsWatchedInternal(const String& key) const;
+    /// Add scanned directories to the index. Index mutex must be held.
+    void AddToIndex(const HashMap<String, Vector<DirIndexEntry> >& dirs);
+    /// Remove a directory and its subdirectories from the index. Index mutex must be held.
+    void RemoveFromIndex(const String& key);
+    /// Remove a directory and its subdirectories from the index by walking the indexed entries, without searching the whole index. Index mutex must be held.
+    void RemoveSubtreeFromIndex(const String& key);
     
     /// Allowed directories.
     HashSet<String> allowedPaths_;
+    /// Indexed root directories.
+    Vector<String> indexRoots_;
+    /// Indexed directory contents by path.
+    HashMap<String, Vector<DirIndexEntry> > dirIndex_;
+    /// Indexed file paths.
+    HashSet<String> fileIndex_;
+    /// Directories kept current by file watchers, with watcher counts.
+    HashMap<String, unsigned> indexWatchers_;
+    /// Directory index mutex.
+    mutable Mutex indexMutex_;
 };
 
 /// Split a full path to path, filename and extension. The extension will be converted to lowercase.
@@ -45,12 +45,16 @@ namespace Urho3D
 {
 
 static const unsigned BUFFERSIZE = 4096;
+static const float DEFAULT_DELAY = 0.5f;
+/// Maximum time a batch of file changes is held back if changes keep arriving, as a multiple of the delay.
+static const unsigned MAX_BATCH_DELAY_MULTIPLIER = 10;
 
 OBJECTTYPESTATIC(FileWatcher);
 
 FileWatcher::FileWatcher(Context* context) :
     Object(context),
     fileSystem_(GetSubsystem<FileSystem>()),
+    delay_(DEFAULT_DELAY),
     watchSubDirs_(false)
 {
 #if defined(ENABLE_FILEWATCHER)
@@ -101,6 +105,8 @@ bool FileWatcher::StartWatching(const String& pathName, bool watchSubDirs)
         path_ = AddTrailingSlash(pathName);
         watchSubDirs_ = watchSubDirs;
         Start();
+        if (watchSubDirs_)
+            fileSystem_->AddIndexWatcher(path_);
         
         LOGDEBUG("Started watching path " + pathName);
         return true;
@@ -150,6 +156,8 @@ bool FileWatcher::StartWatching(const String& pathName, bool watchSubDirs)
             }
         }
         Start();
+        if (watchSubDirs_)
+            fileSystem_->AddIndexWatcher(path_);
 
         LOGDEBUG("Started watching path " + pathName);
         return true;
@@ -167,6 +175,8 @@ bool FileWatcher::StartWatching(const String& pathName, bool watchSubDirs)
         path_ = AddTrailingSlash(pathName);
         watchSubDirs_ = watchSubDirs;
         Start();
+        if (watchSubDirs_)
+            fileSystem_->AddIndexWatcher(path_);
         
         LOGDEBUG("Started watching path " + pathName);
         return true;
@@ -192,6 +202,9 @@ void FileWatcher::StopWatching()
     {
         shouldRun_ = false;
         
+        if (watchSubDirs_ && fileSystem_)
+            fileSystem_->RemoveIndexWatcher(path_);
+        
         // Create and delete a dummy file to make sure the watcher loop terminates
         String dummyFileName = path_ + "dummy.tmp";
         File file(context_, dummyFileName, FILE_WRITE);
@@ -230,6 +243,7 @@ void FileWatcher::ThreadFunction()
             BUFFERSIZE,
             watchSubDirs_,
             FILE_NOTIFY_CHANGE_FILE_NAME |
+            FILE_NOTIFY_CHANGE_DIR_NAME |
             FILE_NOTIFY_CHANGE_LAST_WRITE,
             &bytesFilled,
             0,
@@ -241,17 +255,20 @@ void FileWatcher::ThreadFunction()
             {
                 FILE_NOTIFY_INFORMATION* record = (FILE_NOTIFY_INFORMATION*)&buffer[offset];
                 
+                String fileName;
+                const wchar_t* src = record->FileName;
+                const wchar_t* end = src + record->FileNameLength / 2;
+                while (src < end)
+                    fileName.AppendUTF8(String::DecodeUTF16(src));
+                
+                fileName = GetInternalPath(fileName);
+                
+                // Keep the filesystem's directory index up to date
+                if (record->Action != FILE_ACTION_MODIFIED)
+                    fileSystem_->RefreshIndexedPath(path_ + fileName);
+                
                 if (record->Action == FILE_ACTION_MODIFIED || record->Action == FILE_ACTION_RENAMED_NEW_NAME)
-                {
-                    String fileName;
-                    const wchar_t* src = record->FileName;
-                    const wchar_t* end = src + record->FileNameLength / 2;
-                    while (src < end)
-                        fileName.AppendUTF8(String::DecodeUTF16(src));
-                    
-                    fileName = GetInternalPath(fileName);
                     AddChange(fileName);
-                }
                 
                 if (!record->NextEntryOffset)
                     break;
@@ -277,12 +294,24 @@ void FileWatcher::ThreadFunction()
 
             if (event->len > 0)
             {
-                if (event->mask & IN_MODIFY || event->mask & IN_MOVE)
+                String fileName;
+                fileName = dirHandle_[event->wd] + event->name;
+                
+                // Keep the filesystem's directory index up to date
+                if (event->mask & (IN_CREATE | IN_DELETE | IN_MOVE))
+                    fileSystem_->RefreshIndexedPath(path_ + fileName);
+                
+                // Watch new subdirectories as they are created
+                if (watchSubDirs_ && event->mask & IN_ISDIR && event->mask & (IN_CREATE | IN_MOVED_TO))
                 {
-                    String fileName;
-                    fileName = dirHandle_[event->wd] + event->name;
-                    AddChange(fileName);
+                    int handle = inotify_add_watch(watchHandle_, (path_ + fileName).CString(), IN_CREATE|IN_DELETE|IN_MODIFY|
+                        IN_MOVED_FROM|IN_MOVED_TO);
+                    if (handle >= 0)
+                        dirHandle_[handle] = AddTrailingSlash(fileName);
                 }
+                
+                if (event->mask & IN_MODIFY || event->mask & IN_MOVE)
+                    AddChange(fileName);
             }
 
             i += sizeof(inotify_event) + event->len;
@@ -298,34 +327,71 @@ void FileWatcher::ThreadFunction()
         {
             Vector<String> fileNames = changes.Split(1);
             for (unsigned i = 0; i < fileNames.Size(); ++i)
+            {
+                fileSystem_->RefreshIndexedPath(path_ + fileNames[i]);
                 AddChange(fileNames[i]);
+            }
         }
     }
 #endif
 #endif
 }
 
+void FileWatcher::SetDelay(float interval)
+{
+    delay_ = Max(interval, 0.0f);
+}
+
 void FileWatcher::AddChange(const String& fileName)
 {
     MutexLock lock(changesMutex_);
     
-    // If we have 2 unprocessed modifies in a row into the same file, only record the first
-    if (changes_.Empty() || changes_.Back() != fileName)
-        changes_.Push(fileName);
+    if (changes_.Empty())
+        firstChangeTimer_.Reset();
+    lastChangeTimer_.Reset();
+    
+    // Reset the timer of an already buffered change to combine it with the new one
+    changes_[fileName].Reset();
 }
 
 bool FileWatcher::GetNextChange(String& dest)
 {
     MutexLock lock(changesMutex_);
     
-    if (changes_.Empty())
-        return false;
-    else
+    unsigned delayMsec = (unsigned)(delay_ * 1000.0f);
+    
+    for (HashMap<String, Timer>::Iterator i = changes_.Begin(); i != changes_.End(); ++i)
     {
-        dest = changes_.Front();
-        changes_.Erase(changes_.Begin());
-        return true;
+        if (i->second_.GetMSec(false) >= delayMsec)
+        {
+            dest = i->first_;
+            changes_.Erase(i);
+            return true;
+        }
     }
+    
+    return false;
+}
+
+bool FileWatcher::GetChanges(Vector<String>& dest)
+{
+    MutexLock lock(changesMutex_);
+    
+    dest.Clear();
+    if (changes_.Empty())
+        return false;
+    
+    // Hold back the batch while changes keep arriving, but not indefinitely
+    unsigned delayMsec = (unsigned)(delay_ * 1000.0f);
+    if (lastChangeTimer_.GetMSec(false) < delayMsec && firstChangeTimer_.GetMSec(false) < delayMsec *
+        MAX_BATCH_DELAY_MULTIPLIER)
+        return false;
+    
+    dest.Reserve(changes_.Size());
+    for (HashMap<String, Timer>::ConstIterator i = changes_.Begin(); i != changes_.End(); ++i)
+        dest.Push(i->first_);
+    changes_.Clear();
+    return true;
 }
 
 }
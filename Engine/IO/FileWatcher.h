@@ -22,10 +22,10 @@
 
 #pragma once
 
-#include "List.h"
 #include "Mutex.h"
 #include "Object.h"
 #include "Thread.h"
+#include "Timer.h"
 
 namespace Urho3D
 {
@@ -50,23 +50,35 @@ public:
     bool StartWatching(const String& pathName, bool watchSubDirs);
     /// Stop watching the directory.
     void StopWatching();
+    /// Set the delay in seconds before file changes are returned. Repeated changes to the same file within the delay are combined.
+    void SetDelay(float interval);
     /// Add a file change into the changes queue.
     void AddChange(const String& fileName);
-    /// Return a file change (true if was found, false if not.)
+    /// Return a file change whose delay has elapsed (true if was found, false if not.)
     bool GetNextChange(String& dest);
+    /// Return all buffered file changes at once after no changes have been added within the delay. Each file is returned only once. Return true if there were changes.
+    bool GetChanges(Vector<String>& dest);
     
     /// Return the path being watched, or empty if not watching.
     const String& GetPath() const { return path_; }
+    /// Return the delay in seconds before file changes are returned.
+    float GetDelay() const { return delay_; }
     
 private:
     /// Filesystem.
     SharedPtr<FileSystem> fileSystem_;
     /// The path being watched.
     String path_;
-    /// Buffered file changes.
-    List<String> changes_;
+    /// Buffered file changes and the time since each was last changed.
+    HashMap<String, Timer> changes_;
+    /// Time since the last file change.
+    Timer lastChangeTimer_;
+    /// Time since the oldest buffered file change.
+    Timer firstChangeTimer_;
     /// Mutex for the change buffer.
     Mutex changesMutex_;
+    /// Delay in seconds before file changes are returned.
+    float delay_;
     /// Watch subdirectories flag.
     bool watchSubDirs_;
 
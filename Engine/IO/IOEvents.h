@@ -33,4 +33,12 @@ EVENT(E_LOGMESSAGE, LogMessage)
     PARAM(P_MESSAGE, Message);              // String
 }
 
+/// Asynchronous read request completed. Sent from the main thread.
+EVENT(E_IOREQUESTCOMPLETED, IORequestCompleted)
+{
+    PARAM(P_REQUEST, Request);              // IORequest pointer
+    PARAM(P_FILENAME, FileName);            // String
+    PARAM(P_SUCCESS, Success);              // bool
+}
+
 }
@@ -0,0 +1,435 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Precompiled.h"
+#include "Condition.h"
+#include "CoreEvents.h"
+#include "File.h"
+#include "IOEvents.h"
+#include "IOQueue.h"
+#include "PackageFile.h"
+#include "Profiler.h"
+#include "Thread.h"
+#include "Timer.h"
+
+#include <cstring>
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned MAX_NONTHREADED_IO_USEC = 1000;
+static const unsigned DEFAULT_MAX_COALESCED_SIZE = 4 * 1024 * 1024;
+static const unsigned DEFAULT_MAX_COALESCE_GAP = 16 * 1024;
+
+/// I/O thread managed by the I/O queue.
+class IOThread : public Thread, public RefCounted
+{
+public:
+    /// Construct.
+    IOThread(IOQueue* owner) :
+        owner_(owner)
+    {
+    }
+    
+    /// Service requests until stopped, sleeping while the queue is empty.
+    virtual void ThreadFunction()
+    {
+        while (shouldRun_)
+        {
+            if (!owner_->ProcessNextRequest())
+                wakeup_.Wait();
+        }
+    }
+    
+    /// Wake up the thread to check the queue.
+    void Wakeup()
+    {
+        wakeup_.Set();
+    }
+    
+    /// Stop the thread and wait for it to finish.
+    void Shutdown()
+    {
+        shouldRun_ = false;
+        wakeup_.Set();
+        Stop();
+    }
+    
+private:
+    /// I/O queue.
+    IOQueue* owner_;
+    /// Condition for waking up when requests are queued.
+    Condition wakeup_;
+};
+
+IORequest::IORequest() :
+    offset_(0),
+    size_(M_MAX_UNSIGNED),
+    priority_(0),
+    sendEvent_(false),
+    successful_(false),
+    completed_(false)
+{
+}
+
+OBJECTTYPESTATIC(IOQueue);
+
+IOQueue::IOQueue(Context* context) :
+    Object(context),
+    maxCoalescedSize_(DEFAULT_MAX_COALESCED_SIZE),
+    maxCoalesceGap_(DEFAULT_MAX_COALESCE_GAP)
+{
+    SubscribeToEvent(E_BEGINFRAME, HANDLER(IOQueue, HandleBeginFrame));
+}
+
+IOQueue::~IOQueue()
+{
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        threads_[i]->Shutdown();
+}
+
+void IOQueue::CreateThreads(unsigned numThreads)
+{
+    // Allow creating the threads only once, like in WorkQueue
+    if (!threads_.Empty())
+        return;
+    
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        SharedPtr<IOThread> thread(new IOThread(this));
+        thread->Start();
+        threads_.Push(thread);
+    }
+}
+
+SharedPtr<IORequest> IOQueue::Read(const String& fileName, unsigned offset, unsigned size, unsigned priority, bool sendEvent)
+{
+    return Read(0, fileName, offset, size, priority, sendEvent);
+}
+
+SharedPtr<IORequest> IOQueue::Read(PackageFile* package, const String& fileName, unsigned offset, unsigned size, unsigned priority, bool sendEvent)
+{
+    SharedPtr<IORequest> request(new IORequest());
+    request->fileName_ = fileName;
+    request->package_ = package;
+    request->offset_ = offset;
+    request->size_ = size;
+    request->priority_ = priority;
+    request->sendEvent_ = sendEvent;
+    requests_.Insert(request);
+    AddRequest(request);
+    return request;
+}
+
+bool IOQueue::Cancel(IORequest* request)
+{
+    if (!request)
+        return false;
+    
+    MutexLock lock(queueMutex_);
+    
+    for (List<IORequest*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
+    {
+        if (*i == request)
+        {
+            request->data_.Clear();
+            request->successful_ = false;
+            request->sendEvent_ = false;
+            request->completed_ = true;
+            queue_.Erase(i);
+            // Release at frame begin along with the completed requests
+            completedRequests_.Push(request);
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+void IOQueue::Complete(IORequest* request)
+{
+    if (!request || request->completed_)
+        return;
+    
+    PROFILE(CompleteIORequest);
+    
+    PODVector<IORequest*> batch;
+    
+    {
+        MutexLock lock(queueMutex_);
+        
+        for (List<IORequest*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
+        {
+            if (*i == request)
+            {
+                batch.Push(*i);
+                queue_.Erase(i);
+                CollectCoalescedRequests(batch);
+                break;
+            }
+        }
+    }
+    
+    // If the request was still queued, service it here, else wait for the I/O thread which is servicing it
+    if (!batch.Empty())
+        ServiceRequests(batch);
+    else
+    {
+        while (!request->completed_)
+            Time::Sleep(0);
+    }
+}
+
+void IOQueue::CompleteAll()
+{
+    PROFILE(CompleteIORequests);
+    
+    while (ProcessNextRequest())
+    {
+    }
+    
+    // Wait for the I/O threads to finish the requests they are servicing
+    for (;;)
+    {
+        {
+            MutexLock lock(queueMutex_);
+            if (queue_.Empty() && activeRequests_.Empty())
+                break;
+        }
+        
+        Time::Sleep(0);
+    }
+}
+
+void IOQueue::SetMaxCoalescedSize(unsigned size)
+{
+    maxCoalescedSize_ = size;
+}
+
+void IOQueue::SetMaxCoalesceGap(unsigned gap)
+{
+    maxCoalesceGap_ = gap;
+}
+
+unsigned IOQueue::GetNumQueuedRequests() const
+{
+    MutexLock lock(queueMutex_);
+    return queue_.Size();
+}
+
+void IOQueue::AddRequest(IORequest* request)
+{
+    {
+        MutexLock lock(queueMutex_);
+        
+        // Insert after requests with the same or higher priority to keep the order of equal priority requests
+        List<IORequest*>::Iterator i = queue_.Begin();
+        while (i != queue_.End() && (*i)->priority_ >= request->priority_)
+            ++i;
+        queue_.Insert(i, request);
+    }
+    
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        threads_[i]->Wakeup();
+}
+
+bool IOQueue::ProcessNextRequest()
+{
+    PODVector<IORequest*> batch;
+    
+    {
+        MutexLock lock(queueMutex_);
+        
+        if (queue_.Empty())
+            return false;
+        
+        batch.Push(queue_.Front());
+        queue_.PopFront();
+        CollectCoalescedRequests(batch);
+    }
+    
+    ServiceRequests(batch);
+    return true;
+}
+
+void IOQueue::CollectCoalescedRequests(PODVector<IORequest*>& batch)
+{
+    IORequest* first = batch.Front();
+    unsigned start = first->offset_;
+    unsigned end = first->GetEnd();
+    
+    // Repeat until no more requests can be merged, as each merge may extend the range to reach further requests
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        
+        for (List<IORequest*>::Iterator i = queue_.Begin(); i != queue_.End();)
+        {
+            IORequest* request = *i;
+            if (request->package_ != first->package_ || request->fileName_ != first->fileName_)
+            {
+                ++i;
+                continue;
+            }
+            
+            unsigned requestEnd = request->GetEnd();
+            unsigned gapStart = end < M_MAX_UNSIGNED - maxCoalesceGap_ ? end + maxCoalesceGap_ : M_MAX_UNSIGNED;
+            unsigned gapEnd = requestEnd < M_MAX_UNSIGNED - maxCoalesceGap_ ? requestEnd + maxCoalesceGap_ : M_MAX_UNSIGNED;
+            unsigned newStart = request->offset_ < start ? request->offset_ : start;
+            unsigned newEnd = requestEnd > end ? requestEnd : end;
+            
+            // Merge if the ranges overlap or are close enough, and the combined read does not get too large. Reads
+            // until the end of file are not limited, as their size is not known
+            if (request->offset_ <= gapStart && start <= gapEnd && (newEnd == M_MAX_UNSIGNED ||
+                newEnd - newStart <= maxCoalescedSize_))
+            {
+                start = newStart;
+                end = newEnd;
+                batch.Push(*i);
+                i = queue_.Erase(i);
+                merged = true;
+            }
+            else
+                ++i;
+        }
+    }
+    
+    activeRequests_.Push(batch);
+}
+
+void IOQueue::ServiceRequests(PODVector<IORequest*>& batch)
+{
+    IORequest* first = batch.Front();
+    unsigned start = first->offset_;
+    unsigned end = first->GetEnd();
+    for (unsigned i = 1; i < batch.Size(); ++i)
+    {
+        if (batch[i]->offset_ < start)
+            start = batch[i]->offset_;
+        if (batch[i]->GetEnd() > end)
+            end = batch[i]->GetEnd();
+    }
+    
+    SharedPtr<File> file(first->package_ ? new File(context_, first->package_, first->fileName_) : new File(context_,
+        first->fileName_));
+    unsigned fileSize = file->GetSize();
+    if (end > fileSize)
+        end = fileSize;
+    
+    // A single request is read directly into its own buffer, coalesced requests are read into a shared buffer and
+    // then copied
+    bool readSuccess = false;
+    PODVector<unsigned char> buffer;
+    if (file->IsOpen() && start <= end)
+    {
+        PODVector<unsigned char>& dest = batch.Size() == 1 ? first->data_ : buffer;
+        unsigned readSize = end - start;
+        dest.Resize(readSize);
+        file->Seek(start);
+        readSuccess = !readSize || file->Read(&dest[0], readSize) == readSize;
+    }
+    
+    file.Reset();
+    
+    for (unsigned i = 0; i < batch.Size(); ++i)
+    {
+        IORequest* request = batch[i];
+        request->successful_ = readSuccess && request->offset_ <= fileSize;
+        
+        if (!request->successful_)
+            request->data_.Clear();
+        else if (batch.Size() > 1)
+        {
+            unsigned requestEnd = request->GetEnd() < end ? request->GetEnd() : end;
+            request->data_.Resize(requestEnd - request->offset_);
+            if (requestEnd > request->offset_)
+                memcpy(&request->data_[0], &buffer[request->offset_ - start], requestEnd - request->offset_);
+        }
+    }
+    
+    {
+        MutexLock lock(queueMutex_);
+        
+        for (unsigned i = 0; i < batch.Size(); ++i)
+        {
+            batch[i]->completed_ = true;
+            activeRequests_.Remove(batch[i]);
+            completedRequests_.Push(batch[i]);
+        }
+    }
+}
+
+void IOQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
+{
+    // If no I/O threads, service requests here
+    if (threads_.Empty())
+    {
+        bool queued;
+        {
+            MutexLock lock(queueMutex_);
+            queued = !queue_.Empty();
+        }
+        
+        if (queued)
+        {
+            PROFILE(ServiceIORequestsNonthreaded);
+            
+            HiresTimer timer;
+            while (timer.GetUSec(false) < MAX_NONTHREADED_IO_USEC && ProcessNextRequest())
+            {
+            }
+        }
+    }
+    
+    PODVector<IORequest*> completed;
+    {
+        MutexLock lock(queueMutex_);
+        if (completedRequests_.Empty())
+            return;
+        completed = completedRequests_;
+        completedRequests_.Clear();
+    }
+    
+    using namespace IORequestCompleted;
+    
+    VariantMap newEventData;
+    for (unsigned i = 0; i < completed.Size(); ++i)
+    {
+        if (!completed[i]->sendEvent_)
+            continue;
+        
+        newEventData[P_REQUEST] = (void*)completed[i];
+        newEventData[P_FILENAME] = completed[i]->fileName_;
+        newEventData[P_SUCCESS] = completed[i]->successful_;
+        SendEvent(E_IOREQUESTCOMPLETED, newEventData);
+    }
+    
+    // Release the queue's references now that the I/O threads are done with the requests
+    for (unsigned i = 0; i < completed.Size(); ++i)
+        requests_.Erase(SharedPtr<IORequest>(completed[i]));
+}
+
+}
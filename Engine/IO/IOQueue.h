@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "HashSet.h"
+#include "List.h"
+#include "Mutex.h"
+#include "Object.h"
+
+namespace Urho3D
+{
+
+class IOThread;
+class PackageFile;
+
+/// Asynchronous read request. Acts as a handle which can be polled for completion.
+class IORequest : public RefCounted
+{
+    friend class IOQueue;
+    
+public:
+    /// Construct.
+    IORequest();
+    
+    /// Return file name.
+    const String& GetFileName() const { return fileName_; }
+    /// Return package file, or null if reading from the filesystem.
+    PackageFile* GetPackage() const { return package_; }
+    /// Return start offset within the file.
+    unsigned GetOffset() const { return offset_; }
+    /// Return requested size. M_MAX_UNSIGNED reads until the end of the file.
+    unsigned GetSize() const { return size_; }
+    /// Return priority.
+    unsigned GetPriority() const { return priority_; }
+    /// Return whether the request has been serviced, either successfully or not.
+    bool IsCompleted() const { return completed_; }
+    /// Return whether the read was successful. Valid after completion.
+    bool IsSuccessful() const { return successful_; }
+    /// Return the data read. Valid after completion. May be shorter than requested if the end of file was reached.
+    const PODVector<unsigned char>& GetData() const { return data_; }
+    
+private:
+    /// Return the end offset, or M_MAX_UNSIGNED if reading until the end of the file.
+    unsigned GetEnd() const { return size_ < M_MAX_UNSIGNED - offset_ ? offset_ + size_ : M_MAX_UNSIGNED; }
+    
+    /// File name.
+    String fileName_;
+    /// Package file.
+    SharedPtr<PackageFile> package_;
+    /// Start offset.
+    unsigned offset_;
+    /// Requested size.
+    unsigned size_;
+    /// Priority. Higher value = will be serviced first.
+    unsigned priority_;
+    /// Data read.
+    PODVector<unsigned char> data_;
+    /// Whether to send event on completion.
+    bool sendEvent_;
+    /// Success flag.
+    bool successful_;
+    /// Completed flag.
+    volatile bool completed_;
+};
+
+/// Asynchronous file I/O subsystem. Services read requests on dedicated I/O threads, highest priority first, and
+/// coalesces requests to adjacent or overlapping byte ranges of the same file into a single read.
+class IOQueue : public Object
+{
+    OBJECT(IOQueue);
+    
+    friend class IOThread;
+    
+public:
+    /// Construct.
+    IOQueue(Context* context);
+    /// Destruct. Stop the I/O threads; requests still queued are not serviced.
+    virtual ~IOQueue();
+    
+    /// Create I/O threads. Can only be called once. Without threads, requests are serviced in the main thread at frame begin.
+    void CreateThreads(unsigned numThreads);
+    /// Queue a read from a filesystem file and return the request. Size M_MAX_UNSIGNED reads until the end of the file.
+    SharedPtr<IORequest> Read(const String& fileName, unsigned offset = 0, unsigned size = M_MAX_UNSIGNED, unsigned priority = 0, bool sendEvent = true);
+    /// Queue a read from a file within a package file and return the request. Size M_MAX_UNSIGNED reads until the end of the file.
+    SharedPtr<IORequest> Read(PackageFile* package, const String& fileName, unsigned offset = 0, unsigned size = M_MAX_UNSIGNED, unsigned priority = 0, bool sendEvent = true);
+    /// Remove a request from the queue. Return true if it was still queued, in which case it is marked completed unsuccessfully without sending an event.
+    bool Cancel(IORequest* request);
+    /// Wait until a request has completed. If it is still queued, service it in the calling thread.
+    void Complete(IORequest* request);
+    /// Wait until all queued requests have completed.
+    void CompleteAll();
+    /// Set maximum size in bytes of a single coalesced read.
+    void SetMaxCoalescedSize(unsigned size);
+    /// Set maximum gap in bytes between two requests' byte ranges to still coalesce them into a single read.
+    void SetMaxCoalesceGap(unsigned gap);
+    
+    /// Return number of I/O threads.
+    unsigned GetNumThreads() const { return threads_.Size(); }
+    /// Return number of requests waiting to be serviced.
+    unsigned GetNumQueuedRequests() const;
+    /// Return maximum size of a single coalesced read.
+    unsigned GetMaxCoalescedSize() const { return maxCoalescedSize_; }
+    /// Return maximum gap between coalesced byte ranges.
+    unsigned GetMaxCoalesceGap() const { return maxCoalesceGap_; }
+    
+private:
+    /// Queue a request and wake up the I/O threads.
+    void AddRequest(IORequest* request);
+    /// Take the highest priority request and the requests it can be coalesced with from the queue, and service them. Return false if the queue was empty.
+    bool ProcessNextRequest();
+    /// Move requests coalescable with the first one from the queue into the batch. Queue mutex must be held.
+    void CollectCoalescedRequests(PODVector<IORequest*>& batch);
+    /// Perform a single read for a batch of requests to the same file.
+    void ServiceRequests(PODVector<IORequest*>& batch);
+    /// Handle frame start event. Service requests if no I/O threads, send completion events and release the completed requests.
+    void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+    
+    /// I/O threads.
+    Vector<SharedPtr<IOThread> > threads_;
+    /// Requests not yet released. Only accessed in the main thread, as reference counts are not thread-safe.
+    HashSet<SharedPtr<IORequest> > requests_;
+    /// Queued requests in priority order.
+    List<IORequest*> queue_;
+    /// Requests being serviced.
+    PODVector<IORequest*> activeRequests_;
+    /// Completed or cancelled requests waiting for the completion event and release.
+    PODVector<IORequest*> completedRequests_;
+    /// Mutex for the queue, the requests being serviced and the completed requests.
+    mutable Mutex queueMutex_;
+    /// Maximum size of a single coalesced read.
+    unsigned maxCoalescedSize_;
+    /// Maximum gap between coalesced byte ranges.
+    unsigned maxCoalesceGap_;
+};
+
+}
@@ -27,6 +27,7 @@
 #include "Log.h"
 #include "Mutex.h"
 #include "ProcessUtils.h"
+#include "Thread.h"
 #include "Timer.h"
 
 #include <cstdio>
@@ -167,8 +168,8 @@ void Log::Write(int level, const String& message)
             logFile_->Flush();
         }
         
-        // Log messages can be safely sent as an event only in single-instance mode
-        if (logInstances.Size() == 1)
+        // Log messages can be safely sent as an event only in single-instance mode, and only from the main thread
+        if (logInstances.Size() == 1 && Thread::IsMainThread())
         {
             inWrite_ = true;
             
@@ -215,8 +216,8 @@ void Log::WriteRaw(const String& message, bool error)
             logFile_->Flush();
         }
         
-        // Log messages can be safely sent as an event only in single-instance mode
-        if (logInstances.Size() == 1)
+        // Log messages can be safely sent as an event only in single-instance mode, and only from the main thread
+        if (logInstances.Size() == 1 && Thread::IsMainThread())
         {
             inWrite_ = true;
             
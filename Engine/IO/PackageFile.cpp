@@ -33,14 +33,20 @@ OBJECTTYPESTATIC(PackageFile);
 PackageFile::PackageFile(Context* context) :
     Object(context),
     totalSize_(0),
-    checksum_(0)
+    checksum_(0),
+    formatVersion_(0),
+    blockSize_(0),
+    compressed_(false)
 {
 }
 
 PackageFile::PackageFile(Context* context, const String& fileName) :
     Object(context),
     totalSize_(0),
-    checksum_(0)
+    checksum_(0),
+    formatVersion_(0),
+    blockSize_(0),
+    compressed_(false)
 {
     Open(fileName);
 }
@@ -55,8 +61,19 @@ bool PackageFile::Open(const String& fileName)
     if (!file->IsOpen())
         return false;
     
-    // Check ID, then read the directory
-    if (file->ReadFileID() != "UPAK")
+    // Check ID, then read the directory. The legacy "UPAK" format has no version number and stores all files uncompressed
+    String id = file->ReadFileID();
+    unsigned formatVersion = 1;
+    if (id == "UPKG")
+    {
+        formatVersion = file->ReadUInt();
+        if (formatVersion < 2 || formatVersion > PACKAGE_FORMAT_VERSION)
+        {
+            LOGERROR(fileName + " has unsupported package format version " + String(formatVersion));
+            return false;
+        }
+    }
+    else if (id != "UPAK")
     {
         LOGERROR(fileName + " is not a valid package file");
         return false;
@@ -65,9 +82,13 @@ bool PackageFile::Open(const String& fileName)
     fileName_ = fileName;
     nameHash_ = fileName_;
     totalSize_ = file->GetSize();
+    formatVersion_ = formatVersion;
+    compressed_ = false;
+    entries_.Clear();
     
     unsigned numFiles = file->ReadUInt();
     checksum_ = file->ReadUInt();
+    blockSize_ = formatVersion_ >= 2 ? file->ReadUInt() : 0;
     
     for (unsigned i = 0; i < numFiles; ++i)
     {
@@ -75,11 +96,18 @@ bool PackageFile::Open(const String& fileName)
         PackageEntry newEntry;
         newEntry.offset_ = file->ReadUInt();
         newEntry.size_ = file->ReadUInt();
+        newEntry.packedSize_ = formatVersion_ >= 2 ? file->ReadUInt() : newEntry.size_;
         newEntry.checksum_ = file->ReadUInt();
-        if (newEntry.offset_ + newEntry.size_ > totalSize_)
+        newEntry.compressed_ = formatVersion_ >= 2 ? file->ReadBool() : false;
+        if (newEntry.offset_ + newEntry.packedSize_ > totalSize_)
             LOGERROR("File entry " + entryName + " outside package file");
+        else if (newEntry.compressed_ && !blockSize_)
+            LOGERROR("File entry " + entryName + " is compressed but package block size is zero");
         else
+        {
             entries_[entryName.ToLower()] = newEntry;
+            compressed_ |= newEntry.compressed_;
+        }
     }
     
     return true;
@@ -27,6 +27,11 @@
 namespace Urho3D
 {
 
+/// Package file format version written by PackageTool. The legacy uncompressed "UPAK" format is version 1.
+static const unsigned PACKAGE_FORMAT_VERSION = 2;
+/// Default uncompressed size of the independently decompressible blocks in a compressed package entry.
+static const unsigned DEFAULT_PACKAGE_BLOCK_SIZE = 65536;
+
 /// %File entry within the package file.
 struct PackageEntry
 {
@@ -34,8 +39,12 @@ struct PackageEntry
     unsigned offset_;
     /// File size.
     unsigned size_;
+    /// Stored size within the package, including the block table if compressed.
+    unsigned packedSize_;
     /// File checksum.
     unsigned checksum_;
+    /// Whether the data is stored as LZ4 compressed blocks.
+    bool compressed_;
 };
 
 /// Stores files of a directory tree sequentially for convenient access.
@@ -69,6 +78,12 @@ public:
     unsigned GetTotalSize() const { return totalSize_; }
     /// Return checksum of the package file contents.
     unsigned GetChecksum() const { return checksum_; }
+    /// Return package format version.
+    unsigned GetFormatVersion() const { return formatVersion_; }
+    /// Return uncompressed block size of compressed entries.
+    unsigned GetBlockSize() const { return blockSize_; }
+    /// Return whether any of the file entries is compressed.
+    bool IsCompressed() const { return compressed_; }
     
 private:
     /// File entries.
@@ -81,6 +96,12 @@ private:
     unsigned totalSize_;
     /// Package file checksum.
     unsigned checksum_;
+    /// Package format version.
+    unsigned formatVersion_;
+    /// Uncompressed block size of compressed entries.
+    unsigned blockSize_;
+    /// Compressed entries flag.
+    bool compressed_;
 };
 
 }
@@ -330,6 +330,26 @@ bool Serializer::WriteVLE(unsigned value)
     }
 }
 
+bool Serializer::WriteVarUInt(unsigned value)
+{
+    unsigned char data[5];
+    unsigned size = 0;
+    
+    while (value >= 0x80)
+    {
+        data[size++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    data[size++] = (unsigned char)value;
+    
+    return Write(data, size) == size;
+}
+
+bool Serializer::WriteVarInt(int value)
+{
+    return WriteVarUInt(((unsigned)value << 1) ^ (unsigned)(value >> 31));
+}
+
 bool Serializer::WriteNetID(unsigned value)
 {
     return Write(&value, 3) == 3;
@@ -29,6 +29,7 @@
 namespace Urho3D
 {
 
+class BoundingBox;
 class Color;
 class IntRect;
 class IntVector2;
@@ -110,6 +111,10 @@ public:
     bool WriteVariantMap(const VariantMap& value);
     /// Write a variable-length encoded unsigned integer, which can use 29 bits maximum.
     bool WriteVLE(unsigned value);
+    /// Write a variable-length encoded unsigned integer using 1-5 bytes, supporting the full 32-bit range.
+    bool WriteVarUInt(unsigned value);
+    /// Write a variable-length encoded signed integer using zigzag encoding, so that small negative values are also short.
+    bool WriteVarInt(int value);
     /// Write a 24-bit network object ID.
     bool WriteNetID(unsigned value);
     /// Write a text line. Char codes 13 & 10 will be automatically appended.
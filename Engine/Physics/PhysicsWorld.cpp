@@ -491,6 +491,11 @@ void PhysicsWorld::PreStep(float timeStep)
     eventData[P_TIMESTEP] = timeStep;
     SendEvent(E_PHYSICSPRESTEP, eventData);
 
+    // With batched transform updates, nodes moved so far have not yet been applied to the rigid bodies
+    Scene* scene = GetScene();
+    if (scene)
+        scene->UpdateTransforms();
+
     // Start profiling block for the actual simulation step
 #ifdef ENABLE_PROFILING
     Profiler* profiler = GetSubsystem<Profiler>();
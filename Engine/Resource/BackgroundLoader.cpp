@@ -0,0 +1,460 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "BackgroundLoader.h"
+#include "Condition.h"
+#include "Context.h"
+#include "File.h"
+#include "Log.h"
+#include "ResourceCache.h"
+#include "ResourceEvents.h"
+#include "Thread.h"
+#include "Timer.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Background loader thread.
+class BackgroundLoaderThread : public Thread, public RefCounted
+{
+public:
+    /// Construct.
+    BackgroundLoaderThread(BackgroundLoader* owner) :
+        owner_(owner)
+    {
+    }
+    
+    /// Load resources until stopped, sleeping while the queue is empty.
+    virtual void ThreadFunction()
+    {
+        while (shouldRun_)
+        {
+            if (!owner_->LoadNextResource())
+                wakeup_.Wait();
+        }
+    }
+    
+    /// Wake up the thread to check the queue.
+    void Wakeup()
+    {
+        wakeup_.Set();
+    }
+    
+    /// Stop the thread and wait for it to finish.
+    void Shutdown()
+    {
+        shouldRun_ = false;
+        wakeup_.Set();
+        Stop();
+    }
+    
+private:
+    /// Background loader.
+    BackgroundLoader* owner_;
+    /// Condition for waking up when resources are queued.
+    Condition wakeup_;
+};
+
+BackgroundLoader::BackgroundLoader(ResourceCache* owner) :
+    owner_(owner)
+{
+}
+
+BackgroundLoader::~BackgroundLoader()
+{
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        threads_[i]->Shutdown();
+    
+    MutexLock lock(queueMutex_);
+    
+    for (HashMap<Pair<ShortStringHash, StringHash>, BackgroundLoadItem>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
+        i->second_.resource_->SetAsyncLoadState(ASYNC_DONE);
+    queue_.Clear();
+    requests_.Clear();
+    queuedItems_.Clear();
+    readyItems_.Clear();
+}
+
+void BackgroundLoader::CreateThreads(unsigned numThreads)
+{
+    // Allow creating the threads only once, like in WorkQueue
+    if (!threads_.Empty())
+        return;
+    
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        SharedPtr<BackgroundLoaderThread> thread(new BackgroundLoaderThread(this));
+        thread->Start();
+        threads_.Push(thread);
+    }
+}
+
+bool BackgroundLoader::QueueResource(ShortStringHash type, const String& name, bool sendEventOnFailure, Resource* caller)
+{
+    bool queued;
+    
+    {
+        MutexLock lock(queueMutex_);
+        
+        // Resources can only be created in the main thread, so defer requests from the loader threads
+        if (!Thread::IsMainThread())
+        {
+            BackgroundLoadRequest request;
+            request.type_ = type;
+            request.name_ = name;
+            request.hasCaller_ = caller != 0;
+            if (caller)
+                request.caller_ = MakePair(caller->GetType(), caller->GetNameHash());
+            request.sendEventOnFailure_ = sendEventOnFailure;
+            requests_.Push(request);
+            return true;
+        }
+        
+        if (caller)
+        {
+            Pair<ShortStringHash, StringHash> callerKey = MakePair(caller->GetType(), caller->GetNameHash());
+            queued = AddItem(type, name, sendEventOnFailure, &callerKey);
+        }
+        else
+            queued = AddItem(type, name, sendEventOnFailure, 0);
+    }
+    
+    if (queued)
+        WakeupThreads();
+    return queued;
+}
+
+bool BackgroundLoader::WaitForResource(ShortStringHash type, StringHash nameHash)
+{
+    Pair<ShortStringHash, StringHash> key = MakePair(type, nameHash);
+    bool waited = false;
+    
+    for (;;)
+    {
+        Resource* claimed = 0;
+        AsyncLoadState state;
+        
+        {
+            MutexLock lock(queueMutex_);
+            
+            ProcessRequests();
+            HashMap<Pair<ShortStringHash, StringHash>, BackgroundLoadItem>::Iterator i = queue_.Find(key);
+            if (i == queue_.End())
+                return false;
+            
+            state = i->second_.resource_->GetAsyncLoadState();
+            if (state == ASYNC_QUEUED)
+            {
+                // If no loader thread has taken the resource yet, load it here instead of waiting
+                claimed = i->second_.resource_;
+                claimed->SetAsyncLoadState(ASYNC_LOADING);
+            }
+        }
+        
+        if (!waited)
+        {
+            LOGDEBUG("Waiting for background loaded resource " + owner_->GetResourceName(nameHash));
+            waited = true;
+        }
+        
+        if (claimed)
+            LoadResource(claimed);
+        else if (state == ASYNC_LOADING)
+            Time::Sleep(0);
+        else
+        {
+            // Dependencies are not waited for here, as they will be requested from the resource cache in EndLoad()
+            FinishResource(key);
+            return true;
+        }
+    }
+}
+
+void BackgroundLoader::FinishResources(int maxMs)
+{
+    HiresTimer timer;
+    long long maxUSec = maxMs * 1000LL;
+    
+    // Without loader threads, call BeginLoad() here
+    if (threads_.Empty())
+    {
+        while (timer.GetUSec(false) < maxUSec && LoadNextResource())
+        {
+        }
+    }
+    
+    for (;;)
+    {
+        Pair<ShortStringHash, StringHash> key;
+        bool found = false;
+        
+        {
+            MutexLock lock(queueMutex_);
+            
+            ProcessRequests();
+            while (!readyItems_.Empty())
+            {
+                key = readyItems_.Back();
+                readyItems_.Pop();
+                
+                // Skip resources already finished, or which have received new dependencies. The latter are added back when
+                // their dependencies are finished
+                HashMap<Pair<ShortStringHash, StringHash>, BackgroundLoadItem>::ConstIterator i = queue_.Find(key);
+                if (i == queue_.End() || !i->second_.dependencies_.Empty())
+                    continue;
+                AsyncLoadState state = i->second_.resource_->GetAsyncLoadState();
+                if (state == ASYNC_SUCCESS || state == ASYNC_FAIL)
+                {
+                    found = true;
+                    break;
+                }
+            }
+        }
+        
+        if (!found)
+            break;
+        
+        FinishResource(key);
+        
+        if (timer.GetUSec(false) >= maxUSec)
+            break;
+    }
+}
+
+unsigned BackgroundLoader::GetNumQueuedResources() const
+{
+    MutexLock lock(queueMutex_);
+    return queue_.Size() + requests_.Size();
+}
+
+bool BackgroundLoader::LoadNextResource()
+{
+    Resource* resource = 0;
+    
+    {
+        MutexLock lock(queueMutex_);
+        
+        while (!queuedItems_.Empty())
+        {
+            HashMap<Pair<ShortStringHash, StringHash>, BackgroundLoadItem>::Iterator i = queue_.Find(queuedItems_.Front());
+            queuedItems_.PopFront();
+            if (i != queue_.End() && i->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
+            {
+                resource = i->second_.resource_;
+                resource->SetAsyncLoadState(ASYNC_LOADING);
+                break;
+            }
+        }
+    }
+    
+    if (!resource)
+        return false;
+    
+    LoadResource(resource);
+    return true;
+}
+
+void BackgroundLoader::LoadResource(Resource* resource)
+{
+    // The resource stays in the queue while in the loading state, so it is safe to access without holding a reference
+    bool success = false;
+    SharedPtr<File> file = owner_->GetFile(resource->GetName());
+    if (file)
+    {
+        LOGDEBUG("Background loading resource " + resource->GetName());
+        success = resource->BeginLoad(*file);
+    }
+    
+    MutexLock lock(queueMutex_);
+    resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
+    readyItems_.Push(MakePair(resource->GetType(), resource->GetNameHash()));
+}
+
+bool BackgroundLoader::AddItem(ShortStringHash type, const String& nameIn, bool sendEventOnFailure, const Pair<ShortStringHash,
+    StringHash>* caller)
+{
+    String name = owner_->SanitateResourceName(nameIn);
+    if (name.Empty())
+        return false;
+    
+    StringHash nameHash(name);
+    Pair<ShortStringHash, StringHash> key = MakePair(type, nameHash);
+    
+    HashMap<Pair<ShortStringHash, StringHash>, BackgroundLoadItem>::Iterator i = queue_.Find(key);
+    if (i == queue_.End())
+    {
+        if (owner_->FindResource(type, nameHash))
+            return false;
+        
+        SharedPtr<Resource> resource = DynamicCast<Resource>(owner_->GetContext()->CreateObject(type));
+        if (!resource)
+        {
+            LOGERROR("Could not load unknown resource type " + String(type));
+            return false;
+        }
+        
+        owner_->StoreNameHash(name);
+        resource->SetName(name);
+        resource->SetAsyncLoadState(ASYNC_QUEUED);
+        
+        i = queue_.Insert(MakePair(key, BackgroundLoadItem()));
+        i->second_.resource_ = resource;
+        i->second_.sendEventOnFailure_ = sendEventOnFailure;
+        queuedItems_.Push(key);
+    }
+    
+    // Make the caller wait for this resource before it is finished. A circular dependency is not stored, as the
+    // resources could then never be finished
+    if (caller && *caller != key)
+    {
+        HashMap<Pair<ShortStringHash, StringHash>, BackgroundLoadItem>::Iterator j = queue_.Find(*caller);
+        if (j != queue_.End())
+        {
+            if (HasDependency(key, *caller))
+                LOGERROR("Cyclic dependency of background loaded resource " + j->second_.resource_->GetName() + " on " + name);
+            else
+            {
+                j->second_.dependencies_.Insert(key);
+                i->second_.dependents_.Insert(*caller);
+            }
+        }
+    }
+    
+    return true;
+}
+
+bool BackgroundLoader::HasDependency(const Pair<ShortStringHash, StringHash>& key, const Pair<ShortStringHash, StringHash>&
+    dependency) const
+{
+    PODVector<const Pair<ShortStringHash, StringHash>*> stack;
+    HashSet<Pair<ShortStringHash, StringHash> > visited;
+    stack.Push(&key);
+    
+    while (!stack.Empty())
+    {
+        const Pair<ShortStringHash, StringHash>& current = *stack.Back();
+        stack.Pop();
+        if (current == dependency)
+            return true;
+        if (visited.Contains(current))
+            continue;
+        visited.Insert(current);
+        
+        HashMap<Pair<ShortStringHash, StringHash>, BackgroundLoadItem>::ConstIterator i = queue_.Find(current);
+        if (i != queue_.End())
+        {
+            for (HashSet<Pair<ShortStringHash, StringHash> >::ConstIterator j = i->second_.dependencies_.Begin(); j !=
+                i->second_.dependencies_.End(); ++j)
+                stack.Push(&(*j));
+        }
+    }
+    
+    return false;
+}
+
+void BackgroundLoader::ProcessRequests()
+{
+    if (requests_.Empty())
+        return;
+    
+    bool queued = false;
+    for (unsigned i = 0; i < requests_.Size(); ++i)
+    {
+        const BackgroundLoadRequest& request = requests_[i];
+        if (AddItem(request.type_, request.name_, request.sendEventOnFailure_, request.hasCaller_ ? &request.caller_ : 0))
+            queued = true;
+    }
+    requests_.Clear();
+    
+    if (queued)
+        WakeupThreads();
+}
+
+void BackgroundLoader::FinishResource(const Pair<ShortStringHash, StringHash>& key)
+{
+    BackgroundLoadItem item;
+    
+    {
+        MutexLock lock(queueMutex_);
+        
+        HashMap<Pair<ShortStringHash, StringHash>, BackgroundLoadItem>::Iterator i = queue_.Find(key);
+        if (i == queue_.End())
+            return;
+        
+        // Remove from the queue before EndLoad(), so that requesting the same resource during it does not finish it twice
+        item = i->second_;
+        queue_.Erase(i);
+        
+        for (HashSet<Pair<ShortStringHash, StringHash> >::ConstIterator j = item.dependents_.Begin(); j !=
+            item.dependents_.End(); ++j)
+        {
+            HashMap<Pair<ShortStringHash, StringHash>, BackgroundLoadItem>::Iterator k = queue_.Find(*j);
+            if (k != queue_.End())
+            {
+                k->second_.dependencies_.Erase(key);
+                AsyncLoadState state = k->second_.resource_->GetAsyncLoadState();
+                if (k->second_.dependencies_.Empty() && (state == ASYNC_SUCCESS || state == ASYNC_FAIL))
+                    readyItems_.Push(*j);
+            }
+        }
+    }
+    
+    Resource* resource = item.resource_;
+    bool success = resource->GetAsyncLoadState() == ASYNC_SUCCESS;
+    if (success)
+    {
+        LOGDEBUG("Finishing background loaded resource " + resource->GetName());
+        success = resource->EndLoad();
+    }
+    resource->SetAsyncLoadState(ASYNC_DONE);
+    
+    if (success)
+    {
+        resource->ResetUseTimer();
+        owner_->StoreResource(key.first_, key.second_, resource);
+        owner_->UpdateResourceGroup(key.first_);
+    }
+    else
+        LOGERROR("Failed to load resource " + resource->GetName());
+    
+    if (success || item.sendEventOnFailure_)
+    {
+        using namespace ResourceBackgroundLoaded;
+        
+        VariantMap eventData;
+        eventData[P_RESOURCENAME] = resource->GetName();
+        eventData[P_SUCCESS] = success;
+        eventData[P_RESOURCE] = (void*)resource;
+        owner_->SendEvent(E_RESOURCEBACKGROUNDLOADED, eventData);
+    }
+}
+
+void BackgroundLoader::WakeupThreads()
+{
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        threads_[i]->Wakeup();
+}
+
+}
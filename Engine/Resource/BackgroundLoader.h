@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "HashMap.h"
+#include "HashSet.h"
+#include "List.h"
+#include "Mutex.h"
+#include "Ptr.h"
+#include "Resource.h"
+
+namespace Urho3D
+{
+
+class BackgroundLoaderThread;
+class ResourceCache;
+
+/// Queue item for background loading of a resource.
+struct BackgroundLoadItem
+{
+    /// Construct.
+    BackgroundLoadItem() :
+        sendEventOnFailure_(true)
+    {
+    }
+    
+    /// Resource.
+    SharedPtr<Resource> resource_;
+    /// Resources this item depends on. Resource can not be finished until these have been finished.
+    HashSet<Pair<ShortStringHash, StringHash> > dependencies_;
+    /// Resources that depend on this item.
+    HashSet<Pair<ShortStringHash, StringHash> > dependents_;
+    /// Whether to send the completion event also on failure.
+    bool sendEventOnFailure_;
+};
+
+/// Background loading request made from a worker thread, processed in the main thread.
+struct BackgroundLoadRequest
+{
+    /// Resource type.
+    ShortStringHash type_;
+    /// Resource name.
+    String name_;
+    /// Type and name hash of the resource that requested the load, if any.
+    Pair<ShortStringHash, StringHash> caller_;
+    /// Whether a caller exists.
+    bool hasCaller_;
+    /// Whether to send the completion event also on failure.
+    bool sendEventOnFailure_;
+};
+
+/// Background loader of resources. Resource data is read and parsed with BeginLoad() in the loader threads, after which the main thread finishes the resources with EndLoad() within a time budget each frame.
+class BackgroundLoader : public RefCounted
+{
+    friend class BackgroundLoaderThread;
+    
+public:
+    /// Construct.
+    BackgroundLoader(ResourceCache* owner);
+    /// Destruct. Stop the loader threads.
+    ~BackgroundLoader();
+    
+    /// Create loader threads. Can only be called once. Without threads, BeginLoad() is called in the main thread when finishing resources.
+    void CreateThreads(unsigned numThreads);
+    /// Queue a resource for background loading, optionally as a dependency of another resource being background loaded. Can be called from any thread. Return true if queued, or false if the resource is already loaded or the type is unknown.
+    bool QueueResource(ShortStringHash type, const String& name, bool sendEventOnFailure, Resource* caller);
+    /// Wait for a resource queued for background loading and finish it. Called from the main thread. Return true if the resource was queued.
+    bool WaitForResource(ShortStringHash type, StringHash nameHash);
+    /// Finish resources which have been loaded and whose dependencies have been finished, until the time limit in milliseconds is exceeded. Called from the main thread.
+    void FinishResources(int maxMs);
+    
+    /// Return number of loader threads.
+    unsigned GetNumThreads() const { return threads_.Size(); }
+    /// Return number of resources in the background loading queue.
+    unsigned GetNumQueuedResources() const;
+    
+private:
+    /// Take the next queued resource and call BeginLoad() on it. Return false if no queued resources.
+    bool LoadNextResource();
+    /// Call BeginLoad() on a resource which has been set to the loading state.
+    void LoadResource(Resource* resource);
+    /// Add a resource to the queue. Queue mutex must be held and must be called from the main thread.
+    bool AddItem(ShortStringHash type, const String& name, bool sendEventOnFailure, const Pair<ShortStringHash, StringHash>* caller);
+    /// Add the requests made from worker threads to the queue. Queue mutex must be held.
+    void ProcessRequests();
+    /// Return whether a queued resource depends on another directly or indirectly. Queue mutex must be held.
+    bool HasDependency(const Pair<ShortStringHash, StringHash>& key, const Pair<ShortStringHash, StringHash>& dependency) const;
+    /// Finish a resource by calling EndLoad() and storing it to the resource cache.
+    void FinishResource(const Pair<ShortStringHash, StringHash>& key);
+    /// Wake up the loader threads.
+    void WakeupThreads();
+    
+    /// Resource cache.
+    ResourceCache* owner_;
+    /// Loader threads.
+    Vector<SharedPtr<BackgroundLoaderThread> > threads_;
+    /// Resources in the background loading queue.
+    HashMap<Pair<ShortStringHash, StringHash>, BackgroundLoadItem> queue_;
+    /// Requests made from worker threads.
+    Vector<BackgroundLoadRequest> requests_;
+    /// Resources waiting for BeginLoad() in queueing order. Resources claimed by WaitForResource() are skipped.
+    List<Pair<ShortStringHash, StringHash> > queuedItems_;
+    /// Resources which may be ready to be finished. Checked again before finishing, as dependencies may have been added since.
+    Vector<Pair<ShortStringHash, StringHash> > readyItems_;
+    /// Mutex for the queue, the requests and the ready resources.
+    mutable Mutex queueMutex_;
+};
+
+}
@@ -0,0 +1,569 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Compress.h"
+#include "MathDefs.h"
+
+#include <cstring>
+
+#if defined(ENABLE_SSE) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define USE_SSE2_DXT
+#endif
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Number of principal axis power iterations.
+static const int POWER_ITERATIONS = 8;
+/// Number of endpoint refinement passes in high quality mode.
+static const int REFINE_PASSES = 2;
+
+/// Quantize an RGB color to 5:6:5.
+static unsigned short Pack565(float r, float g, float b)
+{
+    int red = Clamp((int)(r * 31.0f / 255.0f + 0.5f), 0, 31);
+    int green = Clamp((int)(g * 63.0f / 255.0f + 0.5f), 0, 63);
+    int blue = Clamp((int)(b * 31.0f / 255.0f + 0.5f), 0, 31);
+    return (unsigned short)((red << 11) | (green << 5) | blue);
+}
+
+/// Expand a 5:6:5 color to 8 bits per component the same way as the decompressor.
+static void Unpack565(unsigned short packed, int* color)
+{
+    int red = (packed >> 11) & 0x1f;
+    int green = (packed >> 5) & 0x3f;
+    int blue = packed & 0x1f;
+    color[0] = (red << 3) | (red >> 2);
+    color[1] = (green << 2) | (green >> 4);
+    color[2] = (blue << 3) | (blue >> 2);
+    color[3] = 0;
+}
+
+/// Build the color palette of a block from its endpoints, in the same way as the decompressor.
+static void BuildPalette(unsigned short c0, unsigned short c1, bool threeColors, int palette[4][4])
+{
+    Unpack565(c0, palette[0]);
+    Unpack565(c1, palette[1]);
+    for (int i = 0; i < 3; ++i)
+    {
+        if (threeColors)
+        {
+            palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+            palette[3][i] = 0;
+        }
+        else
+        {
+            palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+            palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+        }
+    }
+    palette[2][3] = 0;
+    palette[3][3] = 0;
+}
+
+/// Choose the nearest palette color for each pixel. Pixels with the transparent flag set get index 3. Return total squared error.
+static int ChooseIndices(const unsigned char* rgba, const int palette[4][4], int numColors, const bool* transparent, unsigned char* indices)
+{
+    int error = 0;
+    
+    #ifdef USE_SSE2_DXT
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rgbMask = _mm_set1_epi32(0x00ffffff);
+    __m128i colors[4];
+    for (int k = 0; k < numColors; ++k)
+        colors[k] = _mm_set_epi16(0, (short)palette[k][2], (short)palette[k][1], (short)palette[k][0], 0, (short)palette[k][2],
+            (short)palette[k][1], (short)palette[k][0]);
+    
+    // Four pixels at a time: calculate squared RGB distance to each palette color and keep the smallest
+    for (int i = 0; i < 16; i += 4)
+    {
+        __m128i pixels = _mm_and_si128(_mm_loadu_si128((const __m128i*)(rgba + i * 4)), rgbMask);
+        __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+        __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+        __m128i best = _mm_set1_epi32(0x7fffffff);
+        __m128i bestIndex = zero;
+        
+        for (int k = 0; k < numColors; ++k)
+        {
+            __m128i dLo = _mm_sub_epi16(lo, colors[k]);
+            __m128i dHi = _mm_sub_epi16(hi, colors[k]);
+            __m128i t0 = _mm_shuffle_epi32(_mm_madd_epi16(dLo, dLo), _MM_SHUFFLE(3, 1, 2, 0));
+            __m128i t1 = _mm_shuffle_epi32(_mm_madd_epi16(dHi, dHi), _MM_SHUFFLE(3, 1, 2, 0));
+            __m128i dist = _mm_add_epi32(_mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1));
+            __m128i closer = _mm_cmplt_epi32(dist, best);
+            best = _mm_or_si128(_mm_and_si128(closer, dist), _mm_andnot_si128(closer, best));
+            bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)), _mm_andnot_si128(closer, bestIndex));
+        }
+        
+        int dists[4];
+        int bestIndices[4];
+        _mm_storeu_si128((__m128i*)dists, best);
+        _mm_storeu_si128((__m128i*)bestIndices, bestIndex);
+        for (int j = 0; j < 4; ++j)
+        {
+            if (transparent && transparent[i + j])
+                indices[i + j] = 3;
+            else
+            {
+                indices[i + j] = (unsigned char)bestIndices[j];
+                error += dists[j];
+            }
+        }
+    }
+    #else
+    for (int i = 0; i < 16; ++i)
+    {
+        if (transparent && transparent[i])
+        {
+            indices[i] = 3;
+            continue;
+        }
+        
+        const unsigned char* pixel = rgba + i * 4;
+        int best = M_MAX_INT;
+        for (int k = 0; k < numColors; ++k)
+        {
+            int dr = pixel[0] - palette[k][0];
+            int dg = pixel[1] - palette[k][1];
+            int db = pixel[2] - palette[k][2];
+            int dist = dr * dr + dg * dg + db * db;
+            if (dist < best)
+            {
+                best = dist;
+                indices[i] = (unsigned char)k;
+            }
+        }
+        error += best;
+    }
+    #endif
+    
+    return error;
+}
+
+/// Find color endpoints from the bounding box of the colors, inset slightly to reduce the error at the ends.
+static void GetBoundingBoxEndpoints(const unsigned char* rgba, const bool* transparent, float* start, float* end)
+{
+    int minColor[3] = { 255, 255, 255 };
+    int maxColor[3] = { 0, 0, 0 };
+    
+    for (int i = 0; i < 16; ++i)
+    {
+        if (transparent && transparent[i])
+            continue;
+        for (int j = 0; j < 3; ++j)
+        {
+            minColor[j] = Min(minColor[j], (int)rgba[i * 4 + j]);
+            maxColor[j] = Max(maxColor[j], (int)rgba[i * 4 + j]);
+        }
+    }
+    
+    for (int j = 0; j < 3; ++j)
+    {
+        int inset = (maxColor[j] - minColor[j]) >> 4;
+        start[j] = (float)Min(maxColor[j] - inset, 255);
+        end[j] = (float)Max(minColor[j] + inset, 0);
+    }
+}
+
+/// Find color endpoints along the principal axis of the colors.
+static void GetPrincipalAxisEndpoints(const unsigned char* rgba, const bool* transparent, float* start, float* end)
+{
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    int count = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        if (transparent && transparent[i])
+            continue;
+        for (int j = 0; j < 3; ++j)
+            mean[j] += rgba[i * 4 + j];
+        ++count;
+    }
+    for (int j = 0; j < 3; ++j)
+        mean[j] /= (float)count;
+    
+    // Covariance matrix: xx, xy, xz, yy, yz, zz
+    float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+    {
+        if (transparent && transparent[i])
+            continue;
+        float r = rgba[i * 4] - mean[0];
+        float g = rgba[i * 4 + 1] - mean[1];
+        float b = rgba[i * 4 + 2] - mean[2];
+        cov[0] += r * r;
+        cov[1] += r * g;
+        cov[2] += r * b;
+        cov[3] += g * g;
+        cov[4] += g * b;
+        cov[5] += b * b;
+    }
+    
+    // Find the principal axis by power iteration, starting from the axis of largest variance
+    float axis[3] = { cov[0], cov[3], cov[5] };
+    for (int i = 0; i < POWER_ITERATIONS; ++i)
+    {
+        float x = axis[0] * cov[0] + axis[1] * cov[1] + axis[2] * cov[2];
+        float y = axis[0] * cov[1] + axis[1] * cov[3] + axis[2] * cov[4];
+        float z = axis[0] * cov[2] + axis[1] * cov[4] + axis[2] * cov[5];
+        float length = Max(Max(fabsf(x), fabsf(y)), fabsf(z));
+        if (length < M_EPSILON)
+            break;
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+    
+    float lengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    if (lengthSquared < M_EPSILON)
+    {
+        // All colors are the same
+        for (int j = 0; j < 3; ++j)
+            start[j] = end[j] = mean[j];
+        return;
+    }
+    
+    // Project the colors on the axis to find the extents
+    float minDot = M_INFINITY;
+    float maxDot = -M_INFINITY;
+    for (int i = 0; i < 16; ++i)
+    {
+        if (transparent && transparent[i])
+            continue;
+        float dot = (rgba[i * 4] - mean[0]) * axis[0] + (rgba[i * 4 + 1] - mean[1]) * axis[1] + (rgba[i * 4 + 2] - mean[2]) *
+            axis[2];
+        minDot = Min(minDot, dot);
+        maxDot = Max(maxDot, dot);
+    }
+    
+    // Inset the extents like the bounding box endpoints
+    float inset = (maxDot - minDot) / 16.0f;
+    maxDot -= inset;
+    minDot += inset;
+    
+    for (int j = 0; j < 3; ++j)
+    {
+        start[j] = Clamp(mean[j] + axis[j] * maxDot / lengthSquared, 0.0f, 255.0f);
+        end[j] = Clamp(mean[j] + axis[j] * minDot / lengthSquared, 0.0f, 255.0f);
+    }
+}
+
+/// Refine color endpoints by least squares fitting to the chosen indices. Return false if the system can not be solved.
+static bool RefineEndpoints(const unsigned char* rgba, const unsigned char* indices, bool threeColors, float* start, float* end)
+{
+    static const float fourColorWeights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    static const float threeColorWeights[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+    const float* weights = threeColors ? threeColorWeights : fourColorWeights;
+    
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[3] = { 0.0f, 0.0f, 0.0f };
+    float bx[3] = { 0.0f, 0.0f, 0.0f };
+    
+    for (int i = 0; i < 16; ++i)
+    {
+        // In three color mode index 3 is transparent and does not contribute
+        if (threeColors && indices[i] == 3)
+            continue;
+        float a = weights[indices[i]];
+        float b = 1.0f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int j = 0; j < 3; ++j)
+        {
+            ax[j] += a * rgba[i * 4 + j];
+            bx[j] += b * rgba[i * 4 + j];
+        }
+    }
+    
+    float det = aa * bb - ab * ab;
+    if (fabsf(det) < M_EPSILON)
+        return false;
+    
+    float invDet = 1.0f / det;
+    for (int j = 0; j < 3; ++j)
+    {
+        start[j] = Clamp((ax[j] * bb - bx[j] * ab) * invDet, 0.0f, 255.0f);
+        end[j] = Clamp((bx[j] * aa - ax[j] * ab) * invDet, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+/// Quantize endpoints, choose indices and write a color block. Return the total squared error.
+static int EncodeColorBlock(unsigned char* dest, const unsigned char* rgba, const float* start, const float* end, const bool* transparent)
+{
+    unsigned short c0 = Pack565(start[0], start[1], start[2]);
+    unsigned short c1 = Pack565(end[0], end[1], end[2]);
+    bool threeColors = transparent != 0;
+    
+    // Four color mode requires c0 > c1 and three color mode c0 <= c1
+    if ((!threeColors && c0 < c1) || (threeColors && c0 > c1))
+    {
+        unsigned short temp = c0;
+        c0 = c1;
+        c1 = temp;
+    }
+    
+    unsigned char indices[16];
+    int error;
+    if (!threeColors && c0 == c1)
+    {
+        // Single color: four color mode can not be encoded, but index 0 decodes to c0 in both modes
+        int palette[4][4];
+        BuildPalette(c0, c1, false, palette);
+        error = ChooseIndices(rgba, palette, 1, 0, indices);
+    }
+    else
+    {
+        int palette[4][4];
+        BuildPalette(c0, c1, threeColors, palette);
+        error = ChooseIndices(rgba, palette, threeColors ? 3 : 4, transparent, indices);
+    }
+    
+    dest[0] = (unsigned char)(c0 & 0xff);
+    dest[1] = (unsigned char)(c0 >> 8);
+    dest[2] = (unsigned char)(c1 & 0xff);
+    dest[3] = (unsigned char)(c1 >> 8);
+    for (int i = 0; i < 4; ++i)
+        dest[4 + i] = (unsigned char)(indices[i * 4] | (indices[i * 4 + 1] << 2) | (indices[i * 4 + 2] << 4) | (indices[i * 4 + 3] << 6));
+    
+    return error;
+}
+
+/// Decode the indices of an encoded color block.
+static void GetBlockIndices(const unsigned char* block, unsigned char* indices)
+{
+    for (int i = 0; i < 16; ++i)
+        indices[i] = (block[4 + i / 4] >> ((i & 3) * 2)) & 3;
+}
+
+/// Compress the colors of a block.
+static void CompressColorBlock(unsigned char* dest, const unsigned char* rgba, bool dxt1, CompressQuality quality)
+{
+    // DXT1 encodes transparent pixels with the three color mode
+    bool transparentPixels[16];
+    bool hasTransparent = false;
+    if (dxt1)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            transparentPixels[i] = rgba[i * 4 + 3] < 128;
+            hasTransparent |= transparentPixels[i];
+        }
+    }
+    
+    const bool* transparent = hasTransparent ? transparentPixels : 0;
+    
+    // Fully transparent block
+    if (hasTransparent)
+    {
+        bool allTransparent = true;
+        for (int i = 0; i < 16; ++i)
+            allTransparent &= transparentPixels[i];
+        if (allTransparent)
+        {
+            memset(dest, 0, 4);
+            memset(dest + 4, 0xff, 4);
+            return;
+        }
+    }
+    
+    float start[3];
+    float end[3];
+    if (quality == CQ_FAST)
+        GetBoundingBoxEndpoints(rgba, transparent, start, end);
+    else
+        GetPrincipalAxisEndpoints(rgba, transparent, start, end);
+    
+    int error = EncodeColorBlock(dest, rgba, start, end, transparent);
+    
+    if (quality == CQ_HIGH)
+    {
+        for (int i = 0; i < REFINE_PASSES && error > 0; ++i)
+        {
+            unsigned char indices[16];
+            GetBlockIndices(dest, indices);
+            
+            float refinedStart[3];
+            float refinedEnd[3];
+            if (!RefineEndpoints(rgba, indices, transparent != 0, refinedStart, refinedEnd))
+                break;
+            
+            unsigned char candidate[8];
+            int candidateError = EncodeColorBlock(candidate, rgba, refinedStart, refinedEnd, transparent);
+            if (candidateError >= error)
+                break;
+            
+            memcpy(dest, candidate, 8);
+            error = candidateError;
+        }
+    }
+}
+
+/// Compress the alpha of a block in DXT5 format.
+static void CompressAlphaBlock(unsigned char* dest, const unsigned char* rgba, CompressQuality quality)
+{
+    int minAlpha = 255;
+    int maxAlpha = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        minAlpha = Min(minAlpha, (int)rgba[i * 4 + 3]);
+        maxAlpha = Max(maxAlpha, (int)rgba[i * 4 + 3]);
+    }
+    
+    // Constant alpha, which includes opaque images, needs no index search
+    if (minAlpha == maxAlpha)
+    {
+        dest[0] = (unsigned char)maxAlpha;
+        dest[1] = (unsigned char)minAlpha;
+        memset(dest + 2, 0, 6);
+        return;
+    }
+    
+    unsigned char indices[16];
+    int bestError = M_MAX_INT;
+    int alpha0 = maxAlpha;
+    int alpha1 = minAlpha;
+    
+    // Try the eight alpha mode, and in high quality mode also the six alpha mode with explicit 0 and 255
+    for (int mode = 0; mode < (quality == CQ_HIGH ? 2 : 1); ++mode)
+    {
+        int a0, a1;
+        int codes[8];
+        
+        if (!mode)
+        {
+            a0 = maxAlpha;
+            a1 = minAlpha;
+            codes[0] = a0;
+            codes[1] = a1;
+            for (int i = 1; i < 7; ++i)
+                codes[1 + i] = ((7 - i) * a0 + i * a1) / 7;
+            // With equal values the block decodes in six alpha mode, but index 0 is still correct
+            if (a0 == a1)
+            {
+                for (int i = 2; i < 8; ++i)
+                    codes[i] = a0;
+            }
+        }
+        else
+        {
+            // Endpoints from the values that are not exactly 0 or 255
+            a0 = 255;
+            a1 = 0;
+            for (int i = 0; i < 16; ++i)
+            {
+                int alpha = rgba[i * 4 + 3];
+                if (alpha != 0 && alpha != 255)
+                {
+                    a0 = Min(a0, alpha);
+                    a1 = Max(a1, alpha);
+                }
+            }
+            if (a0 > a1)
+                a0 = a1 = 0;
+            codes[0] = a0;
+            codes[1] = a1;
+            for (int i = 1; i < 5; ++i)
+                codes[1 + i] = ((5 - i) * a0 + i * a1) / 5;
+            codes[6] = 0;
+            codes[7] = 255;
+        }
+        
+        unsigned char modeIndices[16];
+        int error = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int alpha = rgba[i * 4 + 3];
+            int best = M_MAX_INT;
+            for (int k = 0; k < 8; ++k)
+            {
+                int dist = (alpha - codes[k]) * (alpha - codes[k]);
+                if (dist < best)
+                {
+                    best = dist;
+                    modeIndices[i] = (unsigned char)k;
+                }
+            }
+            error += best;
+        }
+        
+        if (error < bestError)
+        {
+            bestError = error;
+            alpha0 = a0;
+            alpha1 = a1;
+            memcpy(indices, modeIndices, 16);
+        }
+    }
+    
+    dest[0] = (unsigned char)alpha0;
+    dest[1] = (unsigned char)alpha1;
+    for (int i = 0; i < 2; ++i)
+    {
+        unsigned value = 0;
+        for (int j = 0; j < 8; ++j)
+            value |= (unsigned)indices[i * 8 + j] << (3 * j);
+        dest[2 + i * 3] = (unsigned char)(value & 0xff);
+        dest[3 + i * 3] = (unsigned char)((value >> 8) & 0xff);
+        dest[4 + i * 3] = (unsigned char)((value >> 16) & 0xff);
+    }
+}
+
+void CompressImageDXT(unsigned char* dest, const unsigned char* rgba, int width, int height, CompressedFormat format, CompressQuality quality)
+{
+    bool dxt1 = format == CF_DXT1;
+    int blockSize = dxt1 ? 8 : 16;
+    
+    for (int y = 0; y < height; y += 4)
+    {
+        for (int x = 0; x < width; x += 4)
+        {
+            // Gather the block, repeating the edge pixels if the image size is not divisible by four
+            unsigned char block[16 * 4];
+            for (int py = 0; py < 4; ++py)
+            {
+                int sy = Min(y + py, height - 1);
+                for (int px = 0; px < 4; ++px)
+                {
+                    int sx = Min(x + px, width - 1);
+                    memcpy(&block[(py * 4 + px) * 4], &rgba[(sy * width + sx) * 4], 4);
+                }
+            }
+            
+            if (dxt1)
+                CompressColorBlock(dest, block, true, quality);
+            else
+            {
+                CompressAlphaBlock(dest, block, quality);
+                CompressColorBlock(dest + 8, block, false, quality);
+            }
+            
+            dest += blockSize;
+        }
+    }
+}
+
+}
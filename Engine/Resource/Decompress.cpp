@@ -22,6 +22,14 @@
 
 #include "Precompiled.h"
 #include "Decompress.h"
+#include "MathDefs.h"
+
+#include <cstring>
+
+#if defined(ENABLE_SSE) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define USE_SSE2_DECOMPRESS
+#endif
 
 // DXT decompression based on the Squish library, modified for Urho3D
 
@@ -73,7 +81,7 @@ static int Unpack565( unsigned char const* packed, unsigned char* colour )
     return value;
 }
 
-static void DecompressColourDXT( unsigned char* rgba, void const* block, bool isDxt1 )
+static void DecompressColourDXT( unsigned char* rgba, int pitch, void const* block, bool isDxt1, unsigned char const* alpha )
 {
     // get the block bytes
     unsigned char const* bytes = reinterpret_cast< unsigned char const* >( block );
@@ -105,29 +113,30 @@ static void DecompressColourDXT( unsigned char* rgba, void const* block, bool is
     codes[8 + 3] = 255;
     codes[12 + 3] = ( isDxt1 && a <= b ) ? 0 : 255;
     
-    // unpack the indices
-    unsigned char indices[16];
+    // store out the colours a whole pixel at a time, one row of the block per indices byte
+    unsigned colours[4];
+    memcpy( colours, codes, sizeof colours );
+    
     for( int i = 0; i < 4; ++i )
     {
-        unsigned char* ind = indices + 4*i;
+        unsigned* dest = reinterpret_cast< unsigned* >( rgba + i*pitch );
         unsigned char packed = bytes[4 + i];
         
-        ind[0] = packed & 0x3;
-        ind[1] = ( packed >> 2 ) & 0x3;
-        ind[2] = ( packed >> 4 ) & 0x3;
-        ind[3] = ( packed >> 6 ) & 0x3;
-    }
-    
-    // store out the colours
-    for( int i = 0; i < 16; ++i )
-    {
-        unsigned char offset = 4*indices[i];
-        for( int j = 0; j < 4; ++j )
-            rgba[4*i + j] = codes[offset + j];
+        dest[0] = colours[packed & 0x3];
+        dest[1] = colours[( packed >> 2 ) & 0x3];
+        dest[2] = colours[( packed >> 4 ) & 0x3];
+        dest[3] = colours[packed >> 6];
+        
+        // write the separately decoded alpha values of the row
+        if( alpha )
+        {
+            for( int j = 0; j < 4; ++j )
+                rgba[i*pitch + 4*j + 3] = alpha[4*i + j];
+        }
     }
 }
 
-static void DecompressAlphaDXT3( unsigned char* rgba, void const* block )
+static void DecompressAlphaDXT3( unsigned char* alpha, void const* block )
 {
     unsigned char const* bytes = reinterpret_cast< unsigned char const* >( block );
     
@@ -142,12 +151,12 @@ static void DecompressAlphaDXT3( unsigned char* rgba, void const* block )
         unsigned char hi = quant & 0xf0;
         
         // convert back up to bytes
-        rgba[8*i + 3] = lo | ( lo << 4 );
-        rgba[8*i + 7] = hi | ( hi >> 4 );
+        alpha[2*i] = lo | ( lo << 4 );
+        alpha[2*i + 1] = hi | ( hi >> 4 );
     }
 }
 
-static void DecompressAlphaDXT5( unsigned char* rgba, void const* block )
+static void DecompressAlphaDXT5( unsigned char* alpha, void const* block )
 {
     // get the two alpha values
     unsigned char const* bytes = reinterpret_cast< unsigned char const* >( block );
@@ -173,34 +182,24 @@ static void DecompressAlphaDXT5( unsigned char* rgba, void const* block )
             codes[1 + i] = ( unsigned char )( ( ( 7 - i )*alpha0 + i*alpha1 )/7 );
     }
     
-    // decode the indices
-    unsigned char indices[16];
+    // decode the indices and write out the indexed codebook values
     unsigned char const* src = bytes + 2;
-    unsigned char* dest = indices;
     for( int i = 0; i < 2; ++i )
     {
         // grab 3 bytes
-        int value = 0;
-        for( int j = 0; j < 3; ++j )
-        {
-            int byte = *src++;
-            value |= ( byte << 8*j );
-        }
+        unsigned value = src[0] | ( src[1] << 8 ) | ( src[2] << 16 );
+        src += 3;
         
         // unpack 8 3-bit values from it
         for( int j = 0; j < 8; ++j )
         {
-            int index = ( value >> 3*j ) & 0x7;
-            *dest++ = ( unsigned char )index;
+            *alpha++ = codes[value & 0x7];
+            value >>= 3;
         }
     }
-    
-    // write out the indexed codebook values
-    for( int i = 0; i < 16; ++i )
-        rgba[4*i + 3] = codes[indices[i]];
 }
 
-static void DecompressDXT( unsigned char* rgba, const void* block, CompressedFormat format)
+static void DecompressDXT( unsigned char* rgba, int pitch, const void* block, CompressedFormat format)
 {
     // get the block locations
     void const* colourBlock = block;
@@ -208,14 +207,24 @@ static void DecompressDXT( unsigned char* rgba, const void* block, CompressedFor
     if( format == CF_DXT3 || format == CF_DXT5)
         colourBlock = reinterpret_cast< unsigned char const* >( block ) + 8;
     
-    // decompress colour
-    DecompressColourDXT( rgba, colourBlock, format == CF_DXT1 );
-    
     // decompress alpha separately if necessary
+    unsigned char alpha[16];
     if( format == CF_DXT3 )
-        DecompressAlphaDXT3( rgba, alphaBock );
+        DecompressAlphaDXT3( alpha, alphaBock );
     else if ( format == CF_DXT5 )
-        DecompressAlphaDXT5( rgba, alphaBock );
+        DecompressAlphaDXT5( alpha, alphaBock );
+    
+    // decompress colour, combined with the alpha
+    DecompressColourDXT( rgba, pitch, colourBlock, format == CF_DXT1, format == CF_DXT1 ? 0 : alpha );
+}
+
+/// Write a decompressed block of 4x4 RGBA pixels to the image, clipping at the right and bottom edges.
+static void CopyBlockToImage( unsigned char* rgba, const unsigned char* block, int x, int y, int width, int height )
+{
+    int copyWidth = Min( width - x, 4 );
+    int copyHeight = Min( height - y, 4 );
+    for( int py = 0; py < copyHeight; ++py )
+        memcpy( rgba + 4*( width*( y + py ) + x ), block + 16*py, 4*copyWidth );
 }
 
 void DecompressImageDXT( unsigned char* rgba, const void* blocks, int width, int height, CompressedFormat format )
@@ -223,39 +232,21 @@ void DecompressImageDXT( unsigned char* rgba, const void* blocks, int width, int
     // initialise the block input
     unsigned char const* sourceBlock = reinterpret_cast< unsigned char const* >( blocks );
     int bytesPerBlock = format == CF_DXT1 ? 8 : 16;
+    int pitch = 4*width;
     
     // loop over blocks
     for( int y = 0; y < height; y += 4 )
     {
         for( int x = 0; x < width; x += 4 )
         {
-            // decompress the block
-            unsigned char targetRgba[4*16];
-            DecompressDXT( targetRgba, sourceBlock, format );
-            
-            // write the decompressed pixels to the correct image locations
-            unsigned char const* sourcePixel = targetRgba;
-            for( int py = 0; py < 4; ++py )
+            // decompress whole blocks directly to the image, and edge blocks through a temporary block
+            if( x + 4 <= width && y + 4 <= height )
+                DecompressDXT( rgba + pitch*y + 4*x, pitch, sourceBlock, format );
+            else
             {
-                for( int px = 0; px < 4; ++px )
-                {
-                    // get the target location
-                    int sx = x + px;
-                    int sy = y + py;
-                    if( sx < width && sy < height )
-                    {
-                        unsigned char* targetPixel = rgba + 4*( width*sy + sx );
-                        
-                        // copy the rgba value
-                        for( int i = 0; i < 4; ++i )
-                            *targetPixel++ = *sourcePixel++;
-                    }
-                    else
-                    {
-                        // skip this pixel as its outside the image
-                        sourcePixel += 4;
-                    }
-                }
+                unsigned char targetRgba[4*16];
+                DecompressDXT( targetRgba, 16, sourceBlock, format );
+                CopyBlockToImage( rgba, targetRgba, x, y, width, height );
             }
             
             // advance
@@ -298,34 +289,19 @@ const int mod[8][4]={{2, 8,-2,-8},
                     {33, 106, -33, -106},
                     {47, 183, -47, -183}};
 
-// lsb: hgfedcba ponmlkji msb: hgfedcba ponmlkji due to endianness
-static unsigned long ModifyPixel(int red, int green, int blue, int x, int y, unsigned long modBlock, int modTable)
+static void DecompressETC(unsigned char* pDestData, int pitch, const void* pSrcData)
 {
-    int index = x*4+y, pixelMod;
-    unsigned long mostSig = modBlock<<1;
-    if (index<8)    //hgfedcba
-        pixelMod = mod[modTable][((modBlock>>(index+24))&0x1)+((mostSig>>(index+8))&0x2)];
-    else    // ponmlkj
-        pixelMod = mod[modTable][((modBlock>>(index+8))&0x1)+((mostSig>>(index-8))&0x2)];
-    
-    red = _CLAMP_(red+pixelMod,0,255);
-    green = _CLAMP_(green+pixelMod,0,255);
-    blue = _CLAMP_(blue+pixelMod,0,255);
-    
-    return ((blue<<16) + (green<<8) + red)|0xff000000;
-}
-
-static void DecompressETC(unsigned char* pDestData, const void* pSrcData)
-{
-    unsigned long blockTop, blockBot, *input = (unsigned long*)pSrcData, *output;
+    const unsigned char* bytes = (const unsigned char*)pSrcData;
+    unsigned blockTop, blockBot;
     unsigned char red1, green1, blue1, red2, green2, blue2;
     bool bFlip, bDiff;
     int modtable1,modtable2;
     
-    blockTop = *(input++);
-    blockBot = *(input++);
+    // Read the first word in little endian order like the bit masks below expect, and the pixel indices in big
+    // endian order so that the index bits of pixel i are i (least significant) and i + 16 (most significant)
+    blockTop = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned)bytes[3] << 24);
+    blockBot = ((unsigned)bytes[4] << 24) | (bytes[5] << 16) | (bytes[6] << 8) | bytes[7];
     
-    output = (unsigned long*)pDestData;
     // check flipbit
     bFlip = (blockTop & ETC_FLIP) != 0;
     bDiff = (blockTop & ETC_DIFF) != 0;
@@ -376,26 +352,34 @@ static void DecompressETC(unsigned char* pDestData, const void* pSrcData)
     modtable1 = (blockTop>>29)&0x7; 
     modtable2 = (blockTop>>26)&0x7; 
     
-    if(!bFlip)
-    {   // 2 2x4 blocks side by side
-        for(int j=0;j<4;j++)    // vertical
-        {
-            for(int k=0;k<2;k++)    // horizontal
-            {
-                *(output+j*4+k) = ModifyPixel(red1,green1,blue1,k,j,blockBot,modtable1);
-                *(output+j*4+k+2) = ModifyPixel(red2,green2,blue2,k+2,j,blockBot,modtable2);
-            }
-        }
+    // build the modified colours of both subblocks up front instead of per pixel
+    unsigned char codes[2][4][4];
+    for(int i=0;i<4;i++)
+    {
+        int pixelMod1 = mod[modtable1][i];
+        int pixelMod2 = mod[modtable2][i];
+        codes[0][i][0] = (unsigned char)_CLAMP_(red1+pixelMod1,0,255);
+        codes[0][i][1] = (unsigned char)_CLAMP_(green1+pixelMod1,0,255);
+        codes[0][i][2] = (unsigned char)_CLAMP_(blue1+pixelMod1,0,255);
+        codes[0][i][3] = 255;
+        codes[1][i][0] = (unsigned char)_CLAMP_(red2+pixelMod2,0,255);
+        codes[1][i][1] = (unsigned char)_CLAMP_(green2+pixelMod2,0,255);
+        codes[1][i][2] = (unsigned char)_CLAMP_(blue2+pixelMod2,0,255);
+        codes[1][i][3] = 255;
     }
-    else
-    {   // 2 4x2 blocks on top of each other
-        for(int j=0;j<2;j++)
+    
+    unsigned colours[2][4];
+    memcpy(colours, codes, sizeof colours);
+    
+    for(int j=0;j<4;j++)    // vertical
+    {
+        unsigned* output = (unsigned*)(pDestData + j*pitch);
+        for(int k=0;k<4;k++)    // horizontal
         {
-            for(int k=0;k<4;k++)
-            {
-                *(output+j*4+k) = ModifyPixel(red1,green1,blue1,k,j,blockBot,modtable1);
-                *(output+(j+2)*4+k) = ModifyPixel(red2,green2,blue2,k,j+2,blockBot,modtable2);
-            }
+            // pixels are stored column by column
+            int index = k*4+j;
+            int subBlock = bFlip ? (j >> 1) : (k >> 1);
+            output[k] = colours[subBlock][((blockBot>>index)&0x1)|((blockBot>>(index+15))&0x2)];
         }
     }
 }
@@ -405,39 +389,21 @@ void DecompressImageETC( unsigned char* rgba, const void* blocks, int width, int
     // initialise the block input
     unsigned char const* sourceBlock = reinterpret_cast< unsigned char const* >( blocks );
     int bytesPerBlock = 8;
+    int pitch = 4*width;
     
     // loop over blocks
     for( int y = 0; y < height; y += 4 )
     {
         for( int x = 0; x < width; x += 4 )
         {
-            // decompress the block
-            unsigned char targetRgba[4*16];
-            DecompressETC( targetRgba, sourceBlock );
-            
-            // write the decompressed pixels to the correct image locations
-            unsigned char const* sourcePixel = targetRgba;
-            for( int py = 0; py < 4; ++py )
+            // decompress whole blocks directly to the image, and edge blocks through a temporary block
+            if( x + 4 <= width && y + 4 <= height )
+                DecompressETC( rgba + pitch*y + 4*x, pitch, sourceBlock );
+            else
             {
-                for( int px = 0; px < 4; ++px )
-                {
-                    // get the target location
-                    int sx = x + px;
-                    int sy = y + py;
-                    if( sx < width && sy < height )
-                    {
-                        unsigned char* targetPixel = rgba + 4*( width*sy + sx );
-                        
-                        // copy the rgba value
-                        for( int i = 0; i < 4; ++i )
-                            *targetPixel++ = *sourcePixel++;
-                    }
-                    else
-                    {
-                        // skip this pixel as its outside the image
-                        sourcePixel += 4;
-                    }
-                }
+                unsigned char targetRgba[4*16];
+                DecompressETC( targetRgba, 16, sourceBlock );
+                CopyBlockToImage( rgba, targetRgba, x, y, width, height );
             }
             
             // advance
@@ -794,7 +760,63 @@ static unsigned TwiddleUV(unsigned YSize, unsigned XSize, unsigned YPos, unsigne
     return Twiddled;
 }
 
-void DecompressImagePVRTC(unsigned char* dest, const void *blocks, int width, int height, CompressedFormat format)
+#ifdef USE_SSE2_DECOMPRESS
+// Interpolate the A and B colours of a pixel at once in 16-bit lanes (A in the low half, B in the high half), then
+// modulate and store the pixel. Gives the same result as InterpolateColours() followed by the scalar modulation
+static void InterpolateAndModulateSSE2(const __m128i Colours[2][2], const int Do2bitMode, const int x, const int y, int Mod, int DoPT, unsigned char* dest)
+{
+    int u, v, uscale;
+    
+    // Put the x and y values into the right range
+    v = (y & 0x3) | ((~y & 0x2) << 1);
+    if(Do2bitMode)
+    {
+        u = (x & 0x7) | ((~x & 0x4) << 1);
+        u = u - BLK_X_2BPP/2;
+        uscale = 8;
+    }
+    else
+    {
+        u = (x & 0x3) | ((~x & 0x2) << 1);
+        u = u - BLK_X_4BPP/2;
+        uscale = 4;
+    }
+    v  = v - BLK_Y_SIZE/2;
+    
+    __m128i uVec = _mm_set1_epi16((short)u);
+    __m128i uScaleVec = _mm_set1_epi16((short)uscale);
+    __m128i tmp1 = _mm_add_epi16(_mm_mullo_epi16(Colours[0][0], uScaleVec), _mm_mullo_epi16(uVec, _mm_sub_epi16(Colours[0][1], Colours[0][0])));
+    __m128i tmp2 = _mm_add_epi16(_mm_mullo_epi16(Colours[1][0], uScaleVec), _mm_mullo_epi16(uVec, _mm_sub_epi16(Colours[1][1], Colours[1][0])));
+    __m128i result = _mm_add_epi16(_mm_slli_epi16(tmp1, 2), _mm_mullo_epi16(_mm_set1_epi16((short)v), _mm_sub_epi16(tmp2, tmp1)));
+    
+    // Lop off the bits to get to 8 bit precision. The values are never negative, so the alpha lanes can be doubled
+    // first to shift them one bit less than RGB
+    if(Do2bitMode)
+    {
+        result = _mm_srai_epi16(_mm_mullo_epi16(result, _mm_set_epi16(2, 1, 1, 1, 2, 1, 1, 1)), 2);
+    }
+    else
+    {
+        result = _mm_srai_epi16(_mm_mullo_epi16(result, _mm_set_epi16(2, 1, 1, 1, 2, 1, 1, 1)), 1);
+    }
+    
+    // Convert from 5554 to 8888, with the same doubling trick for alpha
+    result = _mm_add_epi16(result, _mm_srai_epi16(_mm_mullo_epi16(result, _mm_set_epi16(2, 1, 1, 1, 2, 1, 1, 1)), 5));
+    
+    // Compute the modulated colour
+    __m128i delta = _mm_sub_epi16(_mm_unpackhi_epi64(result, result), result);
+    result = _mm_srai_epi16(_mm_add_epi16(_mm_slli_epi16(result, 3), _mm_mullo_epi16(_mm_set1_epi16((short)Mod), delta)), 3);
+    
+    unsigned pixel = (unsigned)_mm_cvtsi128_si32(_mm_packus_epi16(result, result));
+    memcpy(dest, &pixel, 4);
+    if(DoPT)
+    {
+        dest[3] = 0;
+    }
+}
+#endif
+
+void DecompressImagePVRTC(unsigned char* dest, const void *blocks, int width, int height, CompressedFormat format, int startY, int endY)
 {
     AMTC_BLOCK_STRUCT* pCompressedData = (AMTC_BLOCK_STRUCT*)blocks;
     int AssumeImageTiles = 1;
@@ -815,12 +837,11 @@ void DecompressImagePVRTC(unsigned char* dest, const void *blocks, int width, in
     
     int Mod, DoPT;
     
-    unsigned int uPosition;
-    
     // Local neighbourhood of blocks
     AMTC_BLOCK_STRUCT *pBlocks[2][2];
     
     AMTC_BLOCK_STRUCT *pPrevious[2][2] = {{NULL, NULL}, {NULL, NULL}};
+    int PrevBlkX = -1, PrevBlkY = -1;
     
     // Low precision colours extracted from the blocks
     struct
@@ -828,9 +849,15 @@ void DecompressImagePVRTC(unsigned char* dest, const void *blocks, int width, in
         int Reps[2][4];
     } Colours5554[2][2];
     
+    #ifdef USE_SSE2_DECOMPRESS
+    // The same colours as 16-bit vectors
+    __m128i ColoursSSE2[2][2];
+    #else
     // Interpolated A and B colours for the pixel
     int ASig[4], BSig[4];
     int Result[4];
+    unsigned int uPosition;
+    #endif
     
     if(Do2bitMode)
     {
@@ -845,32 +872,43 @@ void DecompressImagePVRTC(unsigned char* dest, const void *blocks, int width, in
     BlkXDim = _MAX(2, width / XBlockSize);
     BlkYDim = _MAX(2, height / BLK_Y_SIZE);
     
+    if(endY < 0 || endY > height)
+    {
+        endY = height;
+    }
+    
     // Step through the pixels of the image decompressing each one in turn
-    //
-    // Note that this is a hideously inefficient way to do this!
-    for(y = 0; y < height; y++)
+    for(y = startY; y < endY; y++)
     {
+        // Map this row to the top neighbourhood of blocks
+        BlkY = (y - BLK_Y_SIZE/2);
+        BlkY = LIMIT_COORD(BlkY, height, AssumeImageTiles);
+        BlkY /= BLK_Y_SIZE;
+        BlkYp1 = LIMIT_COORD(BlkY+1, BlkYDim, AssumeImageTiles);
+        
         for(x = 0; x < width; x++)
         {
-            // Map this pixel to the top left neighbourhood of blocks
+            // Map this pixel to the left neighbourhood of blocks
             BlkX = (x - XBlockSize/2);
-            BlkY = (y - BLK_Y_SIZE/2);
-            
             BlkX = LIMIT_COORD(BlkX, width, AssumeImageTiles);
-            BlkY = LIMIT_COORD(BlkY, height, AssumeImageTiles);
-            
             BlkX /= XBlockSize;
-            BlkY /= BLK_Y_SIZE;
             
-            // Compute the positions of the other 3 blocks
-            BlkXp1 = LIMIT_COORD(BlkX+1, BlkXDim, AssumeImageTiles);
-            BlkYp1 = LIMIT_COORD(BlkY+1, BlkYDim, AssumeImageTiles);
-            
-            // Map to block memory locations
-            pBlocks[0][0] = pCompressedData + TwiddleUV(BlkYDim, BlkXDim, BlkY, BlkX);
-            pBlocks[0][1] = pCompressedData + TwiddleUV(BlkYDim, BlkXDim, BlkY, BlkXp1);
-            pBlocks[1][0] = pCompressedData + TwiddleUV(BlkYDim, BlkXDim, BlkYp1, BlkX);
-            pBlocks[1][1] = pCompressedData + TwiddleUV(BlkYDim, BlkXDim, BlkYp1, BlkXp1);
+            // Locate the blocks and extract the colours and the modulation information only when the
+            // neighbourhood changes, which happens once per block width
+            if(BlkX != PrevBlkX || BlkY != PrevBlkY)
+            {
+                PrevBlkX = BlkX;
+                PrevBlkY = BlkY;
+                
+                // Compute the positions of the other 3 blocks
+                BlkXp1 = LIMIT_COORD(BlkX+1, BlkXDim, AssumeImageTiles);
+                
+                // Map to block memory locations
+                pBlocks[0][0] = pCompressedData + TwiddleUV(BlkYDim, BlkXDim, BlkY, BlkX);
+                pBlocks[0][1] = pCompressedData + TwiddleUV(BlkYDim, BlkXDim, BlkY, BlkXp1);
+                pBlocks[1][0] = pCompressedData + TwiddleUV(BlkYDim, BlkXDim, BlkYp1, BlkX);
+                pBlocks[1][1] = pCompressedData + TwiddleUV(BlkYDim, BlkXDim, BlkYp1, BlkXp1);
+            }
             
             // Extract the colours and the modulation information IF the previous values
             // have changed.
@@ -898,8 +936,26 @@ void DecompressImagePVRTC(unsigned char* dest, const void *blocks, int width, in
                 
                 // Make a copy of the new pointers
                 memcpy(pPrevious, pBlocks, 4*sizeof(void*));
+                
+                #ifdef USE_SSE2_DECOMPRESS
+                for(i = 0; i < 2; i++)
+                {
+                    for(j = 0; j < 2; j++)
+                    {
+                        const int (*Reps)[4] = Colours5554[i][j].Reps;
+                        ColoursSSE2[i][j] = _mm_set_epi16((short)Reps[1][3], (short)Reps[1][2], (short)Reps[1][1], (short)Reps[1][0],
+                            (short)Reps[0][3], (short)Reps[0][2], (short)Reps[0][1], (short)Reps[0][0]);
+                    }
+                }
+                #endif
             }
             
+            GetModulationValue(x,y, Do2bitMode, (const int (*)[16])ModulationVals, (const int (*)[16])ModulationModes,
+                               &Mod, &DoPT);
+            
+            #ifdef USE_SSE2_DECOMPRESS
+            InterpolateAndModulateSSE2(ColoursSSE2, Do2bitMode, x, y, Mod, DoPT, dest + ((x+y*width)<<2));
+            #else
             // Decompress the pixel.  First compute the interpolated A and B signals
             InterpolateColours(Colours5554[0][0].Reps[0],
                                Colours5554[0][1].Reps[0],
@@ -915,9 +971,6 @@ void DecompressImagePVRTC(unsigned char* dest, const void *blocks, int width, in
                                Do2bitMode, x, y,
                                BSig);
             
-            GetModulationValue(x,y, Do2bitMode, (const int (*)[16])ModulationVals, (const int (*)[16])ModulationModes,
-                               &Mod, &DoPT);
-            
             // Compute the modulated colour
             for(i = 0; i < 4; i++)
             {
@@ -935,6 +988,7 @@ void DecompressImagePVRTC(unsigned char* dest, const void *blocks, int width, in
             dest[uPosition+1] = (unsigned char)Result[1];
             dest[uPosition+2] = (unsigned char)Result[2];
             dest[uPosition+3] = (unsigned char)Result[3];
+            #endif
         }
     }
 }
@@ -31,7 +31,7 @@ namespace Urho3D
 void DecompressImageDXT(unsigned char* dest, const void* blocks, int width, int height, CompressedFormat format);
 /// Decompress an ETC1 compressed image to RGBA.
 void DecompressImageETC(unsigned char* dest, const void* blocks, int width, int height);
-/// Decompress a PVRTC compressed image to RGBA.
-void DecompressImagePVRTC(unsigned char* dest, const void* blocks, int width, int height, CompressedFormat format);
+/// Decompress a PVRTC compressed image to RGBA. Optionally decompress only the pixel rows from startY up to but not including endY.
+void DecompressImagePVRTC(unsigned char* dest, const void* blocks, int width, int height, CompressedFormat format, int startY = 0, int endY = -1);
 
 }
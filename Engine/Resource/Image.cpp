@@ -21,17 +21,26 @@
 //
 
 #include "Precompiled.h"
+#include "Compress.h"
 #include "Context.h"
 #include "Decompress.h"
 #include "File.h"
 #include "FileSystem.h"
 #include "Log.h"
+#include "Profiler.h"
+#include "Thread.h"
+#include "WorkQueue.h"
 
 #include <cstring>
 #include <stb_image.h>
 #include <stb_image_write.h>
 #include <jo_jpeg.h>
 
+#if defined(ENABLE_SSE) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define USE_SSE2_MIPS
+#endif
+
 #include "DebugNew.h"
 
 #ifndef MAKEFOURCC
@@ -44,9 +53,22 @@
 #define FOURCC_DXT4 (MAKEFOURCC('D','X','T','4'))
 #define FOURCC_DXT5 (MAKEFOURCC('D','X','T','5'))
 
+#define DDSD_CAPS 0x00000001
+#define DDSD_HEIGHT 0x00000002
+#define DDSD_WIDTH 0x00000004
+#define DDSD_PIXELFORMAT 0x00001000
+#define DDSD_MIPMAPCOUNT 0x00020000
+#define DDSD_LINEARSIZE 0x00080000
+#define DDPF_FOURCC 0x00000004
+#define DDSCAPS_COMPLEX 0x00000008
+#define DDSCAPS_TEXTURE 0x00001000
+#define DDSCAPS_MIPMAP 0x00400000
+
 namespace Urho3D
 {
 
+static const int DECOMPRESS_ROWS_PER_WORK_ITEM = 64;
+
 struct DDColorKey
 {
     unsigned dwColorSpaceLowValue_;
@@ -160,7 +182,56 @@ struct DDSurfaceDesc2
     unsigned dwTextureStage_;
 };
 
-bool CompressedLevel::Decompress(unsigned char* dest)
+/// Band of pixel rows to decompress in a work item.
+struct DecompressTask
+{
+    /// Compressed level.
+    const CompressedLevel* level_;
+    /// Destination RGBA image.
+    unsigned char* dest_;
+    /// First pixel row.
+    int startY_;
+    /// Pixel row to stop at.
+    int endY_;
+};
+
+/// Decompress a band of pixel rows. For the block formats the start row must be a multiple of 4.
+static void DecompressRows(const CompressedLevel& level, unsigned char* dest, int startY, int endY)
+{
+    switch (level.format_)
+    {
+    case CF_DXT1:
+    case CF_DXT3:
+    case CF_DXT5:
+        DecompressImageDXT(dest + startY * level.width_ * 4, level.data_ + (startY / 4) * level.rowSize_, level.width_,
+            endY - startY, level.format_);
+        break;
+        
+    case CF_ETC1:
+        DecompressImageETC(dest + startY * level.width_ * 4, level.data_ + (startY / 4) * level.rowSize_, level.width_,
+            endY - startY);
+        break;
+        
+    default:
+        DecompressImagePVRTC(dest, level.data_, level.width_, level.height_, level.format_, startY, endY);
+        break;
+    }
+}
+
+/// Decompress work function.
+static void DecompressRowsWork(const WorkItem* item, unsigned threadIndex)
+{
+    DecompressTask* start = reinterpret_cast<DecompressTask*>(item->start_);
+    DecompressTask* end = reinterpret_cast<DecompressTask*>(item->end_);
+    
+    while (start != end)
+    {
+        DecompressRows(*start->level_, start->dest_, start->startY_, start->endY_);
+        ++start;
+    }
+}
+
+bool CompressedLevel::Decompress(unsigned char* dest, WorkQueue* queue) const
 {
     if (!data_)
         return false;
@@ -170,24 +241,97 @@ bool CompressedLevel::Decompress(unsigned char* dest)
     case CF_DXT1:
     case CF_DXT3:
     case CF_DXT5:
-        DecompressImageDXT(dest, data_, width_, height_, format_);
-        return true;
-        
     case CF_ETC1:
-        DecompressImageETC(dest, data_, width_, height_);
-        return true;
-        
     case CF_PVRTC_RGB_2BPP:
     case CF_PVRTC_RGBA_2BPP:
     case CF_PVRTC_RGB_4BPP:
     case CF_PVRTC_RGBA_4BPP:
-        DecompressImagePVRTC(dest, data_, width_, height_, format_);
-        return true;
-    
+        break;
+        
     default:
-         // Unknown format
-         return false;
-    }    
+        // Unknown format
+        return false;
+    }
+    
+    // Rows and block rows are independent, so large images can be decompressed in bands on the worker threads
+    if (queue && queue->GetNumThreads() && Thread::IsMainThread() && height_ > DECOMPRESS_ROWS_PER_WORK_ITEM)
+    {
+        Vector<DecompressTask> tasks;
+        for (int y = 0; y < height_; y += DECOMPRESS_ROWS_PER_WORK_ITEM)
+        {
+            DecompressTask task;
+            task.level_ = this;
+            task.dest_ = dest;
+            task.startY_ = y;
+            task.endY_ = Min(y + DECOMPRESS_ROWS_PER_WORK_ITEM, height_);
+            tasks.Push(task);
+        }
+        
+        WorkItem item;
+        item.workFunction_ = DecompressRowsWork;
+        for (unsigned i = 0; i < tasks.Size(); ++i)
+        {
+            item.start_ = &tasks[i];
+            item.end_ = &tasks[i] + 1;
+            queue->AddWorkItem(item);
+        }
+        
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+        DecompressRows(*this, dest, 0, height_);
+    
+    return true;
+}
+
+/// Box filter the start of two pixel rows into a half-width mip level row with SSE2, if available. Components must be 1, 2 or 4. Return number of output bytes written, the rest is left to the caller.
+static int DownsampleSSE2(const unsigned char* inUpper, const unsigned char* inLower, unsigned char* out, int outBytes, unsigned components)
+{
+    #ifdef USE_SSE2_MIPS
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    int x = 0;
+    
+    // Each iteration reads 32 bytes from both rows and writes 16 bytes
+    for (; x + 16 <= outBytes; x += 16)
+    {
+        __m128i sums[2];
+        for (unsigned i = 0; i < 2; ++i)
+        {
+            __m128i upper = _mm_loadu_si128((const __m128i*)(inUpper + x * 2 + i * 16));
+            __m128i lower = _mm_loadu_si128((const __m128i*)(inLower + x * 2 + i * 16));
+            // Sum the rows as 16-bit values
+            __m128i a = _mm_add_epi16(_mm_unpacklo_epi8(upper, zero), _mm_unpacklo_epi8(lower, zero));
+            __m128i b = _mm_add_epi16(_mm_unpackhi_epi8(upper, zero), _mm_unpackhi_epi8(lower, zero));
+            
+            // Then sum horizontally adjacent pixels
+            switch (components)
+            {
+            case 1:
+                sums[i] = _mm_packs_epi32(_mm_madd_epi16(a, ones), _mm_madd_epi16(b, ones));
+                break;
+                
+            case 2:
+                a = _mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0));
+                b = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0));
+                sums[i] = _mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+                break;
+                
+            default:
+                sums[i] = _mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+                break;
+            }
+            
+            sums[i] = _mm_srli_epi16(sums[i], 2);
+        }
+        
+        _mm_storeu_si128((__m128i*)(out + x), _mm_packus_epi16(sums[0], sums[1]));
+    }
+    
+    return x;
+    #else
+    return 0;
+    #endif
 }
 
 OBJECTTYPESTATIC(Image);
@@ -209,8 +353,10 @@ void Image::RegisterObject(Context* context)
     context->RegisterFactory<Image>();
 }
 
-bool Image::Load(Deserializer& source)
+bool Image::BeginLoad(Deserializer& source)
 {
+    nextLevel_.Reset();
+    
     // Check for DDS, KTX or PVR compressed format
     String fileID = source.ReadFileID();
     
@@ -478,6 +624,12 @@ bool Image::Load(Deserializer& source)
     return true;
 }
 
+bool Image::EndLoad()
+{
+    // No main thread processing needed
+    return true;
+}
+
 void Image::SetSize(int width, int height, unsigned components)
 {
     if (width == width_ && height == height_ && components == components_)
@@ -486,6 +638,7 @@ void Image::SetSize(int width, int height, unsigned components)
     if (width <= 0 || height <= 0)
         return;
     
+    nextLevel_.Reset();
     data_ = new unsigned char[width * height * components];
     width_ = width;
     height_ = height;
@@ -514,11 +667,13 @@ void Image::FlipVertical()
         memcpy(&newData[(height_ - y - 1) * rowSize], &data_[y * rowSize], rowSize);
     
     data_ = newData;
+    nextLevel_.Reset();
 }
 
 void Image::SetData(const unsigned char* pixelData)
 {
     memcpy(data_.Get(), pixelData, width_ * height_ * components_);
+    nextLevel_.Reset();
 }
 
 bool Image::SaveBMP(const String& fileName)
@@ -605,6 +760,162 @@ bool Image::SaveJPG(const String & fileName, int quality)
         return false;
 }
 
+bool Image::SaveDDS(const String& fileName)
+{
+    FileSystem* fileSystem = GetSubsystem<FileSystem>();
+    if (fileSystem && !fileSystem->CheckAccess(GetPath(fileName)))
+    {
+        LOGERROR("Access denied to " + fileName);
+        return false;
+    }
+    
+    if (compressedFormat_ != CF_DXT1 && compressedFormat_ != CF_DXT3 && compressedFormat_ != CF_DXT5)
+    {
+        LOGERROR("Can only save DXT compressed images to DDS");
+        return false;
+    }
+    
+    File outFile(context_, fileName, FILE_WRITE);
+    if (!outFile.IsOpen())
+        return false;
+    
+    DDSurfaceDesc2 ddsd;
+    memset(&ddsd, 0, sizeof ddsd);
+    ddsd.dwSize_ = sizeof ddsd;
+    ddsd.dwFlags_ = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE;
+    ddsd.dwWidth_ = width_;
+    ddsd.dwHeight_ = height_;
+    ddsd.dwLinearSize_ = GetCompressedLevel(0).dataSize_;
+    ddsd.ddpfPixelFormat_.dwSize_ = sizeof(DDPixelFormat);
+    ddsd.ddpfPixelFormat_.dwFlags_ = DDPF_FOURCC;
+    ddsd.ddsCaps_.dwCaps_ = DDSCAPS_TEXTURE;
+    if (numCompressedLevels_ > 1)
+    {
+        ddsd.dwFlags_ |= DDSD_MIPMAPCOUNT;
+        ddsd.dwMipMapCount_ = numCompressedLevels_;
+        ddsd.ddsCaps_.dwCaps_ |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+    }
+    
+    switch (compressedFormat_)
+    {
+    case CF_DXT1:
+        ddsd.ddpfPixelFormat_.dwFourCC_ = FOURCC_DXT1;
+        break;
+        
+    case CF_DXT3:
+        ddsd.ddpfPixelFormat_.dwFourCC_ = FOURCC_DXT3;
+        break;
+        
+    default:
+        ddsd.ddpfPixelFormat_.dwFourCC_ = FOURCC_DXT5;
+        break;
+    }
+    
+    outFile.WriteFileID("DDS ");
+    outFile.Write(&ddsd, sizeof ddsd);
+    return outFile.Write(data_.Get(), GetMemoryUse()) == GetMemoryUse();
+}
+
+bool Image::Compress(CompressedFormat format, CompressQuality quality, bool generateLevels)
+{
+    if (format != CF_DXT1 && format != CF_DXT5)
+    {
+        LOGERROR("Only DXT1 and DXT5 compression is supported");
+        return false;
+    }
+    if (IsCompressed())
+    {
+        LOGERROR("Image is already compressed");
+        return false;
+    }
+    if (!data_)
+        return false;
+    if (components_ < 1 || components_ > 4)
+    {
+        LOGERROR("Illegal number of image components for compression");
+        return false;
+    }
+    
+    PROFILE(CompressImage);
+    
+    unsigned blockSize = format == CF_DXT1 ? 8 : 16;
+    
+    // Calculate the size of all levels first
+    unsigned numLevels = 0;
+    unsigned totalSize = 0;
+    int levelWidth = width_;
+    int levelHeight = height_;
+    for (;;)
+    {
+        totalSize += ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockSize;
+        ++numLevels;
+        if (!generateLevels || (levelWidth == 1 && levelHeight == 1))
+            break;
+        levelWidth = Max(levelWidth / 2, 1);
+        levelHeight = Max(levelHeight / 2, 1);
+    }
+    
+    SharedArrayPtr<unsigned char> compressedData(new unsigned char[totalSize]);
+    SharedArrayPtr<unsigned char> rgbaData(new unsigned char[width_ * height_ * 4]);
+    unsigned char* dest = compressedData.Get();
+    const Image* level = this;
+    SharedPtr<Image> nextLevel;
+    
+    for (unsigned i = 0; i < numLevels; ++i)
+    {
+        // Expand the level to RGBA for the compressor
+        unsigned numPixels = level->width_ * level->height_;
+        const unsigned char* src = level->data_.Get();
+        unsigned char* rgba = rgbaData.Get();
+        for (unsigned j = 0; j < numPixels; ++j)
+        {
+            switch (components_)
+            {
+            case 1:
+                rgba[0] = rgba[1] = rgba[2] = src[0];
+                rgba[3] = 255;
+                break;
+                
+            case 2:
+                rgba[0] = rgba[1] = rgba[2] = src[0];
+                rgba[3] = src[1];
+                break;
+                
+            case 3:
+                rgba[0] = src[0];
+                rgba[1] = src[1];
+                rgba[2] = src[2];
+                rgba[3] = 255;
+                break;
+                
+            default:
+                memcpy(rgba, src, 4);
+                break;
+            }
+            
+            src += components_;
+            rgba += 4;
+        }
+        
+        CompressImageDXT(dest, rgbaData.Get(), level->width_, level->height_, format, quality);
+        dest += ((level->width_ + 3) / 4) * ((level->height_ + 3) / 4) * blockSize;
+        
+        if (i < numLevels - 1)
+        {
+            nextLevel = level->GetNextLevel();
+            level = nextLevel;
+        }
+    }
+    
+    data_ = compressedData;
+    nextLevel_.Reset();
+    compressedFormat_ = format;
+    components_ = format == CF_DXT1 ? 3 : 4;
+    numCompressedLevels_ = numLevels;
+    SetMemoryUse(totalSize);
+    return true;
+}
+
 unsigned char* Image::GetImageData(Deserializer& source, int& width, int& height, unsigned& components)
 {
     unsigned dataSize = source.GetSize();
@@ -622,8 +933,32 @@ void Image::FreeImageData(unsigned char* pixelData)
     stbi_image_free(pixelData);
 }
 
+void Image::PrecalculateLevels()
+{
+    if (!data_ || IsCompressed())
+        return;
+    
+    PROFILE(PrecalculateImageMipLevels);
+    
+    nextLevel_.Reset();
+    
+    if (width_ > 1 || height_ > 1)
+    {
+        SharedPtr<Image> current = GetNextLevel();
+        nextLevel_ = current;
+        while (current && (current->width_ > 1 || current->height_ > 1))
+        {
+            current->nextLevel_ = current->GetNextLevel();
+            current = current->nextLevel_;
+        }
+    }
+}
+
 SharedPtr<Image> Image::GetNextLevel() const
 {
+    if (nextLevel_)
+        return nextLevel_;
+    
     if (IsCompressed())
     {
         LOGERROR("Can not generate mip level from compressed data");
@@ -703,7 +1038,7 @@ SharedPtr<Image> Image::GetNextLevel() const
                 const unsigned char* inLower = &pixelDataIn[(y*2+1)*width_];
                 unsigned char* out = &pixelDataOut[y*widthOut];
                 
-                for (int x = 0; x < widthOut; ++x)
+                for (int x = DownsampleSSE2(inUpper, inLower, out, widthOut, 1); x < widthOut; ++x)
                 {
                     out[x] = ((unsigned)inUpper[x*2] + inUpper[x*2+1] + inLower[x*2] + inLower[x*2+1]) >> 2;
                 }
@@ -717,7 +1052,7 @@ SharedPtr<Image> Image::GetNextLevel() const
                 const unsigned char* inLower = &pixelDataIn[(y*2+1)*width_*2];
                 unsigned char* out = &pixelDataOut[y*widthOut*2];
                 
-                for (int x = 0; x < widthOut*2; x += 2)
+                for (int x = DownsampleSSE2(inUpper, inLower, out, widthOut*2, 2); x < widthOut*2; x += 2)
                 {
                     out[x] = ((unsigned)inUpper[x*2] + inUpper[x*2+2] + inLower[x*2] + inLower[x*2+2]) >> 2;
                     out[x+1] = ((unsigned)inUpper[x*2+1] + inUpper[x*2+3] + inLower[x*2+1] + inLower[x*2+3]) >> 2;
@@ -748,7 +1083,7 @@ SharedPtr<Image> Image::GetNextLevel() const
                 const unsigned char* inLower = &pixelDataIn[(y*2+1)*width_*4];
                 unsigned char* out = &pixelDataOut[y*widthOut*4];
                 
-                for (int x = 0; x < widthOut*4; x += 4)
+                for (int x = DownsampleSSE2(inUpper, inLower, out, widthOut*4, 4); x < widthOut*4; x += 4)
                 {
                     out[x] = ((unsigned)inUpper[x*2] + inUpper[x*2+4] + inLower[x*2] + inLower[x*2+4]) >> 2;
                     out[x+1] = ((unsigned)inUpper[x*2+1] + inUpper[x*2+5] + inLower[x*2+1] + inLower[x*2+5]) >> 2;
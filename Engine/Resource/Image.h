@@ -28,6 +28,8 @@
 namespace Urho3D
 {
 
+class WorkQueue;
+
 /// Supported compressed image formats.
 enum CompressedFormat
 {
@@ -42,6 +44,14 @@ enum CompressedFormat
     CF_PVRTC_RGBA_4BPP,
 };
 
+/// Image compression quality.
+enum CompressQuality
+{
+    CQ_FAST = 0,
+    CQ_NORMAL,
+    CQ_HIGH
+};
+
 /// Compressed image mip level.
 struct CompressedLevel
 {
@@ -57,8 +67,8 @@ struct CompressedLevel
     {
     }
     
-    /// Decompress to RGBA. The destination buffer required is width * height * 4 bytes. Return true if successful.
-    bool Decompress(unsigned char* dest);
+    /// Decompress to RGBA. The destination buffer required is width * height * 4 bytes. If a work queue with worker threads is given and called from the main thread, decompress bands of rows in parallel. Return true if successful.
+    bool Decompress(unsigned char* dest, WorkQueue* queue = 0) const;
     
     /// Compressed image data.
     unsigned char* data_;
@@ -91,8 +101,10 @@ public:
     /// Register object factory.
     static void RegisterObject(Context* context);
     
-    /// Load resource. Return true if successful.
-    virtual bool Load(Deserializer& source);
+    /// Load resource from stream. May be called from a worker thread. Return true if successful.
+    virtual bool BeginLoad(Deserializer& source);
+    /// Finish resource loading. Always called from the main thread. Return true if successful.
+    virtual bool EndLoad();
     
     /// Set size and number of color components.
     void SetSize(int width, int height, unsigned components);
@@ -108,6 +120,12 @@ public:
     bool SaveTGA(const String& fileName);
     /// Save in JPG format with compression quality. Return true if successful.
     bool SaveJPG(const String& fileName, int quality);
+    /// Save a DXT compressed image in DDS format. Return true if successful.
+    bool SaveDDS(const String& fileName);
+    /// Compress to DXT1 or DXT5 format, optionally with all mip levels. Return true if successful.
+    bool Compress(CompressedFormat format, CompressQuality quality = CQ_NORMAL, bool generateLevels = true);
+    /// Precalculate the mip levels, so that GetNextLevel() returns them without further work. Used by textures loading in the background.
+    void PrecalculateLevels();
     
     /// Return width.
     int GetWidth() const { return width_; }
@@ -123,7 +141,7 @@ public:
     CompressedFormat GetCompressedFormat() const { return compressedFormat_; }
     /// Return number of compressed mip levels.
     unsigned GetNumCompressedLevels() const { return numCompressedLevels_; }
-    /// Return next mip level by bilinear filtering.
+    /// Return next mip level by bilinear filtering. Returns the precalculated level if available.
     SharedPtr<Image> GetNextLevel() const;
     /// Return a compressed mip level.
     CompressedLevel GetCompressedLevel(unsigned index) const;
@@ -146,6 +164,8 @@ private:
     CompressedFormat compressedFormat_;
     /// Pixel data.
     SharedArrayPtr<unsigned char> data_;
+    /// Precalculated mip level image.
+    SharedPtr<Image> nextLevel_;
 };
 
 }
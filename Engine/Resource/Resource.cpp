@@ -22,22 +22,77 @@
 
 #include "Precompiled.h"
 #include "Log.h"
+#include "MemoryBuffer.h"
 #include "Resource.h"
+#include "ResourceCache.h"
 
 namespace Urho3D
 {
 
+/// Memory stream for resource data read by the default BeginLoad(), which retains the name of the original stream.
+class ResourceDataBuffer : public MemoryBuffer
+{
+public:
+    /// Construct.
+    ResourceDataBuffer(const PODVector<unsigned char>& data, const String& name) :
+        MemoryBuffer(data),
+        name_(name)
+    {
+    }
+    
+    /// Return name of the original stream.
+    virtual const String& GetName() const { return name_; }
+    
+private:
+    /// Stream name.
+    String name_;
+};
+
 OBJECTTYPESTATIC(Resource);
 
 Resource::Resource(Context* context) :
     Object(context),
-    memoryUse_(0)
+    memoryUse_(0),
+    gpuMemoryUse_(0),
+    lastUseFrame_(0),
+    asyncLoadState_(ASYNC_DONE),
+    endLoading_(false),
+    group_(0),
+    lruPrev_(0),
+    lruNext_(0)
 {
 }
 
-bool Resource::Load(Deserializer& src)
+bool Resource::Load(Deserializer& source)
 {
-    return false;
+    // If neither Load() nor BeginLoad() and EndLoad() are overridden, the default EndLoad() calls back here
+    if (endLoading_)
+    {
+        LOGERROR("Load not supported for " + GetTypeName());
+        return false;
+    }
+    
+    return BeginLoad(source) && EndLoad();
+}
+
+bool Resource::BeginLoad(Deserializer& source)
+{
+    unsigned dataSize = source.GetSize();
+    loadData_.Resize(dataSize);
+    loadDataName_ = source.GetName();
+    return dataSize && source.Read(&loadData_[0], dataSize) == dataSize;
+}
+
+bool Resource::EndLoad()
+{
+    ResourceDataBuffer buffer(loadData_, loadDataName_);
+    endLoading_ = true;
+    bool success = Load(buffer);
+    endLoading_ = false;
+    
+    loadData_.Clear();
+    loadDataName_.Clear();
+    return success;
 }
 
 bool Resource::Save(Serializer& dest) const
@@ -54,12 +109,33 @@ void Resource::SetName(const String& name)
 
 void Resource::SetMemoryUse(unsigned size)
 {
+    // Keep the memory use total of the resource group up to date
+    if (group_)
+        group_->memoryUse_ = group_->memoryUse_ - memoryUse_ + size;
+    
     memoryUse_ = size;
 }
 
+void Resource::SetGPUMemoryUse(unsigned size)
+{
+    if (group_)
+        group_->gpuMemoryUse_ = group_->gpuMemoryUse_ - gpuMemoryUse_ + size;
+    
+    gpuMemoryUse_ = size;
+}
+
 void Resource::ResetUseTimer()
 {
     useTimer_.Reset();
+    
+    Time* time = GetSubsystem<Time>();
+    if (time)
+        lastUseFrame_ = time->GetFrameNumber();
+}
+
+void Resource::SetAsyncLoadState(AsyncLoadState newState)
+{
+    asyncLoadState_ = newState;
 }
 
 unsigned Resource::GetUseTimer()
@@ -30,18 +30,40 @@ namespace Urho3D
 
 class Deserializer;
 class Serializer;
+struct ResourceGroup;
+
+/// Asynchronous loading state of a resource.
+enum AsyncLoadState
+{
+    /// No asynchronous operation in progress.
+    ASYNC_DONE = 0,
+    /// Queued for asynchronous loading.
+    ASYNC_QUEUED,
+    /// BeginLoad() in progress, possibly in a worker thread.
+    ASYNC_LOADING,
+    /// BeginLoad() succeeded. EndLoad() can be called in the main thread.
+    ASYNC_SUCCESS,
+    /// BeginLoad() failed.
+    ASYNC_FAIL
+};
 
 /// Base class for resources.
 class Resource : public Object
 {
     OBJECT(Resource);
     
+    friend class ResourceCache;
+    
 public:
     /// Construct.
     Resource(Context* context);
     
-    /// Load resource. Return true if successful.
+    /// Load resource synchronously. By default calls BeginLoad() and EndLoad(), or fails if neither these nor Load() are overridden. Return true if successful.
     virtual bool Load(Deserializer& source);
+    /// Load resource from a stream. May be called from a worker thread. By default only reads the data into memory, to be parsed by Load() in EndLoad(). Subclasses must override either Load(), or BeginLoad() and EndLoad(). Return true if successful.
+    virtual bool BeginLoad(Deserializer& source);
+    /// Finish resource loading. Always called from the main thread. Return true if successful.
+    virtual bool EndLoad();
     /// Save resource. Return true if successful.
     virtual bool Save(Serializer& dest) const;
     
@@ -49,8 +71,12 @@ public:
     void SetName(const String& name);
     /// Set memory use in bytes, possibly approximate.
     void SetMemoryUse(unsigned size);
+    /// Set the part of the memory use in bytes which resides in GPU memory.
+    void SetGPUMemoryUse(unsigned size);
     /// Reset last used timer.
     void ResetUseTimer();
+    /// Set asynchronous loading state. Called by the resource cache.
+    void SetAsyncLoadState(AsyncLoadState newState);
     
     /// Return name.
     const String& GetName() const { return name_; }
@@ -58,8 +84,16 @@ public:
     StringHash GetNameHash() const { return nameHash_; }
     /// Return memory use in bytes, possibly approximate.
     unsigned GetMemoryUse() const { return memoryUse_; }
+    /// Return the part of the memory use in bytes which resides in GPU memory.
+    unsigned GetGPUMemoryUse() const { return gpuMemoryUse_; }
+    /// Return the part of the memory use in bytes which resides in CPU memory, including any shadow copies of GPU data.
+    unsigned GetCPUMemoryUse() const { return memoryUse_ > gpuMemoryUse_ ? memoryUse_ - gpuMemoryUse_ : 0; }
     /// Return time since last use in milliseconds. If referred to elsewhere than in the resource cache, returns always zero.
     unsigned GetUseTimer();
+    /// Return the frame number on which the resource was last requested from the resource cache.
+    unsigned GetLastUseFrame() const { return lastUseFrame_; }
+    /// Return asynchronous loading state.
+    AsyncLoadState GetAsyncLoadState() const { return asyncLoadState_; }
     
 private:
     /// Name.
@@ -70,6 +104,24 @@ private:
     Timer useTimer_;
     /// Memory use in bytes.
     unsigned memoryUse_;
+    /// GPU memory use in bytes.
+    unsigned gpuMemoryUse_;
+    /// Frame number of last use.
+    unsigned lastUseFrame_;
+    /// Data read by the default BeginLoad().
+    PODVector<unsigned char> loadData_;
+    /// Name of the stream the data was read from.
+    String loadDataName_;
+    /// Asynchronous loading state.
+    AsyncLoadState asyncLoadState_;
+    /// Default EndLoad() in progress flag.
+    bool endLoading_;
+    /// Resource group in the resource cache, or null if not stored in the cache.
+    ResourceGroup* group_;
+    /// Previous resource in the least recently used order of the resource group.
+    Resource* lruPrev_;
+    /// Next resource in the least recently used order of the resource group.
+    Resource* lruNext_;
 };
 
 inline StringHash GetResourceHash(Resource* resource)
@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "BackgroundLoader.h"
 #include "Context.h"
 #include "CoreEvents.h"
 #include "FileSystem.h"
@@ -28,8 +29,10 @@
 #include "Image.h"
 #include "Log.h"
 #include "PackageFile.h"
+#include "Profiler.h"
 #include "ResourceCache.h"
 #include "ResourceEvents.h"
+#include "Sort.h"
 #include "XMLFile.h"
 
 #include "DebugNew.h"
@@ -56,18 +59,45 @@ static const char* checkDirs[] = {
     0
 };
 
+static const float DEFAULT_AUTORELOAD_DELAY = 0.5f;
+static const int DEFAULT_FINISH_BACKGROUND_RESOURCES_MS = 5;
+
 static const SharedPtr<Resource> noResource;
 
+static bool CompareMemoryUse(Resource* lhs, Resource* rhs)
+{
+    if (lhs->GetMemoryUse() != rhs->GetMemoryUse())
+        return lhs->GetMemoryUse() > rhs->GetMemoryUse();
+    else
+        return lhs->GetName() < rhs->GetName();
+}
+
 OBJECTTYPESTATIC(ResourceCache);
 
 ResourceCache::ResourceCache(Context* context) :
     Object(context),
+    backgroundLoader_(new BackgroundLoader(this)),
+    finishBackgroundResourcesMs_(DEFAULT_FINISH_BACKGROUND_RESOURCES_MS),
+    recordManifest_(false),
+    requestRecord_(0),
+    autoReloadDelay_(DEFAULT_AUTORELOAD_DELAY),
     autoReloadResources_(false)
 {
+    SubscribeToEvent(E_BEGINFRAME, HANDLER(ResourceCache, HandleBeginFrame));
 }
 
 ResourceCache::~ResourceCache()
 {
+    // Stop the background loader threads first, as they access the resource cache
+    backgroundLoader_.Reset();
+    
+    // Detach resources which may outlive the cache from their resource groups
+    for (HashMap<ShortStringHash, ResourceGroup>::Iterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
+    {
+        for (HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin(); j !=
+            i->second_.resources_.End(); ++j)
+            UnlinkResource(j->second_);
+    }
 }
 
 bool ResourceCache::AddResourceDir(const String& pathName)
@@ -81,29 +111,31 @@ bool ResourceCache::AddResourceDir(const String& pathName)
     
     String fixedPath = AddTrailingSlash(pathName);
     
-    // Check that the same path does not already exist
-    for (unsigned i = 0; i < resourceDirs_.Size(); ++i)
     {
-        if (!resourceDirs_[i].Compare(fixedPath, false))
-            return true;
+        MutexLock lock(resourceMutex_);
+        
+        // Check that the same path does not already exist
+        for (unsigned i = 0; i < resourceDirs_.Size(); ++i)
+        {
+            if (!resourceDirs_[i].Compare(fixedPath, false))
+                return true;
+        }
+        
+        resourceDirs_.Push(fixedPath);
     }
     
-    resourceDirs_.Push(fixedPath);
+    // If resource auto-reloading active, create a file watcher for the directory. Create it before indexing, so that the
+    // index is kept current from the start without reading the directory again
+    if (autoReloadResources_)
+        CreateFileWatcher(fixedPath);
     
-    // Scan the path for files recursively and add their hash-to-name mappings
+    // Index the directory so that file lookups and rescans do not need to access the disk, and add the hash-to-name
+    // mappings of the files found
     Vector<String> fileNames;
-    fileSystem->ScanDir(fileNames, fixedPath, "*.*", SCAN_FILES, true);
+    fileSystem->IndexDir(fixedPath, fileNames);
     for (unsigned i = 0; i < fileNames.Size(); ++i)
         StoreNameHash(fileNames[i]);
     
-    // If resource auto-reloading active, create a file watcher for the directory
-    if (autoReloadResources_)
-    {
-        SharedPtr<FileWatcher> watcher(new FileWatcher(context_));
-        watcher->StartWatching(fixedPath, true);
-        fileWatchers_.Push(watcher);
-    }
-    
     LOGINFO("Added resource path " + fixedPath);
     return true;
 }
@@ -114,6 +146,8 @@ void ResourceCache::AddPackageFile(PackageFile* package, bool addAsFirst)
     if (!package || !package->GetNumFiles())
         return;
     
+    MutexLock lock(resourceMutex_);
+    
     if (addAsFirst)
         packages_.Insert(packages_.Begin(), SharedPtr<PackageFile>(package));
     else
@@ -144,18 +178,23 @@ bool ResourceCache::AddManualResource(Resource* resource)
     
     StoreNameHash(name);
     resource->ResetUseTimer();
-    resourceGroups_[resource->GetType()].resources_[resource->GetNameHash()] = resource;
+    StoreResource(resource->GetType(), resource->GetNameHash(), resource);
     UpdateResourceGroup(resource->GetType());
     return true;
 }
 
 void ResourceCache::RemoveResourceDir(const String& path)
 {
+    MutexLock lock(resourceMutex_);
+    
     String fixedPath = AddTrailingSlash(path);
     for (unsigned i = 0; i < resourceDirs_.Size(); ++i)
     {
         if (!resourceDirs_[i].Compare(path, false))
         {
+            FileSystem* fileSystem = GetSubsystem<FileSystem>();
+            if (fileSystem)
+                fileSystem->RemoveIndexedDir(resourceDirs_[i]);
             resourceDirs_.Erase(i);
             if (fileWatchers_.Size() > i)
                 fileWatchers_.Erase(i);
@@ -167,6 +206,8 @@ void ResourceCache::RemoveResourceDir(const String& path)
 
 void ResourceCache::RemovePackageFile(PackageFile* package, bool releaseResources, bool forceRelease)
 {
+    MutexLock lock(resourceMutex_);
+    
     for (Vector<SharedPtr<PackageFile> >::Iterator i = packages_.Begin(); i != packages_.End(); ++i)
     {
         if (*i == package)
@@ -185,6 +226,8 @@ void ResourceCache::RemovePackageFile(const String& fileName, bool releaseResour
     // Compare the name and extension only, not the path
     String fileNameNoPath = GetFileNameAndExtension(fileName);
     
+    MutexLock lock(resourceMutex_);
+    
     for (Vector<SharedPtr<PackageFile> >::Iterator i = packages_.Begin(); i != packages_.End(); ++i)
     {
         if (!GetFileNameAndExtension((*i)->GetName()).Compare(fileNameNoPath, false))
@@ -212,6 +255,7 @@ void ResourceCache::ReleaseResource(ShortStringHash type, StringHash nameHash, b
     // If other references exist, do not release, unless forced
     if (existingRes.Refs() == 1 || force)
     {
+        UnlinkResource(existingRes);
         resourceGroups_[type].resources_.Erase(nameHash);
         UpdateResourceGroup(type);
     }
@@ -231,6 +275,7 @@ void ResourceCache::ReleaseResources(ShortStringHash type, bool force)
             // If other references exist, do not release, unless forced
             if (current->second_.Refs() == 1 || force)
             {
+                UnlinkResource(current->second_);
                 i->second_.resources_.Erase(current);
                 released = true;
             }
@@ -257,6 +302,7 @@ void ResourceCache::ReleaseResources(ShortStringHash type, const String& partial
                 // If other references exist, do not release, unless forced
                 if (current->second_.Refs() == 1 || force)
                 {
+                    UnlinkResource(current->second_);
                     i->second_.resources_.Erase(current);
                     released = true;
                 }
@@ -282,6 +328,7 @@ void ResourceCache::ReleaseAllResources(bool force)
             // If other references exist, do not release, unless forced
             if ((current->second_.Refs() == 1 && current->second_.WeakRefs() == 0) || force)
             {
+                UnlinkResource(current->second_);
                 i->second_.resources_.Erase(current);
                 released = true;
             }
@@ -317,6 +364,37 @@ bool ResourceCache::ReloadResource(Resource* resource)
     return false;
 }
 
+unsigned ResourceCache::ReloadChangedFiles(const Vector<String>& fileNames)
+{
+    // Reloading may modify the dependency tracking structure, so determine the order and hold the resources first
+    PODVector<StringHash> order;
+    GetReloadOrder(fileNames, order);
+    if (order.Empty())
+        return 0;
+    
+    PROFILE(ReloadChangedResources);
+    
+    Vector<SharedPtr<Resource> > resources;
+    resources.Reserve(order.Size());
+    for (unsigned i = 0; i < order.Size(); ++i)
+        resources.Push(FindResource(order[i]));
+    
+    HashSet<StringHash> changedFiles;
+    for (unsigned i = 0; i < fileNames.Size(); ++i)
+        changedFiles.Insert(StringHash(fileNames[i]));
+    
+    for (unsigned i = 0; i < resources.Size(); ++i)
+    {
+        if (changedFiles.Contains(order[i]))
+            LOGDEBUG("Reloading changed resource " + resources[i]->GetName());
+        else
+            LOGDEBUG("Reloading resource " + resources[i]->GetName() + " depending on changed files");
+        ReloadResource(resources[i]);
+    }
+    
+    return resources.Size();
+}
+
 void ResourceCache::SetMemoryBudget(ShortStringHash type, unsigned budget)
 {
     resourceGroups_[type].memoryBudget_ = budget;
@@ -329,28 +407,186 @@ void ResourceCache::SetAutoReloadResources(bool enable)
         if (enable)
         {
             for (unsigned i = 0; i < resourceDirs_.Size(); ++i)
-            {
-                SharedPtr<FileWatcher> watcher(new FileWatcher(context_));
-                watcher->StartWatching(resourceDirs_[i], true);
-                fileWatchers_.Push(watcher);
-            }
-
-            SubscribeToEvent(E_BEGINFRAME, HANDLER(ResourceCache, HandleBeginFrame));
+                CreateFileWatcher(resourceDirs_[i]);
         }
         else
         {
-            UnsubscribeFromEvent(E_BEGINFRAME);
             fileWatchers_.Clear();
+            dependentResources_.Clear();
+            resourceDependencies_.Clear();
         }
         
         autoReloadResources_ = enable;
     }
 }
 
+void ResourceCache::SetAutoReloadDelay(float delay)
+{
+    autoReloadDelay_ = Max(delay, 0.0f);
+    for (unsigned i = 0; i < fileWatchers_.Size(); ++i)
+        fileWatchers_[i]->SetDelay(autoReloadDelay_);
+}
+
+void ResourceCache::CreateBackgroundLoadThreads(unsigned numThreads)
+{
+    backgroundLoader_->CreateThreads(numThreads);
+}
+
+void ResourceCache::SetFinishBackgroundResourcesMs(int ms)
+{
+    finishBackgroundResourcesMs_ = Max(ms, 1);
+}
+
+void ResourceCache::SetRecordManifest(bool enable)
+{
+    recordManifest_ = enable;
+}
+
+void ResourceCache::ClearManifest()
+{
+    manifest_.Clear();
+    manifestResources_.Clear();
+}
+
+void ResourceCache::SetRequestRecord(Vector<Pair<ShortStringHash, StringHash> >* record)
+{
+    requestRecord_ = record;
+}
+
+bool ResourceCache::SaveManifest(Serializer& dest) const
+{
+    SharedPtr<XMLFile> xml(new XMLFile(context_));
+    XMLElement rootElem = xml->CreateRoot("manifest");
+    
+    for (unsigned i = 0; i < manifest_.Size(); ++i)
+    {
+        XMLElement resourceElem = rootElem.CreateChild("resource");
+        resourceElem.SetString("type", context_->GetTypeName(manifest_[i].first_));
+        resourceElem.SetString("name", GetResourceName(manifest_[i].second_));
+    }
+    
+    return xml->Save(dest);
+}
+
+bool ResourceCache::SaveMemoryReport(Serializer& dest, bool csv) const
+{
+    if (csv)
+    {
+        if (!dest.WriteLine("type,name,cpuMemory,gpuMemory,refs,weakRefs,lastUseFrame,idleMs"))
+            return false;
+    }
+    else
+    {
+        if (!dest.WriteLine("Resource memory report"))
+            return false;
+    }
+    
+    unsigned totalCount = 0;
+    unsigned totalUnused = 0;
+    
+    for (HashMap<ShortStringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
+    {
+        const ResourceGroup& group = i->second_;
+        if (group.resources_.Empty())
+            continue;
+        
+        PODVector<Resource*> resources;
+        for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = group.resources_.Begin(); j !=
+            group.resources_.End(); ++j)
+            resources.Push(j->second_);
+        Sort(resources.Begin(), resources.End(), CompareMemoryUse);
+        
+        const String& typeName = resources[0]->GetTypeName();
+        unsigned numUnused = GetNumUnusedResources(i->first_);
+        totalCount += resources.Size();
+        totalUnused += numUnused;
+        
+        if (!csv)
+        {
+            dest.WriteLine("");
+            dest.WriteLine(typeName + ": count " + String(resources.Size()) + " cpu " + String(group.memoryUse_ -
+                group.gpuMemoryUse_) + " gpu " + String(group.gpuMemoryUse_) + " budget " + String(group.memoryBudget_) +
+                " unused " + String(numUnused));
+        }
+        
+        for (unsigned j = 0; j < resources.Size(); ++j)
+        {
+            Resource* resource = resources[j];
+            // The resource cache holds one reference itself; report only the references held elsewhere
+            unsigned refs = resource->Refs() - 1;
+            unsigned idleMs = refs ? 0 : resource->GetUseTimer();
+            
+            if (csv)
+            {
+                String name = resource->GetName();
+                if (name.Contains(',') || name.Contains('"'))
+                    name = "\"" + name.Replaced("\"", "\"\"") + "\"";
+                dest.WriteLine(typeName + "," + name + "," + String(resource->GetCPUMemoryUse()) + "," +
+                    String(resource->GetGPUMemoryUse()) + "," + String(refs) + "," + String(resource->WeakRefs()) + "," +
+                    String(resource->GetLastUseFrame()) + "," + String(idleMs));
+            }
+            else
+            {
+                dest.WriteLine("  " + resource->GetName() + ": cpu " + String(resource->GetCPUMemoryUse()) + " gpu " +
+                    String(resource->GetGPUMemoryUse()) + " refs " + String(refs) + " weakrefs " +
+                    String(resource->WeakRefs()) + " last frame " + String(resource->GetLastUseFrame()) + (refs ? String() :
+                    " idle " + String(idleMs) + " ms"));
+            }
+        }
+    }
+    
+    if (!csv)
+    {
+        unsigned totalMemoryUse = GetTotalMemoryUse();
+        unsigned totalGPUMemoryUse = GetTotalGPUMemoryUse();
+        dest.WriteLine("");
+        return dest.WriteLine("Total: count " + String(totalCount) + " cpu " + String(totalMemoryUse - totalGPUMemoryUse) +
+            " gpu " + String(totalGPUMemoryUse) + " unused " + String(totalUnused));
+    }
+    
+    return true;
+}
+
+unsigned ResourceCache::PreloadManifest(XMLFile* manifest, HashSet<StringHash>* queuedNames)
+{
+    if (!manifest)
+    {
+        LOGERROR("Null preload manifest");
+        return 0;
+    }
+    
+    XMLElement rootElem = manifest->GetRoot("manifest");
+    if (!rootElem)
+    {
+        LOGERROR(manifest->GetName() + " is not a valid preload manifest");
+        return 0;
+    }
+    
+    unsigned numQueued = 0;
+    XMLElement resourceElem = rootElem.GetChild("resource");
+    while (resourceElem)
+    {
+        String name = SanitateResourceName(resourceElem.GetAttribute("name"));
+        if (BackgroundLoadResource(ShortStringHash(resourceElem.GetAttribute("type")), name, true))
+        {
+            ++numQueued;
+            if (queuedNames)
+                queuedNames->Insert(StringHash(name));
+        }
+        
+        resourceElem = resourceElem.GetNext("resource");
+    }
+    
+    LOGDEBUG("Queued " + String(numQueued) + " resources from preload manifest " + manifest->GetName());
+    return numQueued;
+}
+
 SharedPtr<File> ResourceCache::GetFile(const String& nameIn)
 {
     String name = SanitateResourceName(nameIn);
     
+    MutexLock lock(resourceMutex_);
+    
     // Check first the packages
     for (unsigned i = 0; i < packages_.Size(); ++i)
     {
@@ -404,9 +640,35 @@ Resource* ResourceCache::GetResource(ShortStringHash type, StringHash nameHash)
     if (!nameHash)
         return 0;
     
+    // Record the request into the preload manifest on first request
+    if (recordManifest_)
+    {
+        Pair<ShortStringHash, StringHash> key = MakePair(type, nameHash);
+        if (!manifestResources_.Contains(key))
+        {
+            manifestResources_.Insert(key);
+            manifest_.Push(key);
+        }
+    }
+    
     const SharedPtr<Resource>& existing = FindResource(type, nameHash);
     if (existing)
+    {
+        existing->ResetUseTimer();
+        TouchResource(existing);
+        if (requestRecord_)
+            requestRecord_->Push(MakePair(type, nameHash));
         return existing;
+    }
+    
+    // If the resource is being loaded in the background, finish it now instead of loading it again
+    if (backgroundLoader_->WaitForResource(type, nameHash))
+    {
+        Resource* resource = FindResource(type, nameHash);
+        if (resource && requestRecord_)
+            requestRecord_->Push(MakePair(type, nameHash));
+        return resource;
+    }
     
     SharedPtr<Resource> resource;
     const String& name = GetResourceName(nameHash);
@@ -436,12 +698,21 @@ Resource* ResourceCache::GetResource(ShortStringHash type, StringHash nameHash)
     
     // Store to cache
     resource->ResetUseTimer();
-    resourceGroups_[type].resources_[nameHash] = resource;
+    StoreResource(type, nameHash, resource);
     UpdateResourceGroup(type);
     
+    // Record after loading, so that the resources requested by this one precede it
+    if (requestRecord_)
+        requestRecord_->Push(MakePair(type, nameHash));
+    
     return resource;
 }
 
+bool ResourceCache::BackgroundLoadResource(ShortStringHash type, const String& name, bool sendEventOnFailure, Resource* caller)
+{
+    return backgroundLoader_->QueueResource(type, name, sendEventOnFailure, caller);
+}
+
 void ResourceCache::GetResources(PODVector<Resource*>& result, ShortStringHash type) const
 {
     result.Clear();
@@ -458,6 +729,8 @@ bool ResourceCache::Exists(const String& nameIn) const
 {
     String name = SanitateResourceName(nameIn);
     
+    MutexLock lock(resourceMutex_);
+    
     for (unsigned i = 0; i < packages_.Size(); ++i)
     {
         if (packages_[i]->Exists(name))
@@ -512,6 +785,49 @@ unsigned ResourceCache::GetTotalMemoryUse() const
     return total;
 }
 
+unsigned ResourceCache::GetGPUMemoryUse(ShortStringHash type) const
+{
+    HashMap<ShortStringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Find(type);
+    if (i != resourceGroups_.End())
+        return i->second_.gpuMemoryUse_;
+    else
+        return 0;
+}
+
+unsigned ResourceCache::GetTotalGPUMemoryUse() const
+{
+    unsigned total = 0;
+    for (HashMap<ShortStringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
+        total += i->second_.gpuMemoryUse_;
+    return total;
+}
+
+unsigned ResourceCache::GetNumUnusedResources(ShortStringHash type) const
+{
+    unsigned num = 0;
+    HashMap<ShortStringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Find(type);
+    if (i != resourceGroups_.End())
+    {
+        for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = i->second_.resources_.Begin(); j !=
+            i->second_.resources_.End(); ++j)
+        {
+            if (j->second_.Refs() == 1)
+                ++num;
+        }
+    }
+    return num;
+}
+
+unsigned ResourceCache::GetNumBackgroundLoadThreads() const
+{
+    return backgroundLoader_->GetNumThreads();
+}
+
+unsigned ResourceCache::GetNumBackgroundLoadResources() const
+{
+    return backgroundLoader_->GetNumQueuedResources();
+}
+
 const String& ResourceCache::GetResourceName(StringHash nameHash) const
 {
     HashMap<StringHash, String>::ConstIterator i = hashToName_.Find(nameHash);
@@ -521,6 +837,40 @@ const String& ResourceCache::GetResourceName(StringHash nameHash) const
         return i->second_;
 }
 
+void ResourceCache::GetDependencies(const String& name, Vector<String>& result) const
+{
+    result.Clear();
+    
+    HashMap<StringHash, HashSet<StringHash> >::ConstIterator i = resourceDependencies_.Find(StringHash(name));
+    if (i != resourceDependencies_.End())
+    {
+        for (HashSet<StringHash>::ConstIterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+            result.Push(GetResourceName(*j));
+    }
+}
+
+void ResourceCache::GetDependents(const String& name, Vector<String>& result) const
+{
+    result.Clear();
+    
+    HashMap<StringHash, HashSet<StringHash> >::ConstIterator i = dependentResources_.Find(StringHash(name));
+    if (i != dependentResources_.End())
+    {
+        for (HashSet<StringHash>::ConstIterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+            result.Push(GetResourceName(*j));
+    }
+}
+
+void ResourceCache::GetReloadOrder(const Vector<String>& fileNames, Vector<String>& result) const
+{
+    PODVector<StringHash> order;
+    GetReloadOrder(fileNames, order);
+    
+    result.Clear();
+    for (unsigned i = 0; i < order.Size(); ++i)
+        result.Push(FindResource(order[i])->GetName());
+}
+
 String ResourceCache::GetResourceFileName(const String& name) const
 {
     FileSystem* fileSystem = GetSubsystem<FileSystem>();
@@ -610,8 +960,43 @@ void ResourceCache::StoreResourceDependency(Resource* resource, const String& de
         return;
     
     StringHash nameHash(resource->GetName());
-    HashSet<StringHash>& dependents = dependentResources_[dependency];
-    dependents.Insert(nameHash);
+    StringHash dependencyHash(dependency);
+    HashMap<StringHash, HashSet<StringHash> >::ConstIterator existing = dependentResources_.Find(dependencyHash);
+    if (existing != dependentResources_.End() && existing->second_.Contains(nameHash))
+        return;
+    
+    // Refuse a dependency which would create a cycle, that is, if the dependency file already depends on the resource
+    // directly or indirectly. Otherwise there would be no valid reload order
+    PODVector<StringHash> stack;
+    HashSet<StringHash> visited;
+    stack.Push(nameHash);
+    while (!stack.Empty())
+    {
+        StringHash current = stack.Back();
+        stack.Pop();
+        if (current == dependencyHash)
+        {
+            LOGWARNING("Not storing cyclic dependency of " + resource->GetName() + " on " + dependency);
+            return;
+        }
+        
+        HashMap<StringHash, HashSet<StringHash> >::ConstIterator i = dependentResources_.Find(current);
+        if (i != dependentResources_.End())
+        {
+            for (HashSet<StringHash>::ConstIterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+            {
+                if (!visited.Contains(*j))
+                {
+                    visited.Insert(*j);
+                    stack.Push(*j);
+                }
+            }
+        }
+    }
+    
+    StoreNameHash(dependency);
+    dependentResources_[dependencyHash].Insert(nameHash);
+    resourceDependencies_[nameHash].Insert(dependencyHash);
 }
 
 void ResourceCache::ResetDependencies(Resource* resource)
@@ -620,17 +1005,23 @@ void ResourceCache::ResetDependencies(Resource* resource)
         return;
     
     StringHash nameHash(resource->GetName());
+    HashMap<StringHash, HashSet<StringHash> >::Iterator i = resourceDependencies_.Find(nameHash);
+    if (i == resourceDependencies_.End())
+        return;
     
-    for (HashMap<StringHash, HashSet<StringHash> >::Iterator i = dependentResources_.Begin(); i !=
-        dependentResources_.End();)
+    // Remove the resource from the dependents of its dependency files only, instead of going through all files
+    for (HashSet<StringHash>::ConstIterator j = i->second_.Begin(); j != i->second_.End(); ++j)
     {
-        HashSet<StringHash>& dependents = i->second_;
-        dependents.Erase(nameHash);
-        if (dependents.Empty())
-            i = dependentResources_.Erase(i);
-        else
-            ++i;
+        HashMap<StringHash, HashSet<StringHash> >::Iterator k = dependentResources_.Find(*j);
+        if (k != dependentResources_.End())
+        {
+            k->second_.Erase(nameHash);
+            if (k->second_.Empty())
+                dependentResources_.Erase(k);
+        }
     }
+    
+    resourceDependencies_.Erase(i);
 }
 
 const SharedPtr<Resource>& ResourceCache::FindResource(ShortStringHash type, StringHash nameHash)
@@ -645,11 +1036,11 @@ const SharedPtr<Resource>& ResourceCache::FindResource(ShortStringHash type, Str
     return j->second_;
 }
 
-const SharedPtr<Resource>& ResourceCache::FindResource(StringHash nameHash)
+const SharedPtr<Resource>& ResourceCache::FindResource(StringHash nameHash) const
 {
-    for (HashMap<ShortStringHash, ResourceGroup>::Iterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
+    for (HashMap<ShortStringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
     {
-        HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Find(nameHash);
+        HashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = i->second_.resources_.Find(nameHash);
         if (j != i->second_.resources_.End())
             return j->second_;
     }
@@ -657,6 +1048,87 @@ const SharedPtr<Resource>& ResourceCache::FindResource(StringHash nameHash)
     return noResource;
 }
 
+void ResourceCache::GetReloadOrder(const Vector<String>& fileNames, PODVector<StringHash>& result) const
+{
+    result.Clear();
+    
+    // Collect the changed files and everything depending on them directly or indirectly
+    HashSet<StringHash> affected;
+    PODVector<StringHash> stack;
+    for (unsigned i = 0; i < fileNames.Size(); ++i)
+    {
+        StringHash nameHash(fileNames[i]);
+        if (!affected.Contains(nameHash))
+        {
+            affected.Insert(nameHash);
+            stack.Push(nameHash);
+        }
+    }
+    
+    while (!stack.Empty())
+    {
+        StringHash current = stack.Back();
+        stack.Pop();
+        
+        HashMap<StringHash, HashSet<StringHash> >::ConstIterator i = dependentResources_.Find(current);
+        if (i != dependentResources_.End())
+        {
+            for (HashSet<StringHash>::ConstIterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+            {
+                if (!affected.Contains(*j))
+                {
+                    affected.Insert(*j);
+                    stack.Push(*j);
+                }
+            }
+        }
+    }
+    
+    // Sort topologically: a file or resource is ready once all its affected dependencies have been ordered
+    HashMap<StringHash, unsigned> waitCounts;
+    PODVector<StringHash> ready;
+    for (HashSet<StringHash>::ConstIterator i = affected.Begin(); i != affected.End(); ++i)
+    {
+        unsigned waitCount = 0;
+        HashMap<StringHash, HashSet<StringHash> >::ConstIterator j = resourceDependencies_.Find(*i);
+        if (j != resourceDependencies_.End())
+        {
+            for (HashSet<StringHash>::ConstIterator k = j->second_.Begin(); k != j->second_.End(); ++k)
+            {
+                if (affected.Contains(*k))
+                    ++waitCount;
+            }
+        }
+        
+        if (waitCount)
+            waitCounts[*i] = waitCount;
+        else
+            ready.Push(*i);
+    }
+    
+    for (unsigned i = 0; i < ready.Size(); ++i)
+    {
+        // Only loaded resources are reloaded, but plain files still pass the order on to their dependents
+        if (FindResource(ready[i]))
+            result.Push(ready[i]);
+        
+        HashMap<StringHash, HashSet<StringHash> >::ConstIterator j = dependentResources_.Find(ready[i]);
+        if (j != dependentResources_.End())
+        {
+            for (HashSet<StringHash>::ConstIterator k = j->second_.Begin(); k != j->second_.End(); ++k)
+            {
+                HashMap<StringHash, unsigned>::Iterator l = waitCounts.Find(*k);
+                if (l != waitCounts.End() && !--l->second_)
+                    ready.Push(*k);
+            }
+        }
+    }
+    
+    // Cyclic dependencies are refused when stored, so everything should have been ordered by now
+    if (ready.Size() < affected.Size())
+        LOGERROR("Cyclic resource dependencies, could not order all resources for reloading");
+}
+
 void ResourceCache::ReleasePackageResources(PackageFile* package, bool force)
 {
     HashSet<ShortStringHash> affectedGroups;
@@ -676,6 +1148,7 @@ void ResourceCache::ReleasePackageResources(PackageFile* package, bool force)
                 // If other references exist, do not release, unless forced
                 if (k->second_.Refs() == 1 || force)
                 {
+                    UnlinkResource(k->second_);
                     j->second_.resources_.Erase(k);
                     affectedGroups.Insert(j->first_);
                 }
@@ -694,80 +1167,123 @@ void ResourceCache::UpdateResourceGroup(ShortStringHash type)
     if (i == resourceGroups_.End())
         return;
     
-    for (;;)
+    ResourceGroup& group = i->second_;
+    
+    // If memory budget defined and is exceeded, remove resources starting from the least recently used. Resources in use
+    // always return a zero timer and can not be removed, so move them to the most recently used end. Check each resource
+    // at most once
+    Resource* resource = group.lruFirst_;
+    unsigned numChecks = group.resources_.Size();
+    while (group.memoryBudget_ && group.memoryUse_ > group.memoryBudget_ && resource && numChecks--)
     {
-        unsigned totalSize = 0;
-        unsigned oldestTimer = 0;
-        HashMap<StringHash, SharedPtr<Resource> >::Iterator oldestResource = i->second_.resources_.End();
+        Resource* next = resource->lruNext_;
         
-        for (HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
-            j != i->second_.resources_.End(); ++j)
+        if (!resource->GetUseTimer())
+            TouchResource(resource);
+        else
         {
-            totalSize += j->second_->GetMemoryUse();
-            unsigned useTimer = j->second_->GetUseTimer();
-            if (useTimer > oldestTimer)
-            {
-                oldestTimer = useTimer;
-                oldestResource = j;
-            }
+            LOGDEBUG("Resource group " + resource->GetTypeName() + " over memory budget, releasing resource " +
+                resource->GetName());
+            UnlinkResource(resource);
+            group.resources_.Erase(resource->GetNameHash());
         }
         
-        i->second_.memoryUse_ = totalSize;
-        
-        // If memory budget defined and is exceeded, remove the oldest resource and loop again
-        // (resources in use always return a zero timer and can not be removed)
-        if (i->second_.memoryBudget_ && i->second_.memoryUse_ > i->second_.memoryBudget_ &&
-            oldestResource != i->second_.resources_.End())
-        {
-            LOGDEBUG("Resource group " + oldestResource->second_->GetTypeName() + " over memory budget, releasing resource " +
-                oldestResource->second_->GetName());
-            i->second_.resources_.Erase(oldestResource);
-        }
-        else
-            break;
+        resource = next;
     }
 }
 
+void ResourceCache::StoreResource(ShortStringHash type, StringHash nameHash, Resource* resource)
+{
+    ResourceGroup& group = resourceGroups_[type];
+    SharedPtr<Resource>& entry = group.resources_[nameHash];
+    if (entry == resource)
+        return;
+    
+    if (entry)
+        UnlinkResource(entry);
+    entry = resource;
+    
+    // Add as the most recently used
+    resource->group_ = &group;
+    resource->lruPrev_ = group.lruLast_;
+    resource->lruNext_ = 0;
+    if (group.lruLast_)
+        group.lruLast_->lruNext_ = resource;
+    else
+        group.lruFirst_ = resource;
+    group.lruLast_ = resource;
+    group.memoryUse_ += resource->GetMemoryUse();
+    group.gpuMemoryUse_ += resource->GetGPUMemoryUse();
+}
+
+void ResourceCache::UnlinkResource(Resource* resource)
+{
+    ResourceGroup* group = resource->group_;
+    if (!group)
+        return;
+    
+    if (resource->lruPrev_)
+        resource->lruPrev_->lruNext_ = resource->lruNext_;
+    else
+        group->lruFirst_ = resource->lruNext_;
+    if (resource->lruNext_)
+        resource->lruNext_->lruPrev_ = resource->lruPrev_;
+    else
+        group->lruLast_ = resource->lruPrev_;
+    
+    group->memoryUse_ -= resource->GetMemoryUse();
+    group->gpuMemoryUse_ -= resource->GetGPUMemoryUse();
+    resource->group_ = 0;
+    resource->lruPrev_ = 0;
+    resource->lruNext_ = 0;
+}
+
+void ResourceCache::TouchResource(Resource* resource)
+{
+    ResourceGroup* group = resource->group_;
+    if (!group || group->lruLast_ == resource)
+        return;
+    
+    // Unlink from the current position. The resource is not the last, so it has a next resource
+    if (resource->lruPrev_)
+        resource->lruPrev_->lruNext_ = resource->lruNext_;
+    else
+        group->lruFirst_ = resource->lruNext_;
+    resource->lruNext_->lruPrev_ = resource->lruPrev_;
+    
+    resource->lruPrev_ = group->lruLast_;
+    resource->lruNext_ = 0;
+    group->lruLast_->lruNext_ = resource;
+    group->lruLast_ = resource;
+}
+
+void ResourceCache::CreateFileWatcher(const String& pathName)
+{
+    SharedPtr<FileWatcher> watcher(new FileWatcher(context_));
+    watcher->SetDelay(autoReloadDelay_);
+    watcher->StartWatching(pathName, true);
+    fileWatchers_.Push(watcher);
+}
+
 void ResourceCache::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
+    // Collect the changed files of all watchers into one batch, so that each affected resource is reloaded only once
+    Vector<String> changes;
+    Vector<String> changedFiles;
     for (unsigned i = 0; i < fileWatchers_.Size(); ++i)
     {
-        String fileName;
-        while (fileWatchers_[i]->GetNextChange(fileName))
-        {
-            StringHash fileNameHash(fileName);
-            // If the filename is a resource we keep track of, reload it
-            const SharedPtr<Resource>& resource = FindResource(fileNameHash);
-            if (resource)
-            {
-                LOGDEBUG("Reloading changed resource " + fileName);
-                ReloadResource(resource);
-            }
-            else
-            {
-                // Check if this is a dependency resource, reload dependents
-                HashMap<StringHash, HashSet<StringHash> >::ConstIterator j = dependentResources_.Find(fileNameHash);
-                if (j != dependentResources_.End())
-                {
-                    // Reloading a resource may modify the dependency tracking structure. Therefore collect the
-                    // resources we need to reload first
-                    Vector<SharedPtr<Resource> > dependents;
-                    
-                    for (HashSet<StringHash>::ConstIterator k = j->second_.Begin(); k != j->second_.End(); ++k)
-                    {
-                        const SharedPtr<Resource>& dependent = FindResource(*k);
-                        if (dependent)
-                            dependents.Push(dependent);
-                    }
-                    
-                    for (unsigned k = 0; k < dependents.Size(); ++k)
-                    {
-                        LOGDEBUG("Reloading resource " + dependents[k]->GetName() + " depending on " + fileName);
-                        ReloadResource(dependents[k]);
-                    }
-                }
-            }
-        }
+        if (fileWatchers_[i]->GetChanges(changes))
+            changedFiles.Push(changes);
+    }
+    
+    if (!changedFiles.Empty())
+        ReloadChangedFiles(changedFiles);
+    
+    // Finish background loaded resources within the time budget
+    if (backgroundLoader_->GetNumQueuedResources())
+    {
+        PROFILE(FinishBackgroundResources);
+        backgroundLoader_->FinishResources(finishBackgroundResourcesMs_);
     }
 }
 
@@ -23,13 +23,16 @@
 #pragma once
 
 #include "File.h"
+#include "Mutex.h"
 #include "Resource.h"
 
 namespace Urho3D
 {
 
+class BackgroundLoader;
 class FileWatcher;
 class PackageFile;
+class XMLFile;
 
 /// Container of resources with specific type.
 struct ResourceGroup
@@ -37,7 +40,10 @@ struct ResourceGroup
     /// Construct with defaults.
     ResourceGroup() :
         memoryBudget_(0),
-        memoryUse_(0)
+        memoryUse_(0),
+        gpuMemoryUse_(0),
+        lruFirst_(0),
+        lruLast_(0)
     {
     }
     
@@ -45,8 +51,14 @@ struct ResourceGroup
     unsigned memoryBudget_;
     /// Current memory use.
     unsigned memoryUse_;
+    /// Part of the current memory use which resides in GPU memory.
+    unsigned gpuMemoryUse_;
     /// Resources.
     HashMap<StringHash, SharedPtr<Resource> > resources_;
+    /// Least recently used resource.
+    Resource* lruFirst_;
+    /// Most recently used resource.
+    Resource* lruLast_;
 };
 
 /// %Resource cache subsystem. Loads resources on demand and stores them for later access.
@@ -54,6 +66,8 @@ class ResourceCache : public Object
 {
     OBJECT(ResourceCache);
     
+    friend class BackgroundLoader;
+    
 public:
     /// Construct.
     ResourceCache(Context* context);
@@ -84,10 +98,30 @@ public:
     void ReleaseAllResources(bool force = false);
     /// Reload a resource. Return false and release it if fails.
     bool ReloadResource(Resource* resource);
+    /// Reload the resources affected by changed files, including resources depending on them directly or indirectly. Each resource is reloaded once, after the resources it depends on. Return number of resources reloaded.
+    unsigned ReloadChangedFiles(const Vector<String>& fileNames);
     /// Set memory budget for a specific resource type, default 0 is unlimited.
     void SetMemoryBudget(ShortStringHash type, unsigned budget);
-    /// Enable or disable automatic reloading of resources as files are modified.
+    /// Enable or disable automatic reloading of resources as files are modified. Resource dependencies are recorded only while enabled, and disabling clears them, so resources loaded earlier track only their own files after enabling again, until reloaded.
     void SetAutoReloadResources(bool enable);
+    /// Set the delay in seconds for collecting file changes before reloading. Changes arriving within the delay are reloaded as one batch.
+    void SetAutoReloadDelay(float delay);
+    /// Create background loader threads. Can only be called once. Without threads, background loaded resources are read in the main thread at frame begin.
+    void CreateBackgroundLoadThreads(unsigned numThreads);
+    /// Set maximum milliseconds to spend each frame on finishing background loaded resources.
+    void SetFinishBackgroundResourcesMs(int ms);
+    /// Enable or disable recording of resource requests into the preload manifest.
+    void SetRecordManifest(bool enable);
+    /// Clear the recorded preload manifest.
+    void ClearManifest();
+    /// Set a list to append the type and name hash of each successfully returned resource to, or null to stop. A resource is appended after the resources it requested while loading.
+    void SetRequestRecord(Vector<Pair<ShortStringHash, StringHash> >* record);
+    /// Save the recorded preload manifest as XML. Return true if successful.
+    bool SaveManifest(Serializer& dest) const;
+    /// Write a memory report listing every loaded resource with its CPU and GPU memory use, reference counts and last use, as text or comma-separated values. Return true if successful.
+    bool SaveMemoryReport(Serializer& dest, bool csv = false) const;
+    /// Queue the resources listed in a preload manifest for background loading. Optionally return the names of the queued resources. Return number of resources queued.
+    unsigned PreloadManifest(XMLFile* manifest, HashSet<StringHash>* queuedNames = 0);
     
     /// Open and return a file from the resource load paths or from inside a package file. If not found, use a fallback search with absolute path. Return null if fails.
     SharedPtr<File> GetFile(const String& name);
@@ -97,6 +131,8 @@ public:
     Resource* GetResource(ShortStringHash type, const char* name);
     /// Return a resource by type and name hash. Load if not loaded yet. Return null if fails.
     Resource* GetResource(ShortStringHash type, StringHash nameHash);
+    /// Queue a resource for background loading, optionally as a dependency of another resource being background loaded, which will then be finished only after this resource. Can be called from any thread. Return true if queued, or false if already loaded or the type is unknown. E_RESOURCEBACKGROUNDLOADED is sent when finished.
+    bool BackgroundLoadResource(ShortStringHash type, const String& name, bool sendEventOnFailure = true, Resource* caller = 0);
     /// Return all loaded resources of a specific type.
     void GetResources(PODVector<Resource*>& result, ShortStringHash type) const;
     /// Return all loaded resources.
@@ -111,6 +147,8 @@ public:
     template <class T> T* GetResource(const char* name);
     /// Template version of returning a resource by name hash.
     template <class T> T* GetResource(StringHash nameHash);
+    /// Template version of queueing a resource for background loading.
+    template <class T> bool BackgroundLoadResource(const String& name, bool sendEventOnFailure = true, Resource* caller = 0);
     /// Template version of returning loaded resources of a specific type.
     template <class T> void GetResources(PODVector<T*>& result) const;
     /// Return whether a file exists by name.
@@ -123,12 +161,38 @@ public:
     unsigned GetMemoryUse(ShortStringHash type) const;
     /// Return total memory use for all resources.
     unsigned GetTotalMemoryUse() const;
+    /// Return the part of the total memory use for a resource type which resides in GPU memory.
+    unsigned GetGPUMemoryUse(ShortStringHash type) const;
+    /// Return the part of the total memory use for all resources which resides in GPU memory.
+    unsigned GetTotalGPUMemoryUse() const;
+    /// Return number of resources of a type that are only referred to by the resource cache.
+    unsigned GetNumUnusedResources(ShortStringHash type) const;
     /// Return resource name from hash, or empty if not found.
     const String& GetResourceName(StringHash nameHash) const;
     /// Return full absolute file name of resource if possible.
     String GetResourceFileName(const String& name) const;
+    /// Return the files a resource depends on directly. Dependencies are recorded only while automatic reloading is enabled.
+    void GetDependencies(const String& name, Vector<String>& result) const;
+    /// Return the resources depending directly on a file. Dependencies are recorded only while automatic reloading is enabled.
+    void GetDependents(const String& name, Vector<String>& result) const;
+    /// Return the loaded resources affected by changed files, in the order ReloadChangedFiles() would reload them.
+    void GetReloadOrder(const Vector<String>& fileNames, Vector<String>& result) const;
     /// Return whether automatic resource reloading is enabled.
     bool GetAutoReloadResources() const { return autoReloadResources_; }
+    /// Return the delay in seconds for collecting file changes before reloading.
+    float GetAutoReloadDelay() const { return autoReloadDelay_; }
+    /// Return number of background loader threads.
+    unsigned GetNumBackgroundLoadThreads() const;
+    /// Return maximum milliseconds to spend each frame on finishing background loaded resources.
+    int GetFinishBackgroundResourcesMs() const { return finishBackgroundResourcesMs_; }
+    /// Return number of resources queued for background loading.
+    unsigned GetNumBackgroundLoadResources() const;
+    /// Return whether resource requests are recorded into the preload manifest.
+    bool GetRecordManifest() const { return recordManifest_; }
+    /// Return number of resources in the recorded preload manifest.
+    unsigned GetNumManifestResources() const { return manifest_.Size(); }
+    /// Return the list resource requests are appended to, or null if not recording.
+    Vector<Pair<ShortStringHash, StringHash> >* GetRequestRecord() const { return requestRecord_; }
     
     /// Return either the path itself or its parent, based on which of them has recognized resource subdirectories.
     String GetPreferredResourceDir(const String& path) const;
@@ -136,7 +200,7 @@ public:
     String SanitateResourceName(const String& name) const;
     /// Store a hash-to-name mapping.
     void StoreNameHash(const String& name);
-    /// Store a dependency for a resource. If a dependency file changes, the resource will be reloaded.
+    /// Store a dependency for a resource. If a dependency file changes, the resource will be reloaded. A dependency which would create a cycle is not stored.
     void StoreResourceDependency(Resource* resource, const String& dependency);
     /// Reset dependencies for a resource.
     void ResetDependencies(Resource* resource);
@@ -145,12 +209,22 @@ private:
     /// Find a resource.
     const SharedPtr<Resource>& FindResource(ShortStringHash type, StringHash nameHash);
     /// Find a resource by name only. Searches all type groups.
-    const SharedPtr<Resource>& FindResource(StringHash nameHash);
+    const SharedPtr<Resource>& FindResource(StringHash nameHash) const;
+    /// Return name hashes of the loaded resources affected by changed files in dependency order.
+    void GetReloadOrder(const Vector<String>& fileNames, PODVector<StringHash>& result) const;
     /// Release resources loaded from a package file.
     void ReleasePackageResources(PackageFile* package, bool force = false);
-    /// Update a resource group. Recalculate memory use and release resources if over memory budget.
+    /// Update a resource group. Release least recently used resources if over memory budget.
     void UpdateResourceGroup(ShortStringHash type);
-    /// Handle begin frame event. Automatic resource reloads are processed here.
+    /// Store a resource to its resource group, replacing any existing resource with the same name.
+    void StoreResource(ShortStringHash type, StringHash nameHash, Resource* resource);
+    /// Remove a resource from the memory use tracking and the least recently used order of its resource group. Must be called before erasing the resource from the group.
+    void UnlinkResource(Resource* resource);
+    /// Move a resource to the most recently used end of its resource group.
+    void TouchResource(Resource* resource);
+    /// Create a file watcher for a resource directory.
+    void CreateFileWatcher(const String& pathName);
+    /// Handle begin frame event. Automatic resource reloads and finishing of background loaded resources are processed here.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
     
     /// Resources by type.
@@ -163,8 +237,26 @@ private:
     Vector<SharedPtr<PackageFile> > packages_;
     /// Mapping of hashes to filenames.
     HashMap<StringHash, String> hashToName_;
-    /// Dependent resources.
+    /// Dependent resources by dependency file.
     HashMap<StringHash, HashSet<StringHash> > dependentResources_;
+    /// Dependency files by resource.
+    HashMap<StringHash, HashSet<StringHash> > resourceDependencies_;
+    /// Background loader.
+    SharedPtr<BackgroundLoader> backgroundLoader_;
+    /// Mutex for the resource directories and package files, which are accessed also from the background loader threads.
+    mutable Mutex resourceMutex_;
+    /// Maximum milliseconds to spend each frame on finishing background loaded resources.
+    int finishBackgroundResourcesMs_;
+    /// Recorded preload manifest as resource types and name hashes, in the order of first request.
+    Vector<Pair<ShortStringHash, StringHash> > manifest_;
+    /// Resources already in the recorded preload manifest.
+    HashSet<Pair<ShortStringHash, StringHash> > manifestResources_;
+    /// Preload manifest recording flag.
+    bool recordManifest_;
+    /// List to append resource requests to.
+    Vector<Pair<ShortStringHash, StringHash> >* requestRecord_;
+    /// Delay in seconds for collecting file changes before reloading.
+    float autoReloadDelay_;
     /// Automatic resource reloading flag.
     bool autoReloadResources_;
 };
@@ -187,6 +279,12 @@ template <class T> T* ResourceCache::GetResource(StringHash nameHash)
     return static_cast<T*>(GetResource(type, nameHash));
 }
 
+template <class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure, Resource* caller)
+{
+    ShortStringHash type = T::GetTypeStatic();
+    return BackgroundLoadResource(type, name, sendEventOnFailure, caller);
+}
+
 template <class T> void ResourceCache::GetResources(PODVector<T*>& result) const
 {
     PODVector<Resource*>& resources = reinterpret_cast<PODVector<Resource*>&>(result);
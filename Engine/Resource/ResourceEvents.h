@@ -42,4 +42,12 @@ EVENT(E_RELOADFAILED, ReloadFailed)
 {
 }
 
+/// Resource background loading finished.
+EVENT(E_RESOURCEBACKGROUNDLOADED, ResourceBackgroundLoaded)
+{
+    PARAM(P_RESOURCENAME, ResourceName);    // String
+    PARAM(P_SUCCESS, Success);              // bool
+    PARAM(P_RESOURCE, Resource);            // Resource pointer
+}
+
 }
@@ -21,21 +21,28 @@
 //
 
 #include "Precompiled.h"
-#include "ArrayPtr.h"
 #include "Context.h"
 #include "Deserializer.h"
 #include "Log.h"
 #include "Profiler.h"
 #include "Serializer.h"
+#include "VectorBuffer.h"
 #include "XMLFile.h"
 
 #include <pugixml.hpp>
 
+#include <cstring>
+
 #include "DebugNew.h"
 
 namespace Urho3D
 {
 
+/// Size of the compiled binary XML header: ID, source checksum and data size.
+static const unsigned BINARY_XML_HEADER_SIZE = 12;
+/// Parse options for the compiled binary XML data. Line endings and attribute whitespace have already been normalized.
+static const unsigned BINARY_XML_PARSE_OPTIONS = pugi::parse_cdata | pugi::parse_escapes;
+
 /// XML writer for pugixml.
 class XMLWriter : public pugi::xml_writer
 {
@@ -64,7 +71,8 @@ OBJECTTYPESTATIC(XMLFile);
 
 XMLFile::XMLFile(Context* context) :
     Resource(context),
-    document_(new pugi::xml_document())
+    document_(new pugi::xml_document()),
+    sourceChecksum_(0)
 {
 }
 
@@ -79,7 +87,7 @@ void XMLFile::RegisterObject(Context* context)
     context->RegisterFactory<XMLFile>();
 }
 
-bool XMLFile::Load(Deserializer& source)
+bool XMLFile::BeginLoad(Deserializer& source)
 {
     PROFILE(LoadXMLFile);
     
@@ -87,11 +95,39 @@ bool XMLFile::Load(Deserializer& source)
     if (!dataSize)
         return false;
     
-    SharedArrayPtr<char> buffer(new char[dataSize]);
-    if (source.Read(buffer.Get(), dataSize) != dataSize)
+    // Read into a buffer allocated by pugixml, so that the document can be parsed in place and take ownership of it
+    char* buffer = (char*)pugi::get_memory_allocation_function()(dataSize);
+    if (!buffer)
         return false;
+    if (source.Read(buffer, dataSize) != dataSize)
+    {
+        pugi::get_memory_deallocation_function()(buffer);
+        return false;
+    }
+    
+    sourceChecksum_ = 0;
+    bool success;
+    
+    // Check for the compiled binary form. Its data is already normalized UTF-8, so less parsing work is needed
+    if (dataSize >= BINARY_XML_HEADER_SIZE && !memcmp(buffer, "UXML", 4))
+    {
+        unsigned binaryDataSize;
+        memcpy(&sourceChecksum_, buffer + 4, sizeof(unsigned));
+        memcpy(&binaryDataSize, buffer + 8, sizeof(unsigned));
+        if (binaryDataSize > dataSize - BINARY_XML_HEADER_SIZE)
+        {
+            pugi::get_memory_deallocation_function()(buffer);
+            LOGERROR("Truncated binary XML data in " + source.GetName());
+            return false;
+        }
+        
+        memmove(buffer, buffer + BINARY_XML_HEADER_SIZE, binaryDataSize);
+        success = document_->load_buffer_inplace_own(buffer, binaryDataSize, BINARY_XML_PARSE_OPTIONS, pugi::encoding_utf8);
+    }
+    else
+        success = document_->load_buffer_inplace_own(buffer, dataSize);
     
-    if (!document_->load_buffer(buffer.Get(), dataSize))
+    if (!success)
     {
         LOGERROR("Could not parse XML data from " + source.GetName());
         return false;
@@ -102,6 +138,12 @@ bool XMLFile::Load(Deserializer& source)
     return true;
 }
 
+bool XMLFile::EndLoad()
+{
+    // No main thread processing needed
+    return true;
+}
+
 bool XMLFile::Save(Serializer& dest) const
 {
     XMLWriter writer(dest);
@@ -109,6 +151,20 @@ bool XMLFile::Save(Serializer& dest) const
     return writer.success_;
 }
 
+bool XMLFile::SaveBinary(Serializer& dest, unsigned sourceChecksum) const
+{
+    // Write without formatting whitespace, comments and declaration into a buffer first to know the data size
+    VectorBuffer data;
+    XMLWriter writer(data);
+    document_->save(writer, "", pugi::format_raw | pugi::format_no_declaration, pugi::encoding_utf8);
+    
+    bool success = dest.WriteFileID("UXML");
+    success &= dest.WriteUInt(sourceChecksum);
+    success &= dest.WriteUInt(data.GetSize());
+    success &= dest.Write(data.GetData(), data.GetSize()) == data.GetSize();
+    return success;
+}
+
 XMLElement XMLFile::CreateRoot(const String& name)
 {
     document_->reset();
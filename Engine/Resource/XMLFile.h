@@ -46,10 +46,14 @@ public:
     /// Register object factory.
     static void RegisterObject(Context* context);
     
-    /// Load resource. Return true if successful.
-    virtual bool Load(Deserializer& source);
+    /// Load resource from stream. May be called from a worker thread. Return true if successful.
+    virtual bool BeginLoad(Deserializer& source);
+    /// Finish resource loading. Always called from the main thread. Return true if successful.
+    virtual bool EndLoad();
     /// Save resource. Return true if successful. Only supports saving to a File.
     virtual bool Save(Serializer& dest) const;
+    /// Save in the compiled binary form, which loads faster. Optionally record the checksum of the source text. Return true if successful.
+    bool SaveBinary(Serializer& dest, unsigned sourceChecksum = 0) const;
     
     /// Clear the document and create a root element.
     XMLElement CreateRoot(const String& name);
@@ -58,10 +62,14 @@ public:
     XMLElement GetRoot(const String& name = String::EMPTY);
     /// Return the pugixml document.
     pugi::xml_document* GetDocument() const { return document_; }
+    /// Return checksum of the source text if loaded from the compiled binary form, or 0 if not known.
+    unsigned GetSourceChecksum() const { return sourceChecksum_; }
     
 private:
     /// Pugixml document.
     pugi::xml_document* document_;
+    /// Checksum of the source text.
+    unsigned sourceChecksum_;
 };
 
 }
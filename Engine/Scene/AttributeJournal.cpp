@@ -0,0 +1,227 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Precompiled.h"
+#include "AttributeJournal.h"
+#include "Component.h"
+#include "Scene.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+AttributeJournal::AttributeJournal(unsigned size) :
+    first_(0),
+    numEntries_(0),
+    numChanges_(0),
+    hash_(0),
+    networkHash_(0)
+{
+    SetSize(size);
+}
+
+AttributeJournal::~AttributeJournal()
+{
+}
+
+void AttributeJournal::SetSize(unsigned size)
+{
+    if (size == entries_.Size())
+        return;
+    
+    // Copy the newest entries in order to the new ring buffer
+    Vector<AttributeChange> newEntries(size);
+    unsigned numKept = numEntries_ < size ? numEntries_ : size;
+    for (unsigned i = 0; i < numKept; ++i)
+        newEntries[i] = GetEntry(numEntries_ - numKept + i);
+    
+    entries_ = newEntries;
+    first_ = 0;
+    numEntries_ = numKept;
+}
+
+static bool GetObjectID(Serializable* object, bool& component, unsigned& id)
+{
+    // Only nodes and components are identified by scene IDs
+    Node* node = dynamic_cast<Node*>(object);
+    if (node)
+    {
+        component = false;
+        id = node->GetID();
+        return true;
+    }
+    
+    Component* comp = dynamic_cast<Component*>(object);
+    if (comp)
+    {
+        component = true;
+        id = comp->GetID();
+        return true;
+    }
+    
+    return false;
+}
+
+void AttributeJournal::Record(Serializable* object, const AttributeInfo& attr, const Variant& oldValue, const Variant& newValue, bool rehash)
+{
+    bool component;
+    unsigned id;
+    if (!GetObjectID(object, component, id))
+        return;
+    
+    // Setting one attribute may change others, for example a node's position and network position, so rehash the whole
+    // object even if the attribute itself did not change
+    if (rehash)
+        UpdateObjectHash(object, component, id);
+    if (newValue == oldValue)
+        return;
+    
+    ++numChanges_;
+    if (entries_.Empty())
+        return;
+    
+    AttributeChange* entry;
+    if (numEntries_ < entries_.Size())
+        entry = &entries_[(first_ + numEntries_++) % entries_.Size()];
+    else
+    {
+        // Ring buffer is full, overwrite the oldest entry
+        entry = &entries_[first_];
+        first_ = (first_ + 1) % entries_.Size();
+    }
+    
+    entry->object_ = object;
+    entry->id_ = id;
+    entry->name_ = attr.name_;
+    entry->oldValue_ = oldValue;
+    entry->newValue_ = newValue;
+}
+
+void AttributeJournal::UpdateHash(Serializable* object)
+{
+    bool component;
+    unsigned id;
+    if (GetObjectID(object, component, id))
+        UpdateObjectHash(object, component, id);
+}
+
+void AttributeJournal::Clear()
+{
+    for (unsigned i = 0; i < entries_.Size(); ++i)
+        entries_[i] = AttributeChange();
+    
+    first_ = 0;
+    numEntries_ = 0;
+}
+
+void AttributeJournal::CalculateHash(Scene* scene)
+{
+    hash_ = 0;
+    networkHash_ = 0;
+    nodeHashes_.Clear();
+    componentHashes_.Clear();
+    if (scene)
+        HashNode(scene);
+}
+
+const AttributeChange& AttributeJournal::GetEntry(unsigned index) const
+{
+    return entries_[(first_ + index) % entries_.Size()];
+}
+
+const AttributeChange* AttributeJournal::GetLastEntry() const
+{
+    return numEntries_ ? &GetEntry(numEntries_ - 1) : 0;
+}
+
+void AttributeJournal::HashNode(Node* node)
+{
+    UpdateObjectHash(node, false, node->GetID());
+    
+    const Vector<SharedPtr<Component> >& components = node->GetComponents();
+    for (Vector<SharedPtr<Component> >::ConstIterator i = components.Begin(); i != components.End(); ++i)
+        UpdateObjectHash(*i, true, (*i)->GetID());
+    
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+        HashNode(*i);
+}
+
+static unsigned HashBuffer(const VectorBuffer& buffer)
+{
+    unsigned hash = 0;
+    const unsigned char* data = buffer.GetData();
+    unsigned size = buffer.GetSize();
+    for (unsigned i = 0; i < size; ++i)
+        hash = SDBMHash(hash, data[i]);
+    
+    return hash;
+}
+
+void AttributeJournal::HashObject(Serializable* object, bool component, unsigned id, unsigned& hash, unsigned& networkHash)
+{
+    // Local objects and attributes differ between the server and the clients, so only replicated objects and their
+    // network attributes go into the network hash
+    bool replicated = id < FIRST_LOCAL_ID;
+    
+    buffer_.Clear();
+    buffer_.WriteBool(component);
+    buffer_.WriteUInt(id);
+    networkBuffer_.Clear();
+    if (replicated)
+    {
+        networkBuffer_.WriteBool(component);
+        networkBuffer_.WriteUInt(id);
+    }
+    
+    const Vector<AttributeInfo>* attributes = object->GetAttributes();
+    if (attributes)
+    {
+        Variant value;
+        for (unsigned i = 0; i < attributes->Size(); ++i)
+        {
+            const AttributeInfo& attr = attributes->At(i);
+            object->OnGetAttribute(attr, value);
+            buffer_.WriteVariant(value);
+            if (replicated && (attr.mode_ & AM_NET))
+                networkBuffer_.WriteVariant(value);
+        }
+    }
+    
+    hash = HashBuffer(buffer_);
+    networkHash = replicated ? HashBuffer(networkBuffer_) : 0;
+}
+
+void AttributeJournal::UpdateObjectHash(Serializable* object, bool component, unsigned id)
+{
+    // Replace the previous hashes of the object, if any, in the scene hashes
+    ObjectHash& objectHash = component ? componentHashes_[id] : nodeHashes_[id];
+    hash_ ^= objectHash.hash_;
+    networkHash_ ^= objectHash.networkHash_;
+    HashObject(object, component, id, objectHash.hash_, objectHash.networkHash_);
+    hash_ ^= objectHash.hash_;
+    networkHash_ ^= objectHash.networkHash_;
+}
+
+}
@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "HashMap.h"
+#include "Ptr.h"
+#include "Variant.h"
+#include "VectorBuffer.h"
+
+namespace Urho3D
+{
+
+class Node;
+class Scene;
+class Serializable;
+
+struct AttributeInfo;
+
+/// Recorded attribute change.
+struct AttributeChange
+{
+    /// Changed node or component.
+    WeakPtr<Serializable> object_;
+    /// ID of the changed node or component.
+    unsigned id_;
+    /// Attribute name.
+    String name_;
+    /// Value before the change.
+    Variant oldValue_;
+    /// Value after the change.
+    Variant newValue_;
+};
+
+/// Last hashes of a node or component.
+struct ObjectHash
+{
+    /// Construct.
+    ObjectHash() :
+        hash_(0),
+        networkHash_(0)
+    {
+    }
+    
+    /// Hash of all attribute values.
+    unsigned hash_;
+    /// Hash of the network attribute values, or zero if the object is not replicated.
+    unsigned networkHash_;
+};
+
+/// %Scene attribute change journal. Records changes made through Serializable::SetAttribute() and network attribute updates into a ring buffer. Also maintains a hash of all node and component attribute values, and a hash of the network attribute values of replicated nodes and components, which are updated incrementally by rehashing only the changed objects.
+class AttributeJournal : public RefCounted
+{
+public:
+    /// Construct with ring buffer size.
+    AttributeJournal(unsigned size);
+    /// Destruct.
+    ~AttributeJournal();
+    
+    /// Set ring buffer size. Keeps the newest entries if shrinking.
+    void SetSize(unsigned size);
+    /// Record an attribute change and optionally rehash the object. An entry is added only if the value changed.
+    void Record(Serializable* object, const AttributeInfo& attr, const Variant& oldValue, const Variant& newValue, bool rehash = true);
+    /// Rehash a node or component after its attributes have been changed and update the hashes.
+    void UpdateHash(Serializable* object);
+    /// Remove all entries. Does not reset the change count or the hash.
+    void Clear();
+    /// Recalculate the hashes from all nodes and components in the scene. Needed after changing the scene by other means than attributes, for example by creating and removing nodes or calling setter functions.
+    void CalculateHash(Scene* scene);
+    
+    /// Return ring buffer size.
+    unsigned GetSize() const { return entries_.Size(); }
+    /// Return number of entries in the ring buffer.
+    unsigned GetNumEntries() const { return numEntries_; }
+    /// Return entry by index, with 0 being the oldest.
+    const AttributeChange& GetEntry(unsigned index) const;
+    /// Return the newest entry, or null if none.
+    const AttributeChange* GetLastEntry() const;
+    /// Return total number of changes recorded, including those that no longer fit in the ring buffer.
+    unsigned GetNumChanges() const { return numChanges_; }
+    /// Return hash of the attribute values.
+    unsigned GetHash() const { return hash_; }
+    /// Return hash of the network attribute values of replicated nodes and components. Equal on the server and the clients when they are in sync.
+    unsigned GetNetworkHash() const { return networkHash_; }
+    
+private:
+    /// Add a node, its components and child nodes to the hash.
+    void HashNode(Node* node);
+    /// Return the hash of all attribute values of a node or component, and the hash of its network attribute values.
+    void HashObject(Serializable* object, bool component, unsigned id, unsigned& hash, unsigned& networkHash);
+    /// Rehash a node or component and update the scene hashes.
+    void UpdateObjectHash(Serializable* object, bool component, unsigned id);
+    
+    /// Ring buffer entries.
+    Vector<AttributeChange> entries_;
+    /// Index of the oldest entry.
+    unsigned first_;
+    /// Number of entries in use.
+    unsigned numEntries_;
+    /// Total number of changes recorded.
+    unsigned numChanges_;
+    /// Hash of the attribute values.
+    unsigned hash_;
+    /// Hash of the network attribute values of replicated objects.
+    unsigned networkHash_;
+    /// Last hashes of nodes by ID.
+    HashMap<unsigned, ObjectHash> nodeHashes_;
+    /// Last hashes of components by ID.
+    HashMap<unsigned, ObjectHash> componentHashes_;
+    /// Buffer for serializing attribute values for hashing.
+    VectorBuffer buffer_;
+    /// Buffer for serializing network attribute values for hashing.
+    VectorBuffer networkBuffer_;
+};
+
+}
@@ -39,7 +39,10 @@ Component::Component(Context* context) :
     node_(0),
     id_(0),
     networkUpdate_(false),
-    enabled_(true)
+    enabled_(true),
+    threadedUpdate_(false),
+    threadedUpdateQueued_(false),
+    typeIndex_(0)
 {
 }
 
@@ -112,6 +115,12 @@ Scene* Component::GetScene() const
     return node_ ? node_->GetScene() : 0;
 }
 
+AttributeJournal* Component::GetAttributeJournal() const
+{
+    Scene* scene = GetScene();
+    return scene ? scene->GetJournal() : 0;
+}
+
 void Component::AddReplicationState(ComponentReplicationState* state)
 {
     if (!networkState_)
@@ -134,22 +143,20 @@ void Component::PrepareNetworkUpdate()
     if (networkState_->currentValues_.Size() != numAttributes)
     {
         networkState_->currentValues_.Resize(numAttributes);
-        networkState_->previousValues_.Resize(numAttributes);
 
-        // Copy the default attribute values to the previous state as a starting point
+        // Copy the default attribute values to the current state as a starting point
         for (unsigned i = 0; i < numAttributes; ++i)
-            networkState_->previousValues_[i] = attributes->At(i).defaultValue_;
+            networkState_->currentValues_[i] = attributes->At(i).defaultValue_;
     }
 
-    // Check for attribute changes
+    // Check for attribute changes. Compare in place first, so that unchanged attributes are not copied into a variant
     for (unsigned i = 0; i < numAttributes; ++i)
     {
         const AttributeInfo& attr = attributes->At(i);
-        OnGetAttribute(attr, networkState_->currentValues_[i]);
 
-        if (networkState_->currentValues_[i] != networkState_->previousValues_[i])
+        if (!AttributeEquals(attr, networkState_->currentValues_[i]))
         {
-            networkState_->previousValues_[i] = networkState_->currentValues_[i];
+            OnGetAttribute(attr, networkState_->currentValues_[i]);
 
             // Mark the attribute dirty in all replication states that are tracking this component
             for (PODVector<ReplicationState*>::Iterator j = networkState_->replicationStates_.Begin(); j !=
@@ -208,6 +215,19 @@ void Component::SetNode(Node* node)
     OnNodeSet(node_);
 }
 
+void Component::SetThreadedUpdate(bool enable)
+{
+    threadedUpdate_ = enable;
+
+    // When disabling, the scene removes the component from its list after the update
+    if (enable && !threadedUpdateQueued_)
+    {
+        Scene* scene = GetScene();
+        if (scene)
+            scene->AddThreadedUpdate(this);
+    }
+}
+
 Component* Component::GetComponent(ShortStringHash type) const
 {
     return node_ ? node_->GetComponent(type) : 0;
@@ -33,6 +33,19 @@ class Scene;
 
 struct ComponentReplicationState;
 
+/// Scene update parameters for the threaded component update.
+struct SceneUpdateInfo
+{
+    /// Scene being updated.
+    Scene* scene_;
+    /// Time step, scaled by the scene's time scale.
+    float timeStep_;
+    /// Network motion smoothing constant for this time step.
+    float smoothingConstant_;
+    /// Squared network motion smoothing snap threshold.
+    float squaredSnapThreshold_;
+};
+
 /// Base class for components. Components can be created to scene nodes.
 class Component : public Serializable
 {
@@ -59,6 +72,8 @@ public:
     virtual void GetDependencyNodes(PODVector<Node*>& dest) {};
     /// Visualize the component as debug geometry.
     virtual void DrawDebugGeometry(DebugRenderer* debug, bool depthTest) {};
+    /// Perform the threaded update, if enabled. May be called from a worker thread, so should only modify the component itself and the local transform of its own scene node.
+    virtual void ThreadedUpdate(const SceneUpdateInfo& info) {};
     
     /// Set enabled/disabled state.
     void SetEnabled(bool enable);
@@ -75,6 +90,8 @@ public:
     bool IsEnabled() const { return enabled_; }
     /// Return whether is effectively enabled (node is also enabled.)
     bool IsEnabledEffective() const;
+    /// Return whether threaded update is enabled.
+    bool GetThreadedUpdate() const { return threadedUpdate_; }
     /// Return component in the same scene node by type. If there are several, returns the first.
     Component* GetComponent(ShortStringHash type) const;
     /// Return components in the same scene node by type.
@@ -94,6 +111,8 @@ public:
     void MarkNetworkUpdate();
     
 protected:
+    /// Return the scene's attribute change journal, or null if not recording.
+    virtual AttributeJournal* GetAttributeJournal() const;
     /// Handle scene node being assigned at creation.
     virtual void OnNodeSet(Node* node) {};
     /// Handle scene node transform dirtied.
@@ -102,6 +121,8 @@ protected:
     void SetID(unsigned id);
     /// Set scene node. Called by Node when creating the component.
     void SetNode(Node* node);
+    /// Enable or disable threaded update. Enabling must happen in the main thread, but disabling is allowed also from within the threaded update.
+    void SetThreadedUpdate(bool enable);
     
     /// Scene node.
     Node* node_;
@@ -111,6 +132,12 @@ protected:
     bool networkUpdate_;
     /// Enabled flag.
     bool enabled_;
+    /// Threaded update enabled flag.
+    bool threadedUpdate_;
+    /// In the scene's threaded update list flag.
+    bool threadedUpdateQueued_;
+    /// Index in the scene's list of components of the same type.
+    unsigned typeIndex_;
 };
 
 template <class T> T* Component::GetComponent() const { return static_cast<T*>(GetComponent(T::GetTypeStatic())); }
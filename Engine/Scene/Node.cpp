@@ -30,6 +30,7 @@
 #include "Scene.h"
 #include "SceneEvents.h"
 #include "SmoothedTransform.h"
+#include "Thread.h"
 #include "XMLFile.h"
 
 #include "DebugNew.h"
@@ -45,9 +46,11 @@ Node::Node(Context* context) :
     dirty_(false),
     networkUpdate_(false),
     enabled_(true),
+    temporary_(false),
     parent_(0),
     scene_(0),
     id_(0),
+    transformIndex_(M_MAX_UNSIGNED),
     position_(Vector3::ZERO),
     rotation_(Quaternion::IDENTITY),
     scale_(Vector3::ONE),
@@ -129,11 +132,19 @@ bool Node::Save(Serializer& dest) const
         dest.Write(compBuffer.GetData(), compBuffer.GetSize());
     }
 
-    // Write child nodes
-    dest.WriteVLE(children_.Size());
+    // Write child nodes, except temporary ones
+    unsigned numChildren = 0;
+    for (unsigned i = 0; i < children_.Size(); ++i)
+    {
+        if (!children_[i]->IsTemporary())
+            ++numChildren;
+    }
+    dest.WriteVLE(numChildren);
     for (unsigned i = 0; i < children_.Size(); ++i)
     {
         Node* node = children_[i];
+        if (node->IsTemporary())
+            continue;
         if (!node->Save(dest))
             return false;
     }
@@ -179,10 +190,12 @@ bool Node::SaveXML(XMLElement& dest) const
             return false;
     }
 
-    // Write child nodes
+    // Write child nodes, except temporary ones
     for (unsigned i = 0; i < children_.Size(); ++i)
     {
         Node* node = children_[i];
+        if (node->IsTemporary())
+            continue;
         XMLElement childElem = dest.CreateChild("node");
         if (!node->SaveXML(childElem))
             return false;
@@ -479,6 +492,11 @@ void Node::SetOwner(Connection* owner)
     owner_ = owner;
 }
 
+void Node::SetTemporary(bool enable)
+{
+    temporary_ = enable;
+}
+
 void Node::MarkDirty()
 {
     if (dirty_)
@@ -486,18 +504,12 @@ void Node::MarkDirty()
 
     dirty_ = true;
 
-    // Notify listener components first, then mark child nodes
-    for (Vector<WeakPtr<Component> >::Iterator i = listeners_.Begin(); i != listeners_.End();)
-    {
-        if (*i)
-        {
-            (*i)->OnMarkedDirty(this);
-            ++i;
-        }
-        // If listener has expired, erase from list
-        else
-            i = listeners_.Erase(i);
-    }
+    // Notify listener components first, then mark child nodes. With batched transform updates the scene notifies the
+    // listeners later, unless marking happens outside the main thread, for example during animation
+    if (scene_ && scene_->GetTransformBatching() && Thread::IsMainThread())
+        scene_->QueueTransformUpdate(this);
+    else
+        NotifyListeners();
 
     for (Vector<SharedPtr<Node> >::Iterator i = children_.Begin(); i != children_.End(); ++i)
         (*i)->MarkDirty();
@@ -876,6 +888,11 @@ void Node::ResetScene()
     SetOwner(0);
 }
 
+AttributeJournal* Node::GetAttributeJournal() const
+{
+    return scene_ ? scene_->GetJournal() : 0;
+}
+
 void Node::SetNetPositionAttr(const Vector3& value)
 {
     SmoothedTransform* transform = GetComponent<SmoothedTransform>();
@@ -1093,22 +1110,20 @@ void Node::PrepareNetworkUpdate()
     if (networkState_->currentValues_.Size() != numAttributes)
     {
         networkState_->currentValues_.Resize(numAttributes);
-        networkState_->previousValues_.Resize(numAttributes);
 
-        // Copy the default attribute values to the previous state as a starting point
+        // Copy the default attribute values to the current state as a starting point
         for (unsigned i = 0; i < numAttributes; ++i)
-            networkState_->previousValues_[i] = attributes->At(i).defaultValue_;
+            networkState_->currentValues_[i] = attributes->At(i).defaultValue_;
     }
 
-    // Check for attribute changes
+    // Check for attribute changes. Compare in place first, so that unchanged attributes are not copied into a variant
     for (unsigned i = 0; i < numAttributes; ++i)
     {
         const AttributeInfo& attr = attributes->At(i);
-        OnGetAttribute(attr, networkState_->currentValues_[i]);
 
-        if (networkState_->currentValues_[i] != networkState_->previousValues_[i])
+        if (!AttributeEquals(attr, networkState_->currentValues_[i]))
         {
-            networkState_->previousValues_[i] = networkState_->currentValues_[i];
+            OnGetAttribute(attr, networkState_->currentValues_[i]);
 
             // Mark the attribute dirty in all replication states that are tracking this node
             for (PODVector<ReplicationState*>::Iterator j = networkState_->replicationStates_.Begin(); j !=
@@ -1271,6 +1286,21 @@ void Node::UpdateWorldTransform() const
     dirty_ = false;
 }
 
+void Node::NotifyListeners()
+{
+    for (Vector<WeakPtr<Component> >::Iterator i = listeners_.Begin(); i != listeners_.End();)
+    {
+        if (*i)
+        {
+            (*i)->OnMarkedDirty(this);
+            ++i;
+        }
+        // If listener has expired, erase from list
+        else
+            i = listeners_.Erase(i);
+    }
+}
+
 void Node::RemoveChild(Vector<SharedPtr<Node> >::Iterator i)
 {
     // Send change event. Do not send when already being destroyed
@@ -1332,10 +1362,19 @@ Node* Node::CloneRecursive(Node* parent, SceneResolver& resolver, CreateMode mod
     Node* cloneNode = parent->CreateChild(0, (mode == REPLICATED && id_ < FIRST_LOCAL_ID) ? REPLICATED : LOCAL);
     resolver.AddNode(id_, cloneNode);
 
-    // Copy attributes
-    unsigned numAttributes = GetNumAttributes();
-    for (unsigned j = 0; j < numAttributes; ++j)
-        cloneNode->SetAttribute(j, GetAttribute(j));
+    // Copy attributes. Do not copy network-only attributes, as the network parent attribute would move the clone.
+    // Reuse the same variant for all attribute values to avoid reallocating its storage
+    Variant value;
+    const Vector<AttributeInfo>* attributes = GetAttributes();
+    for (unsigned j = 0; j < attributes->Size(); ++j)
+    {
+        const AttributeInfo& attr = attributes->At(j);
+        if (attr.mode_ & AM_FILE)
+        {
+            OnGetAttribute(attr, value);
+            cloneNode->OnSetAttribute(attr, value);
+        }
+    }
 
     // Clone components
     for (Vector<SharedPtr<Component> >::ConstIterator i = components_.Begin(); i != components_.End(); ++i)
@@ -1350,9 +1389,14 @@ Node* Node::CloneRecursive(Node* parent, SceneResolver& resolver, CreateMode mod
         }
         resolver.AddComponent(component->GetID(), cloneComponent);
 
-        numAttributes = component->GetNumAttributes();
+        // The clone's attribute list may change while attributes are being set (script objects), so set by index
+        const Vector<AttributeInfo>* compAttributes = component->GetAttributes();
+        unsigned numAttributes = compAttributes ? compAttributes->Size() : 0;
         for (unsigned j = 0; j < numAttributes; ++j)
-            cloneComponent->SetAttribute(j, component->GetAttribute(j));
+        {
+            component->OnGetAttribute(compAttributes->At(j), value);
+            cloneComponent->SetAttribute(j, value);
+        }
     }
 
     // Clone child nodes recursively
@@ -49,6 +49,7 @@ class Node : public Serializable
     OBJECT(Node);
 
     friend class Connection;
+    friend class TransformStore;
 
 public:
     /// Construct.
@@ -135,6 +136,8 @@ public:
     void SetEnabled(bool enable, bool recursive);
     /// Set owner connection for networking.
     void SetOwner(Connection* owner);
+    /// Set temporary mode. Temporary nodes and their children are not saved, for example streamed content.
+    void SetTemporary(bool enable);
     /// Mark node and child nodes to need world transform recalculation. Notify listener components.
     void MarkDirty();
     /// Create a child scene node (with specified ID if provided).
@@ -186,6 +189,8 @@ public:
     bool IsEnabled() const { return enabled_; }
     /// Return owner connection in networking.
     Connection* GetOwner() const { return owner_; }
+    /// Return whether is temporary.
+    bool IsTemporary() const { return temporary_; }
     /// Return position relative to parent node.
     const Vector3& GetPosition() const { return position_; }
     /// Return rotation relative to parent node.
@@ -337,12 +342,17 @@ public:
     void AddComponent(Component* component, unsigned id, CreateMode mode);
 
 protected:
+    /// Return the scene's attribute change journal, or null if not recording.
+    virtual AttributeJournal* GetAttributeJournal() const;
+
     /// User variables.
     VariantMap vars_;
 
 private:
     /// Recalculate the world transform.
     void UpdateWorldTransform() const;
+    /// Notify listener components of the transform having changed.
+    void NotifyListeners();
     /// Remove child node by iterator.
     void RemoveChild(Vector<SharedPtr<Node> >::Iterator i);
     /// Return child nodes recursively.
@@ -364,12 +374,16 @@ private:
     bool networkUpdate_;
     /// Enabled flag.
     bool enabled_;
+    /// Temporary flag.
+    bool temporary_;
     /// Parent scene node.
     Node* parent_;
     /// Scene (root node.)
     Scene* scene_;
     /// Unique ID within the scene.
     unsigned id_;
+    /// Index in the scene's batched transform update queue, or M_MAX_UNSIGNED if not queued.
+    unsigned transformIndex_;
     /// Position.
     Vector3 position_;
     /// Rotation.
@@ -0,0 +1,332 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Precompiled.h"
+#include "Component.h"
+#include "Context.h"
+#include "FileSystem.h"
+#include "Log.h"
+#include "MemoryBuffer.h"
+#include "Prefab.h"
+#include "Profiler.h"
+#include "Scene.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+OBJECTTYPESTATIC(Prefab);
+
+Prefab::Prefab(Context* context) :
+    Resource(context),
+    xml_(false)
+{
+}
+
+Prefab::~Prefab()
+{
+}
+
+void Prefab::RegisterObject(Context* context)
+{
+    context->RegisterFactory<Prefab>();
+}
+
+bool Prefab::Load(Deserializer& source)
+{
+    PROFILE(LoadPrefab);
+    
+    nodes_.Clear();
+    components_.Clear();
+    attributes_.Clear();
+    references_.Clear();
+    
+    unsigned dataSize = source.GetSize();
+    if (!dataSize && !source.GetName().Empty())
+    {
+        LOGERROR("Zero sized prefab data in " + source.GetName());
+        return false;
+    }
+    
+    data_.Resize(dataSize);
+    if (source.Read(&data_[0], dataSize) != dataSize)
+    {
+        data_.Clear();
+        return false;
+    }
+    
+    xml_ = GetExtension(source.GetName()) == ".xml";
+    UpdateMemoryUse();
+    return true;
+}
+
+bool Prefab::Define(Node* node)
+{
+    if (!node)
+    {
+        LOGERROR("Null node for prefab definition");
+        return false;
+    }
+    if (node == node->GetScene())
+    {
+        LOGERROR("Can not define a prefab from the scene root node");
+        return false;
+    }
+    
+    PROFILE(DefinePrefab);
+    
+    nodes_.Clear();
+    components_.Clear();
+    attributes_.Clear();
+    references_.Clear();
+    
+    HashMap<unsigned, unsigned> nodeIndices;
+    HashMap<unsigned, unsigned> componentIndices;
+    PODVector<Component*> sources;
+    DefineNode(node, M_MAX_UNSIGNED, nodeIndices, componentIndices, sources);
+    
+    // Resolve node and component ID attributes to indices within the prefab. IDs that refer outside the prefab are kept
+    // as they are
+    for (unsigned i = 0; i < components_.Size(); ++i)
+    {
+        const PrefabComponent& comp = components_[i];
+        const Vector<AttributeInfo>* attributes = sources[i]->GetAttributes();
+        
+        for (unsigned j = comp.firstAttribute_; j < comp.firstAttribute_ + comp.numAttributes_; ++j)
+        {
+            PrefabAttribute& attr = attributes_[j];
+            unsigned mode = attributes->At(attr.index_).mode_;
+            if (!(mode & (AM_NODEID | AM_COMPONENTID)))
+                continue;
+            
+            unsigned id = attr.value_.GetInt();
+            if (!id)
+                continue;
+            
+            const HashMap<unsigned, unsigned>& indices = (mode & AM_NODEID) ? nodeIndices : componentIndices;
+            HashMap<unsigned, unsigned>::ConstIterator k = indices.Find(id);
+            if (k == indices.End())
+            {
+                LOGWARNING("ID " + String(id) + " refers outside the prefab, can not resolve");
+                continue;
+            }
+            
+            PrefabReference ref;
+            ref.component_ = i;
+            ref.attribute_ = attr.index_;
+            ref.target_ = k->second_;
+            ref.componentTarget_ = (mode & AM_NODEID) == 0;
+            references_.Push(ref);
+            // Leave the ID null until the referred object has been created
+            attr.value_ = 0;
+        }
+    }
+    
+    UpdateMemoryUse();
+    return true;
+}
+
+unsigned Prefab::Instantiate(PODVector<Node*>& dest, Scene* scene, unsigned count, const Vector3& position, const Quaternion& rotation, CreateMode mode)
+{
+    if (!scene)
+    {
+        LOGERROR("Null scene for prefab instantiation");
+        return 0;
+    }
+    if (!count)
+        return 0;
+    
+    PROFILE(InstantiatePrefab);
+    
+    unsigned created = 0;
+    
+    // Capture the layout from the first instance, which is loaded the ordinary way. This way the components are created
+    // in the scene they belong to, and any scene-level subsystems they need are present
+    if (nodes_.Empty())
+    {
+        if (data_.Empty())
+        {
+            LOGERROR("Prefab " + GetName() + " has no data");
+            return 0;
+        }
+        
+        Node* first = LoadInstance(scene, position, rotation, mode);
+        if (!first)
+            return 0;
+        
+        Define(first);
+        dest.Push(first);
+        ++created;
+    }
+    
+    PODVector<Node*> nodes(nodes_.Size());
+    PODVector<Component*> components(components_.Size());
+    
+    for (; created < count; ++created)
+    {
+        Node* root = CreateInstance(scene, mode, nodes, components);
+        root->SetTransform(position, rotation);
+        dest.Push(root);
+    }
+    
+    return created;
+}
+
+void Prefab::DefineNode(Node* node, unsigned parentIndex, HashMap<unsigned, unsigned>& nodeIndices, HashMap<unsigned, unsigned>& componentIndices, PODVector<Component*>& sources)
+{
+    unsigned index = nodes_.Size();
+    nodeIndices[node->GetID()] = index;
+    
+    PrefabNode newNode;
+    newNode.parent_ = parentIndex;
+    newNode.replicated_ = node->GetID() < FIRST_LOCAL_ID;
+    DefineAttributes(node, newNode.firstAttribute_, newNode.numAttributes_);
+    newNode.firstComponent_ = components_.Size();
+    newNode.numComponents_ = 0;
+    
+    const Vector<SharedPtr<Component> >& nodeComponents = node->GetComponents();
+    for (Vector<SharedPtr<Component> >::ConstIterator i = nodeComponents.Begin(); i != nodeComponents.End(); ++i)
+    {
+        Component* component = *i;
+        componentIndices[component->GetID()] = components_.Size();
+        
+        PrefabComponent newComponent;
+        newComponent.type_ = component->GetType();
+        newComponent.replicated_ = component->GetID() < FIRST_LOCAL_ID;
+        DefineAttributes(component, newComponent.firstAttribute_, newComponent.numAttributes_);
+        components_.Push(newComponent);
+        sources.Push(component);
+        ++newNode.numComponents_;
+    }
+    
+    nodes_.Push(newNode);
+    
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+    {
+        if (!(*i)->IsTemporary())
+            DefineNode(*i, index, nodeIndices, componentIndices, sources);
+    }
+}
+
+void Prefab::DefineAttributes(Serializable* source, unsigned& firstAttribute, unsigned& numAttributes)
+{
+    firstAttribute = attributes_.Size();
+    numAttributes = 0;
+    
+    const Vector<AttributeInfo>* attributes = source->GetAttributes();
+    if (!attributes)
+        return;
+    
+    // Capture the same attributes as binary serialization, so that instantiation matches loading the node data
+    for (unsigned i = 0; i < attributes->Size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->At(i);
+        if (!(attr.mode_ & AM_FILE))
+            continue;
+        
+        PrefabAttribute newAttribute;
+        newAttribute.index_ = i;
+        source->OnGetAttribute(attr, newAttribute.value_);
+        attributes_.Push(newAttribute);
+        ++numAttributes;
+    }
+}
+
+Node* Prefab::LoadInstance(Scene* scene, const Vector3& position, const Quaternion& rotation, CreateMode mode)
+{
+    MemoryBuffer buffer(data_);
+    
+    if (xml_)
+        return scene->InstantiateXML(buffer, position, rotation, mode);
+    else
+        return scene->Instantiate(buffer, position, rotation, mode);
+}
+
+Node* Prefab::CreateInstance(Scene* scene, CreateMode mode, PODVector<Node*>& nodes, PODVector<Component*>& components)
+{
+    for (unsigned i = 0; i < nodes_.Size(); ++i)
+    {
+        const PrefabNode& srcNode = nodes_[i];
+        Node* parent = srcNode.parent_ != M_MAX_UNSIGNED ? nodes[srcNode.parent_] : scene;
+        Node* node = parent->CreateChild(0, (mode == REPLICATED && srcNode.replicated_) ? REPLICATED : LOCAL);
+        nodes[i] = node;
+        SetAttributes(node, srcNode.firstAttribute_, srcNode.numAttributes_);
+        
+        for (unsigned j = srcNode.firstComponent_; j < srcNode.firstComponent_ + srcNode.numComponents_; ++j)
+        {
+            const PrefabComponent& srcComponent = components_[j];
+            Component* component = node->CreateComponent(srcComponent.type_, (mode == REPLICATED && srcComponent.replicated_) ?
+                REPLICATED : LOCAL);
+            components[j] = component;
+            if (component)
+                SetAttributes(component, srcComponent.firstAttribute_, srcComponent.numAttributes_);
+        }
+    }
+    
+    // Point the ID attributes to the objects of this instance
+    for (PODVector<PrefabReference>::ConstIterator i = references_.Begin(); i != references_.End(); ++i)
+    {
+        Component* component = components[i->component_];
+        if (!component)
+            continue;
+        
+        unsigned id = 0;
+        if (i->componentTarget_)
+        {
+            Component* target = components[i->target_];
+            id = target ? target->GetID() : 0;
+        }
+        else
+            id = nodes[i->target_]->GetID();
+        
+        component->SetAttribute(i->attribute_, Variant(id));
+    }
+    
+    nodes[0]->ApplyAttributes();
+    return nodes[0];
+}
+
+void Prefab::SetAttributes(Serializable* dest, unsigned firstAttribute, unsigned numAttributes)
+{
+    // The attribute list may grow while setting the attributes, for example in script objects, so check the size each time
+    const Vector<AttributeInfo>* attributes = dest->GetAttributes();
+    if (!attributes)
+        return;
+    
+    for (unsigned i = firstAttribute; i < firstAttribute + numAttributes; ++i)
+    {
+        const PrefabAttribute& attr = attributes_[i];
+        if (attr.index_ < attributes->Size())
+            dest->OnSetAttribute(attributes->At(attr.index_), attr.value_);
+    }
+}
+
+void Prefab::UpdateMemoryUse()
+{
+    SetMemoryUse(sizeof(Prefab) + data_.Size() + nodes_.Size() * sizeof(PrefabNode) + components_.Size() *
+        sizeof(PrefabComponent) + attributes_.Size() * sizeof(PrefabAttribute) + references_.Size() * sizeof(PrefabReference));
+}
+
+}
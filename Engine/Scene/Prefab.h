@@ -0,0 +1,142 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Node.h"
+#include "Resource.h"
+
+namespace Urho3D
+{
+
+class Scene;
+
+/// Captured attribute value of a prefab node or component.
+struct PrefabAttribute
+{
+    /// Attribute index.
+    unsigned index_;
+    /// Attribute value.
+    Variant value_;
+};
+
+/// Prefab component description.
+struct PrefabComponent
+{
+    /// Component type.
+    ShortStringHash type_;
+    /// Replicated flag.
+    bool replicated_;
+    /// Index of the first attribute.
+    unsigned firstAttribute_;
+    /// Number of attributes.
+    unsigned numAttributes_;
+};
+
+/// Prefab node description.
+struct PrefabNode
+{
+    /// Index of the parent node, or M_MAX_UNSIGNED for the root node.
+    unsigned parent_;
+    /// Replicated flag.
+    bool replicated_;
+    /// Index of the first attribute.
+    unsigned firstAttribute_;
+    /// Number of attributes.
+    unsigned numAttributes_;
+    /// Index of the first component.
+    unsigned firstComponent_;
+    /// Number of components.
+    unsigned numComponents_;
+};
+
+/// Node or component ID attribute of a prefab component, pointing to another node or component within the prefab.
+struct PrefabReference
+{
+    /// Index of the component that has the attribute.
+    unsigned component_;
+    /// Attribute index.
+    unsigned attribute_;
+    /// Index of the referred node or component.
+    unsigned target_;
+    /// Whether the referred object is a component.
+    bool componentTarget_;
+};
+
+/// %Node hierarchy resource for fast repeated instantiation. The node and component layout and the attribute values are captured once, after which instantiation does not need to parse data or resolve IDs.
+class Prefab : public Resource
+{
+    OBJECT(Prefab);
+    
+public:
+    /// Construct.
+    Prefab(Context* context);
+    /// Destruct.
+    virtual ~Prefab();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+    
+    /// Load resource from binary or XML node data, as saved by Node. The data is captured on the first instantiation. Return true if successful.
+    virtual bool Load(Deserializer& source);
+    
+    /// Define from an existing node hierarchy. Return true if successful.
+    bool Define(Node* node);
+    /// Instantiate into a scene several times at the same position. Append the root nodes to the destination vector. Return number of instances created.
+    unsigned Instantiate(PODVector<Node*>& dest, Scene* scene, unsigned count, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
+    
+    /// Return whether the node hierarchy has been captured.
+    bool IsDefined() const { return !nodes_.Empty(); }
+    /// Return number of nodes.
+    unsigned GetNumNodes() const { return nodes_.Size(); }
+    /// Return number of components.
+    unsigned GetNumComponents() const { return components_.Size(); }
+    
+private:
+    /// Capture a node, its components and child nodes recursively.
+    void DefineNode(Node* node, unsigned parentIndex, HashMap<unsigned, unsigned>& nodeIndices, HashMap<unsigned, unsigned>& componentIndices, PODVector<Component*>& sources);
+    /// Capture the file attributes of a node or component.
+    void DefineAttributes(Serializable* source, unsigned& firstAttribute, unsigned& numAttributes);
+    /// Instantiate from the loaded data by the ordinary scene load path. Return root node if successful.
+    Node* LoadInstance(Scene* scene, const Vector3& position, const Quaternion& rotation, CreateMode mode);
+    /// Instantiate from the captured layout. Return root node.
+    Node* CreateInstance(Scene* scene, CreateMode mode, PODVector<Node*>& nodes, PODVector<Component*>& components);
+    /// Set captured attributes to a node or component.
+    void SetAttributes(Serializable* dest, unsigned firstAttribute, unsigned numAttributes);
+    /// Update memory use.
+    void UpdateMemoryUse();
+    
+    /// Loaded node data.
+    PODVector<unsigned char> data_;
+    /// Loaded node data is XML flag.
+    bool xml_;
+    /// Nodes in the order of creation.
+    PODVector<PrefabNode> nodes_;
+    /// Components in the order of creation.
+    PODVector<PrefabComponent> components_;
+    /// Captured attribute values.
+    Vector<PrefabAttribute> attributes_;
+    /// Node and component ID attributes to resolve after instantiation.
+    PODVector<PrefabReference> references_;
+};
+
+}
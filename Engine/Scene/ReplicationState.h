@@ -127,8 +127,6 @@ struct NetworkState
     const Vector<AttributeInfo>* attributes_;
     /// Current network attribute values.
     Vector<Variant> currentValues_;
-    /// Previous network attribute values.
-    Vector<Variant> previousValues_;
     /// Replication states that are tracking this object.
     PODVector<ReplicationState*> replicationStates_;
     /// Previous user variables.
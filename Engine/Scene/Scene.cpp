@@ -22,17 +22,25 @@
 
 #include "Precompiled.h"
 #include "Component.h"
+#include "Compression.h"
 #include "Context.h"
 #include "CoreEvents.h"
 #include "File.h"
 #include "Log.h"
+#include "MemoryBuffer.h"
 #include "PackageFile.h"
+#include "Prefab.h"
 #include "Profiler.h"
 #include "ReplicationState.h"
+#include "ResourceCache.h"
+#include "ResourceEvents.h"
 #include "Scene.h"
 #include "SceneEvents.h"
 #include "SmoothedTransform.h"
+#include "Timer.h"
+#include "VectorBuffer.h"
 #include "WorkQueue.h"
+#include "WorldPartition.h"
 #include "XMLFile.h"
 
 #include "DebugNew.h"
@@ -48,11 +56,62 @@ static const int ASYNC_LOAD_MIN_FPS = 30;
 static const int ASYNC_LOAD_MAX_MSEC = (int)(1000.0f / ASYNC_LOAD_MIN_FPS);
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
+static const int COMPONENTS_PER_WORK_ITEM = 16;
+static const int DEFAULT_MAX_FIXED_STEPS = 5;
+static const float MAX_LOW_PRIORITY_DELAY = 0.25f;
+static const unsigned PACKED_SCENE_VERSION = 1;
+static const unsigned PACKED_SCENE_COMPRESSED = 0x1;
+static const unsigned MAX_PACKED_SCENE_SIZE = 0x10000000;
+
+/// Object type in the packed scene format, with the saved attribute layout and the instances in load order.
+struct PackedType
+{
+    /// Construct.
+    PackedType() :
+        fixedLayout_(false),
+        sameLayout_(true)
+    {
+    }
+
+    /// Object type.
+    ShortStringHash type_;
+    /// Whether all instances share the registered attributes of the type. If false, each instance describes its own attributes.
+    bool fixedLayout_;
+    /// Whether the saved attributes match the currently registered attributes.
+    bool sameLayout_;
+    /// Saved attribute names.
+    Vector<String> names_;
+    /// Saved attribute types.
+    PODVector<VariantType> types_;
+    /// Saved attribute index for each currently registered file attribute, or M_MAX_UNSIGNED if not saved.
+    PODVector<unsigned> remap_;
+    /// Instances in saving or loading order. Null if the object could not be created.
+    PODVector<Serializable*> instances_;
+};
+
+void UpdateComponentsWork(const WorkItem* item, unsigned threadIndex)
+{
+    const SceneUpdateInfo& info = *(reinterpret_cast<SceneUpdateInfo*>(item->aux_));
+    WeakPtr<Component>* start = reinterpret_cast<WeakPtr<Component>*>(item->start_);
+    WeakPtr<Component>* end = reinterpret_cast<WeakPtr<Component>*>(item->end_);
+
+    while (start != end)
+    {
+        Component* component = *start;
+        if (component && component->GetThreadedUpdate())
+            component->ThreadedUpdate(info);
+        ++start;
+    }
+}
 
 OBJECTTYPESTATIC(Scene);
 
 Scene::Scene(Context* context) :
     Node(context),
+    replicatedNodes_(FIRST_REPLICATED_ID),
+    localNodes_(FIRST_LOCAL_ID),
+    replicatedComponents_(FIRST_REPLICATED_ID),
+    localComponents_(FIRST_LOCAL_ID),
     replicatedNodeID_(FIRST_REPLICATED_ID),
     replicatedComponentID_(FIRST_REPLICATED_ID),
     localNodeID_(FIRST_LOCAL_ID),
@@ -62,9 +121,18 @@ Scene::Scene(Context* context) :
     elapsedTime_(0),
     smoothingConstant_(DEFAULT_SMOOTHING_CONSTANT),
     snapThreshold_(DEFAULT_SNAP_THRESHOLD),
+    fixedUpdateFps_(0),
+    maxFixedSteps_(DEFAULT_MAX_FIXED_STEPS),
+    updateBudget_(0),
+    fixedUpdateAcc_(0.0f),
+    fixedUpdateAlpha_(0.0f),
+    lowPriorityTimeAcc_(0.0f),
+    fixedTick_(0),
+    numDroppedFixedSteps_(0),
     updateEnabled_(true),
     asyncLoading_(false),
-    threadedUpdate_(false)
+    threadedUpdate_(false),
+    transformBatching_(false)
 {
     // Assign an ID to self so that nodes can refer to this node as a parent
     SetID(GetFreeNodeID(REPLICATED));
@@ -79,10 +147,12 @@ Scene::~Scene()
     RemoveAllComponents();
 
     // Remove scene reference and owner from all nodes that still exist
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
-        i->second_->ResetScene();
-    for (HashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
-        i->second_->ResetScene();
+    const PODVector<Node*>& replicatedNodes = replicatedNodes_.GetValues();
+    for (PODVector<Node*>::ConstIterator i = replicatedNodes.Begin(); i != replicatedNodes.End(); ++i)
+        (*i)->ResetScene();
+    const PODVector<Node*>& localNodes = localNodes_.GetValues();
+    for (PODVector<Node*>::ConstIterator i = localNodes.Begin(); i != localNodes.End(); ++i)
+        (*i)->ResetScene();
 }
 
 void Scene::RegisterObject(Context* context)
@@ -96,11 +166,15 @@ void Scene::RegisterObject(Context* context)
     ACCESSOR_ATTRIBUTE(Scene, VAR_FLOAT, "Time Scale", GetTimeScale, SetTimeScale, float, 1.0f, AM_DEFAULT);
     ACCESSOR_ATTRIBUTE(Scene, VAR_FLOAT, "Smoothing Constant", GetSmoothingConstant, SetSmoothingConstant, float, DEFAULT_SMOOTHING_CONSTANT, AM_DEFAULT);
     ACCESSOR_ATTRIBUTE(Scene, VAR_FLOAT, "Snap Threshold", GetSnapThreshold, SetSnapThreshold, float, DEFAULT_SNAP_THRESHOLD, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE(Scene, VAR_INT, "Fixed Update FPS", GetFixedUpdateFps, SetFixedUpdateFps, int, 0, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE(Scene, VAR_INT, "Max Fixed Steps", GetMaxFixedSteps, SetMaxFixedSteps, int, DEFAULT_MAX_FIXED_STEPS, AM_FILE);
+    ACCESSOR_ATTRIBUTE(Scene, VAR_INT, "Update Budget", GetUpdateBudget, SetUpdateBudget, int, 0, AM_FILE);
     ACCESSOR_ATTRIBUTE(Scene, VAR_FLOAT, "Elapsed Time", GetElapsedTime, SetElapsedTime, float, 0.0f, AM_FILE);
     ATTRIBUTE(Scene, VAR_INT, "Next Replicated Node ID", replicatedNodeID_, FIRST_REPLICATED_ID, AM_FILE | AM_NOEDIT);
     ATTRIBUTE(Scene, VAR_INT, "Next Replicated Component ID", replicatedComponentID_, FIRST_REPLICATED_ID, AM_FILE | AM_NOEDIT);
     ATTRIBUTE(Scene, VAR_INT, "Next Local Node ID", localNodeID_, FIRST_LOCAL_ID, AM_FILE | AM_NOEDIT);
     ATTRIBUTE(Scene, VAR_INT, "Next Local Component ID", localComponentID_, FIRST_LOCAL_ID, AM_FILE | AM_NOEDIT);
+    ATTRIBUTE(Scene, VAR_INT, "Fixed Tick", fixedTick_, 0, AM_FILE | AM_NOEDIT);
     ATTRIBUTE(Scene, VAR_VARIANTMAP, "Variables", vars_, Variant::emptyVariantMap, AM_FILE); // Network replication of vars uses custom data
     ACCESSOR_ATTRIBUTE(Scene, VAR_STRING, "Variable Names", GetVarNamesAttr, SetVarNamesAttr, String, String::EMPTY, AM_FILE | AM_NOEDIT);
     REF_ACCESSOR_ATTRIBUTE(Scene, VAR_BUFFER, "Network Rotation", GetNetRotationAttr, SetNetRotationAttr, PODVector<unsigned char>, Variant::emptyBuffer, AM_NET | AM_LATESTDATA | AM_NOEDIT);
@@ -113,7 +187,8 @@ bool Scene::Load(Deserializer& source, bool setInstanceDefault)
     StopAsyncLoading();
 
     // Check ID
-    if (source.ReadFileID() != "USCN")
+    String fileID = source.ReadFileID();
+    if (fileID != "USCN" && fileID != "USCB")
     {
         LOGERROR(source.GetName() + " is not a valid scene file");
         return false;
@@ -123,6 +198,18 @@ bool Scene::Load(Deserializer& source, bool setInstanceDefault)
 
     Clear();
 
+    if (fileID == "USCB")
+    {
+        SceneResolver resolver;
+        if (!LoadPacked(source, resolver, setInstanceDefault))
+            return false;
+
+        resolver.Resolve();
+        ApplyAttributes();
+        FinishLoading(&source);
+        return true;
+    }
+
     // Load the whole scene, then perform post-load if successfully loaded
     if (Node::Load(source, setInstanceDefault))
     {
@@ -157,6 +244,167 @@ bool Scene::Save(Serializer& dest) const
         return false;
 }
 
+bool Scene::SavePacked(Serializer& dest, bool compress) const
+{
+    PROFILE(SavePackedScene);
+
+    Vector<PackedType> types;
+    HashMap<ShortStringHash, unsigned> typeIndices;
+
+    // The scene and its child nodes are always the first two types
+    types.Resize(2);
+    types[0].type_ = GetType();
+    types[0].instances_.Push(const_cast<Scene*>(this));
+    types[1].type_ = Node::GetTypeStatic();
+
+    // Collect the nodes so that parents always precede their children, and the components of each type in node order
+    PODVector<Node*> nodes;
+    PODVector<unsigned> parentIndices;
+    nodes.Push(const_cast<Scene*>(this));
+    parentIndices.Push(0);
+    for (unsigned i = 0; i < nodes.Size(); ++i)
+    {
+        Node* node = nodes[i];
+        if (i)
+            types[1].instances_.Push(node);
+
+        const Vector<SharedPtr<Component> >& components = node->GetComponents();
+        for (unsigned j = 0; j < components.Size(); ++j)
+        {
+            Component* component = components[j];
+            HashMap<ShortStringHash, unsigned>::Iterator k = typeIndices.Find(component->GetType());
+            if (k == typeIndices.End())
+            {
+                k = typeIndices.Insert(MakePair(component->GetType(), types.Size()));
+                types.Resize(types.Size() + 1);
+                types.Back().type_ = component->GetType();
+            }
+            types[k->second_].instances_.Push(component);
+        }
+
+        const Vector<SharedPtr<Node> >& children = node->GetChildren();
+        for (unsigned j = 0; j < children.Size(); ++j)
+        {
+            if (children[j]->IsTemporary())
+                continue;
+            nodes.Push(children[j]);
+            parentIndices.Push(i);
+        }
+    }
+
+    VectorBuffer data;
+
+    // Write the attribute layout of each type. Types whose instances have their own attributes, such as script objects, do not have a fixed layout
+    data.WriteVLE(types.Size());
+    for (unsigned i = 0; i < types.Size(); ++i)
+    {
+        PackedType& type = types[i];
+        const Vector<AttributeInfo>* attributes = context_->GetAttributes(type.type_);
+        type.fixedLayout_ = true;
+        for (unsigned j = 0; j < type.instances_.Size(); ++j)
+        {
+            if (type.instances_[j]->GetAttributes() != attributes)
+            {
+                type.fixedLayout_ = false;
+                break;
+            }
+        }
+
+        data.WriteShortStringHash(type.type_);
+        data.WriteBool(type.fixedLayout_);
+        if (!type.fixedLayout_)
+            continue;
+
+        unsigned numAttributes = attributes ? attributes->Size() : 0;
+        unsigned numFileAttributes = 0;
+        for (unsigned j = 0; j < numAttributes; ++j)
+        {
+            if (attributes->At(j).mode_ & AM_FILE)
+                ++numFileAttributes;
+        }
+
+        data.WriteVLE(numFileAttributes);
+        for (unsigned j = 0; j < numAttributes; ++j)
+        {
+            const AttributeInfo& attr = attributes->At(j);
+            if (attr.mode_ & AM_FILE)
+            {
+                data.WriteString(attr.name_);
+                data.WriteUByte(attr.type_);
+            }
+        }
+    }
+
+    // Write the hierarchy along with the IDs and types of the components
+    data.WriteVLE(nodes.Size());
+    for (unsigned i = 0; i < nodes.Size(); ++i)
+    {
+        Node* node = nodes[i];
+        data.WriteUInt(node->GetID());
+        if (i)
+            data.WriteVLE(parentIndices[i]);
+
+        const Vector<SharedPtr<Component> >& components = node->GetComponents();
+        data.WriteVLE(components.Size());
+        for (unsigned j = 0; j < components.Size(); ++j)
+        {
+            Component* component = components[j];
+            data.WriteVLE(typeIndices[component->GetType()]);
+            data.WriteUInt(component->GetID());
+        }
+    }
+
+    // Write the attributes of all instances of each type contiguously. Each instance is prefixed with its size so that
+    // unknown types can be skipped
+    VectorBuffer instanceData;
+    for (unsigned i = 0; i < types.Size(); ++i)
+    {
+        PackedType& type = types[i];
+        for (unsigned j = 0; j < type.instances_.Size(); ++j)
+        {
+            instanceData.Clear();
+            if (!type.instances_[j]->Serializable::Save(instanceData))
+                return false;
+            data.WriteVLE(instanceData.GetSize());
+            data.Write(instanceData.GetData(), instanceData.GetSize());
+        }
+    }
+
+    unsigned dataSize = data.GetSize();
+    SharedArrayPtr<unsigned char> compressedData;
+    unsigned compressedSize = 0;
+    if (compress)
+    {
+        compressedData = new unsigned char[EstimateCompressBound(dataSize)];
+        compressedSize = CompressData(compressedData.Get(), data.GetData(), dataSize);
+    }
+
+    Deserializer* ptr = dynamic_cast<Deserializer*>(&dest);
+    if (ptr)
+        LOGINFO("Saving scene to " + ptr->GetName());
+
+    bool success = dest.WriteFileID("USCB");
+    success &= dest.WriteUInt(PACKED_SCENE_VERSION);
+    success &= dest.WriteUInt(compressedSize ? PACKED_SCENE_COMPRESSED : 0);
+    success &= dest.WriteUInt(dataSize);
+    if (compressedSize)
+    {
+        success &= dest.WriteUInt(compressedSize);
+        success &= dest.Write(compressedData.Get(), compressedSize) == compressedSize;
+    }
+    else
+        success &= dest.Write(data.GetData(), dataSize) == dataSize;
+
+    if (!success)
+    {
+        LOGERROR("Could not save scene, writing to stream failed");
+        return false;
+    }
+
+    FinishSaving(&dest);
+    return true;
+}
+
 bool Scene::LoadXML(const XMLElement& source, bool setInstanceDefault)
 {
     PROFILE(LoadSceneXML);
@@ -179,8 +427,9 @@ void Scene::AddReplicationState(NodeReplicationState* state)
     Node::AddReplicationState(state);
 
     // This is the first update for a new connection. Mark all replicated nodes dirty
-    for (HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
-        state->sceneState_->dirtyNodes_.Insert(i->first_);
+    const PODVector<unsigned>& nodeIDs = replicatedNodes_.GetKeys();
+    for (PODVector<unsigned>::ConstIterator i = nodeIDs.Begin(); i != nodeIDs.End(); ++i)
+        state->sceneState_->dirtyNodes_.Insert(*i);
 }
 
 bool Scene::LoadXML(Deserializer& source)
@@ -228,7 +477,7 @@ bool Scene::SaveXML(Serializer& dest) const
         return false;
 }
 
-bool Scene::LoadAsync(File* file)
+bool Scene::LoadAsync(File* file, XMLFile* manifest)
 {
     if (!file)
     {
@@ -239,7 +488,8 @@ bool Scene::LoadAsync(File* file)
     StopAsyncLoading();
 
     // Check ID
-    if (file->ReadFileID() != "USCN")
+    String fileID = file->ReadFileID();
+    if (fileID != "USCN" && fileID != "USCB")
     {
         LOGERROR(file->GetName() + " is not a valid scene file");
         return false;
@@ -249,13 +499,37 @@ bool Scene::LoadAsync(File* file)
 
     Clear();
 
+    // The packed format can not be loaded incrementally, but loads fast enough to be read at once. Only the manifest
+    // resources are then waited for in the async update
+    if (fileID == "USCB")
+    {
+        PreloadAsyncResources(manifest);
+        if (!LoadPacked(*file, resolver_))
+        {
+            StopAsyncLoading();
+            return false;
+        }
+
+        asyncLoading_ = true;
+        asyncProgress_.file_ = file;
+        asyncProgress_.loadedNodes_ = GetNumChildren();
+        asyncProgress_.totalNodes_ = GetNumChildren();
+        return true;
+    }
+
     // Store own old ID for resolving possible root node references
     unsigned nodeID = file->ReadUInt();
     resolver_.AddNode(nodeID, this);
 
+    // Start loading the manifest resources in the background so that they overlap with node creation
+    PreloadAsyncResources(manifest);
+
     // Load root level components first
     if (!Node::Load(*file, resolver_, false))
+    {
+        StopAsyncLoading();
         return false;
+    }
 
     // Then prepare for loading all root level child nodes in the async update
     asyncLoading_ = true;
@@ -266,7 +540,7 @@ bool Scene::LoadAsync(File* file)
     return true;
 }
 
-bool Scene::LoadAsyncXML(File* file)
+bool Scene::LoadAsyncXML(File* file, XMLFile* manifest)
 {
     if (!file)
     {
@@ -290,9 +564,15 @@ bool Scene::LoadAsyncXML(File* file)
     unsigned nodeID = rootElement.GetInt("id");
     resolver_.AddNode(nodeID, this);
 
+    // Start loading the manifest resources in the background so that they overlap with node creation
+    PreloadAsyncResources(manifest);
+
     // Load the root level components first
     if (!Node::LoadXML(rootElement, resolver_, false))
+    {
+        StopAsyncLoading();
         return false;
+    }
 
     // Then prepare for loading all root level child nodes in the async update
     XMLElement childNodeElement = rootElement.GetChild("node");
@@ -319,7 +599,11 @@ void Scene::StopAsyncLoading()
     asyncProgress_.file_.Reset();
     asyncProgress_.xmlFile_.Reset();
     asyncProgress_.xmlElement_ = XMLElement::EMPTY;
+    asyncProgress_.resources_.Clear();
+    asyncProgress_.loadedResources_ = 0;
+    asyncProgress_.totalResources_ = 0;
     resolver_.Reset();
+    UnsubscribeFromEvent(E_RESOURCEBACKGROUNDLOADED);
 }
 
 Node* Scene::Instantiate(Deserializer& source, const Vector3& position, const Quaternion& rotation, CreateMode mode)
@@ -377,6 +661,23 @@ Node* Scene::InstantiateXML(Deserializer& source, const Vector3& position, const
     return InstantiateXML(xml->GetRoot(), position, rotation, mode);
 }
 
+Node* Scene::InstantiatePrefab(Prefab* prefab, const Vector3& position, const Quaternion& rotation, CreateMode mode)
+{
+    PODVector<Node*> nodes;
+    return InstantiatePrefab(nodes, prefab, 1, position, rotation, mode) ? nodes[0] : 0;
+}
+
+unsigned Scene::InstantiatePrefab(PODVector<Node*>& dest, Prefab* prefab, unsigned count, const Vector3& position, const Quaternion& rotation, CreateMode mode)
+{
+    if (!prefab)
+    {
+        LOGERROR("Null prefab for instantiation");
+        return 0;
+    }
+
+    return prefab->Instantiate(dest, this, count, position, rotation, mode);
+}
+
 void Scene::Clear()
 {
     StopAsyncLoading();
@@ -390,6 +691,16 @@ void Scene::Clear()
     replicatedComponentID_ = FIRST_REPLICATED_ID;
     localNodeID_ = FIRST_LOCAL_ID;
     localComponentID_ = FIRST_LOCAL_ID;
+    fixedUpdateAcc_ = 0.0f;
+    fixedUpdateAlpha_ = 0.0f;
+    lowPriorityTimeAcc_ = 0.0f;
+    fixedTick_ = 0;
+
+    if (journal_)
+    {
+        journal_->Clear();
+        journal_->CalculateHash(this);
+    }
 }
 
 void Scene::SetUpdateEnabled(bool enable)
@@ -415,6 +726,58 @@ void Scene::SetSnapThreshold(float threshold)
     Node::MarkNetworkUpdate();
 }
 
+void Scene::SetTransformBatching(bool enable)
+{
+    if (enable == transformBatching_)
+        return;
+
+    // Notify the listeners of any nodes still waiting when batching is disabled
+    if (!enable)
+        UpdateTransforms();
+
+    transformBatching_ = enable;
+}
+
+void Scene::SetFixedUpdateFps(int fps)
+{
+    fixedUpdateFps_ = Clamp(fps, 0, 1000);
+    fixedUpdateAcc_ = 0.0f;
+    fixedUpdateAlpha_ = 0.0f;
+}
+
+void Scene::SetMaxFixedSteps(int steps)
+{
+    maxFixedSteps_ = Max(steps, 1);
+}
+
+void Scene::SetUpdateBudget(int msec)
+{
+    updateBudget_ = Max(msec, 0);
+}
+
+void Scene::SetJournalSize(unsigned size)
+{
+    if (!size)
+        journal_.Reset();
+    else if (!journal_)
+    {
+        journal_ = new AttributeJournal(size);
+        journal_->CalculateHash(this);
+    }
+    else
+        journal_->SetSize(size);
+}
+
+void Scene::UpdateTransforms()
+{
+    if (!transformStore_.GetNumNodes())
+        return;
+
+    PROFILE(UpdateTransforms);
+
+    transformStore_.Update(GetSubsystem<WorkQueue>());
+}
+
 void Scene::SetElapsedTime(float time)
 {
     elapsedTime_ = time;
@@ -451,50 +814,32 @@ void Scene::UnregisterAllVars()
 
 Node* Scene::GetNode(unsigned id) const
 {
-    if (id < FIRST_LOCAL_ID)
-    {
-        HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
-        if (i != replicatedNodes_.End())
-            return i->second_;
-        else
-            return 0;
-    }
-    else
-    {
-        HashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
-        if (i != localNodes_.End())
-            return i->second_;
-        else
-            return 0;
-    }
+    return id < FIRST_LOCAL_ID ? replicatedNodes_.Find(id) : localNodes_.Find(id);
 }
 
 Component* Scene::GetComponent(unsigned id) const
 {
-    if (id < FIRST_LOCAL_ID)
-    {
-        HashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
-        if (i != replicatedComponents_.End())
-            return i->second_;
-        else
-            return 0;
-    }
-    else
-    {
-        HashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
-        if (i != localComponents_.End())
-            return i->second_;
-        else
-            return 0;
-    }
+    return id < FIRST_LOCAL_ID ? replicatedComponents_.Find(id) : localComponents_.Find(id);
+}
+
+const PODVector<Component*>& Scene::GetComponentsOfType(ShortStringHash type) const
+{
+    static const PODVector<Component*> noComponents;
+
+    HashMap<ShortStringHash, PODVector<Component*> >::ConstIterator i = typeComponents_.Find(type);
+    return i != typeComponents_.End() ? i->second_ : noComponents;
 }
 
 float Scene::GetAsyncProgress() const
 {
-    if (!asyncLoading_ || !asyncProgress_.totalNodes_)
+    if (!asyncLoading_)
+        return 1.0f;
+
+    unsigned total = asyncProgress_.totalNodes_ + asyncProgress_.totalResources_;
+    if (!total)
         return 1.0f;
     else
-        return (float)asyncProgress_.loadedNodes_ / (float)asyncProgress_.totalNodes_;
+        return (float)(asyncProgress_.loadedNodes_ + asyncProgress_.loadedResources_) / (float)total;
 }
 
 const String& Scene::GetVarName(ShortStringHash hash) const
@@ -513,6 +858,7 @@ void Scene::Update(float timeStep)
 
     PROFILE(UpdateScene);
 
+    HiresTimer frameTimer;
     timeStep *= timeScale_;
 
     using namespace SceneUpdate;
@@ -524,16 +870,33 @@ void Scene::Update(float timeStep)
     // Update variable timestep logic
     SendEvent(E_SCENEUPDATE, eventData);
 
+    // Update fixed timestep logic
+    if (fixedUpdateFps_)
+        UpdateFixed(timeStep, frameTimer);
+
+    // Apply batched transform changes so that the subsystems see the moved nodes
+    UpdateTransforms();
+
     // Update scene subsystems. If a physics world is present, it will be updated, triggering fixed timestep logic updates
     SendEvent(E_SCENESUBSYSTEMUPDATE, eventData);
 
+    float constant = 1.0f - Clamp(powf(2.0f, -timeStep * smoothingConstant_), 0.0f, 1.0f);
+    float squaredSnapThreshold = snapThreshold_ * snapThreshold_;
+
+    // Update thread-safe components, for example the transform smoothing of network replicated nodes
+    {
+        SceneUpdateInfo info;
+        info.scene_ = this;
+        info.timeStep_ = timeStep;
+        info.smoothingConstant_ = constant;
+        info.squaredSnapThreshold_ = squaredSnapThreshold;
+        UpdateThreadedComponents(info);
+    }
+
     // Update transform smoothing
     {
         PROFILE(UpdateSmoothing);
 
-        float constant = 1.0f - Clamp(powf(2.0f, -timeStep * smoothingConstant_), 0.0f, 1.0f);
-        float squaredSnapThreshold = snapThreshold_ * snapThreshold_;
-
         using namespace UpdateSmoothing;
 
         VariantMap eventData;
@@ -545,12 +908,79 @@ void Scene::Update(float timeStep)
     // Post-update variable timestep logic
     SendEvent(E_SCENEPOSTUPDATE, eventData);
 
+    UpdateLowPriority(timeStep, frameTimer);
+
+    UpdateTransforms();
+
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
     // SetElapsedTime()
     elapsedTime_ += timeStep;
 }
 
+void Scene::UpdateFixed(float timeStep, HiresTimer& frameTimer)
+{
+    PROFILE(UpdateFixed);
+
+    float interval = 1.0f / fixedUpdateFps_;
+    fixedUpdateAcc_ += timeStep;
+
+    // If more updates are due than allowed per frame, drop the excess time so that the update does not fall further
+    // behind under sustained load
+    float maxAcc = interval * (maxFixedSteps_ + 1);
+    if (fixedUpdateAcc_ >= maxAcc)
+    {
+        unsigned numDropped = (unsigned)((fixedUpdateAcc_ - maxAcc) / interval) + 1;
+        numDroppedFixedSteps_ += numDropped;
+        // Guard against rounding leaving less than the allowed number of updates
+        fixedUpdateAcc_ = Max(fixedUpdateAcc_ - numDropped * interval, maxFixedSteps_ * interval);
+    }
+
+    using namespace SceneFixedUpdate;
+
+    VariantMap eventData;
+    eventData[P_SCENE] = (void*)this;
+    eventData[P_TIMESTEP] = interval;
+
+    unsigned numSteps = 0;
+    long long budget = updateBudget_ * 1000LL;
+
+    while (fixedUpdateAcc_ >= interval)
+    {
+        // If over the budget, postpone the rest of the updates to the next frame. Always perform at least one
+        if (numSteps && budget && frameTimer.GetUSec(false) >= budget)
+            break;
+
+        eventData[P_TICK] = fixedTick_;
+        SendEvent(E_SCENEFIXEDUPDATE, eventData);
+        SendEvent(E_SCENEFIXEDPOSTUPDATE, eventData);
+
+        fixedUpdateAcc_ -= interval;
+        ++fixedTick_;
+        ++numSteps;
+    }
+
+    fixedUpdateAlpha_ = Min(fixedUpdateAcc_ / interval, 1.0f);
+}
+
+void Scene::UpdateLowPriority(float timeStep, HiresTimer& frameTimer)
+{
+    lowPriorityTimeAcc_ += timeStep;
+
+    // Defer if over the budget, but not indefinitely
+    if (updateBudget_ && frameTimer.GetUSec(false) >= updateBudget_ * 1000LL && lowPriorityTimeAcc_ < MAX_LOW_PRIORITY_DELAY)
+        return;
+
+    using namespace SceneLowPriorityUpdate;
+
+    VariantMap eventData;
+    eventData[P_SCENE] = (void*)this;
+    eventData[P_TIMESTEP] = lowPriorityTimeAcc_;
+    lowPriorityTimeAcc_ = 0.0f;
+
+    SendEvent(E_SCENELOWPRIORITYUPDATE, eventData);
+}
+
 void Scene::BeginThreadedUpdate()
 {
     // Check the work queue subsystem whether it actually has created worker threads. If not, do not enter threaded mode.
@@ -573,6 +1003,28 @@ void Scene::EndThreadedUpdate()
             (*i)->OnMarkedDirty((*i)->GetNode());
         delayedDirtyComponents_.Clear();
     }
+
+    for (PODVector<unsigned>::ConstIterator i = delayedNetworkUpdateNodes_.Begin(); i != delayedNetworkUpdateNodes_.End(); ++i)
+        networkUpdateNodes_.Insert(*i);
+    delayedNetworkUpdateNodes_.Clear();
+    for (PODVector<unsigned>::ConstIterator i = delayedNetworkUpdateComponents_.Begin(); i !=
+        delayedNetworkUpdateComponents_.End(); ++i)
+        networkUpdateComponents_.Insert(*i);
+    delayedNetworkUpdateComponents_.Clear();
+}
+
+void Scene::AddThreadedUpdate(Component* component)
+{
+    if (!component || component->threadedUpdateQueued_)
+        return;
+
+    threadedUpdateComponents_.Push(WeakPtr<Component>(component));
+    component->threadedUpdateQueued_ = true;
+}
+
+void Scene::QueueTransformUpdate(Node* node)
+{
+    transformStore_.AddNode(node);
 }
 
 void Scene::DelayedMarkedDirty(Component* component)
@@ -665,28 +1117,28 @@ void Scene::NodeAdded(Node* node)
     unsigned id = node->GetID();
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
-        if (i != replicatedNodes_.End() && i->second_ != node)
+        Node* existing = replicatedNodes_.Find(id);
+        if (existing && existing != node)
         {
             LOGWARNING("Overwriting node with ID " + String(id));
-            i->second_->ResetScene();
+            existing->ResetScene();
         }
 
-        replicatedNodes_[id] = node;
+        replicatedNodes_.Insert(id, node);
 
         MarkNetworkUpdate(node);
         MarkReplicationDirty(node);
     }
     else
     {
-        HashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
-        if (i != localNodes_.End() && i->second_ != node)
+        Node* existing = localNodes_.Find(id);
+        if (existing && existing != node)
         {
             LOGWARNING("Overwriting node with ID " + String(id));
-            i->second_->ResetScene();
+            existing->ResetScene();
         }
 
-        localNodes_[id] = node;
+        localNodes_.Insert(id, node);
     }
 }
 
@@ -704,6 +1156,7 @@ void Scene::NodeRemoved(Node* node)
     else
         localNodes_.Erase(id);
 
+    transformStore_.RemoveNode(node);
     node->SetID(0);
     node->SetScene(0);
 }
@@ -716,26 +1169,33 @@ void Scene::ComponentAdded(Component* component)
     unsigned id = component->GetID();
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
-        if (i != replicatedComponents_.End() && i->second_ != component)
+        Component* existing = replicatedComponents_.Find(id);
+        if (existing && existing != component)
         {
             LOGWARNING("Overwriting component with ID " + String(id));
-            i->second_->SetID(0);
+            existing->SetID(0);
         }
 
-        replicatedComponents_[id] = component;
+        replicatedComponents_.Insert(id, component);
     }
     else
     {
-        HashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
-        if (i != localComponents_.End() && i->second_ != component)
+        Component* existing = localComponents_.Find(id);
+        if (existing && existing != component)
         {
             LOGWARNING("Overwriting component with ID " + String(id));
-            i->second_->SetID(0);
+            existing->SetID(0);
         }
 
-        localComponents_[id] = component;
+        localComponents_.Insert(id, component);
     }
+
+    PODVector<Component*>& components = typeComponents_[component->GetType()];
+    component->typeIndex_ = components.Size();
+    components.Push(component);
+
+    if (component->threadedUpdate_)
+        AddThreadedUpdate(component);
 }
 
 void Scene::ComponentRemoved(Component* component)
@@ -749,6 +1209,27 @@ void Scene::ComponentRemoved(Component* component)
     else
         localComponents_.Erase(id);
 
+    // Remove from the type list by moving the last component of the same type into its place
+    HashMap<ShortStringHash, PODVector<Component*> >::Iterator i = typeComponents_.Find(component->GetType());
+    if (i != typeComponents_.End())
+    {
+        PODVector<Component*>& components = i->second_;
+        unsigned index = component->typeIndex_;
+        if (index < components.Size() && components[index] == component)
+        {
+            Component* last = components.Back();
+            components[index] = last;
+            last->typeIndex_ = index;
+            components.Pop();
+        }
+    }
+
+    if (component->threadedUpdateQueued_)
+    {
+        threadedUpdateComponents_.Remove(WeakPtr<Component>(component));
+        component->threadedUpdateQueued_ = false;
+    }
+
     component->SetID(0);
 }
 
@@ -800,22 +1281,41 @@ void Scene::CleanupConnection(Connection* connection)
 {
     Node::CleanupConnection(connection);
 
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
-        i->second_->CleanupConnection(connection);
+    const PODVector<Node*>& nodes = replicatedNodes_.GetValues();
+    for (PODVector<Node*>::ConstIterator i = nodes.Begin(); i != nodes.End(); ++i)
+        (*i)->CleanupConnection(connection);
 
-    for (HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
-        i->second_->CleanupConnection(connection);
+    const PODVector<Component*>& components = replicatedComponents_.GetValues();
+    for (PODVector<Component*>::ConstIterator i = components.Begin(); i != components.End(); ++i)
+        (*i)->CleanupConnection(connection);
 }
 
 void Scene::MarkNetworkUpdate(Node* node)
 {
-    if (node)
+    if (!node)
+        return;
+
+    // During threaded update the hash set can not be modified from several threads, so queue the ID for later
+    if (threadedUpdate_)
+    {
+        MutexLock lock(sceneMutex_);
+        delayedNetworkUpdateNodes_.Push(node->GetID());
+    }
+    else
         networkUpdateNodes_.Insert(node->GetID());
 }
 
 void Scene::MarkNetworkUpdate(Component* component)
 {
-    if (component)
+    if (!component)
+        return;
+
+    if (threadedUpdate_)
+    {
+        MutexLock lock(sceneMutex_);
+        delayedNetworkUpdateComponents_.Push(component->GetID());
+    }
+    else
         networkUpdateComponents_.Insert(component->GetID());
 }
 
@@ -842,6 +1342,14 @@ void Scene::HandleUpdate(StringHash eventType, VariantMap& eventData)
         Update(eventData[P_TIMESTEP].GetFloat());
 }
 
+void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    if (asyncProgress_.resources_.Erase(StringHash(eventData[P_RESOURCENAME].GetString())))
+        ++asyncProgress_.loadedResources_;
+}
+
 void Scene::UpdateAsyncLoading()
 {
     PROFILE(UpdateAsyncLoading);
@@ -852,8 +1360,21 @@ void Scene::UpdateAsyncLoading()
     {
         if (asyncProgress_.loadedNodes_ >= asyncProgress_.totalNodes_)
         {
-            FinishAsyncLoading();
-            return;
+            // If the resource cache has nothing left to load, do not wait for the remaining manifest resources
+            if (!asyncProgress_.resources_.Empty() && !GetSubsystem<ResourceCache>()->GetNumBackgroundLoadResources())
+            {
+                asyncProgress_.loadedResources_ += asyncProgress_.resources_.Size();
+                asyncProgress_.resources_.Clear();
+            }
+
+            // Wait for the manifest resources to finish before finishing the scene
+            if (asyncProgress_.resources_.Empty())
+            {
+                FinishAsyncLoading();
+                return;
+            }
+            else
+                break;
         }
 
         // Read one child node with its full sub-hierarchy either from binary or XML
@@ -884,12 +1405,29 @@ void Scene::UpdateAsyncLoading()
 
     VariantMap eventData;
     eventData[P_SCENE] = (void*)this;
-    eventData[P_PROGRESS] = (float)asyncProgress_.loadedNodes_ / (float)asyncProgress_.totalNodes_;
+    eventData[P_PROGRESS] = GetAsyncProgress();
     eventData[P_LOADEDNODES]  = asyncProgress_.loadedNodes_;
     eventData[P_TOTALNODES]  = asyncProgress_.totalNodes_;
+    eventData[P_LOADEDRESOURCES]  = asyncProgress_.loadedResources_;
+    eventData[P_TOTALRESOURCES]  = asyncProgress_.totalResources_;
     SendEvent(E_ASYNCLOADPROGRESS, eventData);
 }
 
+void Scene::PreloadAsyncResources(XMLFile* manifest)
+{
+    if (!manifest)
+        return;
+
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    if (!cache)
+        return;
+
+    // Subscribe first, as resources requested by the root components may finish immediately
+    SubscribeToEvent(cache, E_RESOURCEBACKGROUNDLOADED, HANDLER(Scene, HandleResourceBackgroundLoaded));
+    asyncProgress_.loadedResources_ = 0;
+    asyncProgress_.totalResources_ = cache->PreloadManifest(manifest, &asyncProgress_.resources_);
+}
+
 void Scene::FinishAsyncLoading()
 {
     resolver_.Resolve();
@@ -904,6 +1442,306 @@ void Scene::FinishAsyncLoading()
     SendEvent(E_ASYNCLOADFINISHED, eventData);
 }
 
+void Scene::UpdateThreadedComponents(const SceneUpdateInfo& info)
+{
+    if (threadedUpdateComponents_.Empty())
+        return;
+
+    PROFILE(UpdateThreadedComponents);
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue->GetNumThreads() && threadedUpdateComponents_.Size() > COMPONENTS_PER_WORK_ITEM)
+    {
+        // Delay the dirty processing of components that are not thread-safe, for example physics, to the end
+        BeginThreadedUpdate();
+
+        WorkItem item;
+        item.workFunction_ = UpdateComponentsWork;
+        item.aux_ = const_cast<SceneUpdateInfo*>(&info);
+
+        Vector<WeakPtr<Component> >::Iterator start = threadedUpdateComponents_.Begin();
+        while (start != threadedUpdateComponents_.End())
+        {
+            Vector<WeakPtr<Component> >::Iterator end = threadedUpdateComponents_.End();
+            if (end - start > COMPONENTS_PER_WORK_ITEM)
+                end = start + COMPONENTS_PER_WORK_ITEM;
+
+            item.start_ = &(*start);
+            item.end_ = &(*end);
+            queue->AddWorkItem(item);
+
+            start = end;
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+        EndThreadedUpdate();
+    }
+    else
+    {
+        // Components may not add or remove other components during the update, so the list can be iterated directly
+        for (unsigned i = 0; i < threadedUpdateComponents_.Size(); ++i)
+        {
+            Component* component = threadedUpdateComponents_[i];
+            if (component && component->threadedUpdate_)
+                component->ThreadedUpdate(info);
+        }
+    }
+
+    // Remove the components that have expired or disabled threaded update
+    unsigned numKept = 0;
+    for (unsigned i = 0; i < threadedUpdateComponents_.Size(); ++i)
+    {
+        Component* component = threadedUpdateComponents_[i];
+        if (component && component->threadedUpdate_)
+        {
+            if (numKept != i)
+                threadedUpdateComponents_[numKept] = threadedUpdateComponents_[i];
+            ++numKept;
+        }
+        else if (component)
+            component->threadedUpdateQueued_ = false;
+    }
+    threadedUpdateComponents_.Resize(numKept);
+}
+
+bool Scene::LoadPacked(Deserializer& source, SceneResolver& resolver, bool setInstanceDefault)
+{
+    PROFILE(LoadPackedScene);
+
+    unsigned version = source.ReadUInt();
+    unsigned flags = source.ReadUInt();
+    unsigned dataSize = source.ReadUInt();
+    if (version > PACKED_SCENE_VERSION)
+    {
+        LOGERROR("Unsupported packed scene version " + String(version) + " in " + source.GetName());
+        return false;
+    }
+
+    // Check the sizes before allocating, as they come from the file
+    bool compressed = (flags & PACKED_SCENE_COMPRESSED) != 0;
+    unsigned compressedSize = compressed ? source.ReadUInt() : dataSize;
+    if (dataSize > MAX_PACKED_SCENE_SIZE || compressedSize > source.GetSize() - source.GetPosition())
+    {
+        LOGERROR("Corrupt scene data in " + source.GetName());
+        return false;
+    }
+
+    // Read and decompress all the data at once
+    SharedArrayPtr<unsigned char> dataBuffer(new unsigned char[dataSize]);
+    if (compressed)
+    {
+        SharedArrayPtr<unsigned char> compressedData(new unsigned char[compressedSize]);
+        if (source.Read(compressedData.Get(), compressedSize) != compressedSize || DecompressData(dataBuffer.Get(),
+            compressedData.Get(), dataSize, compressedSize) != dataSize)
+        {
+            LOGERROR("Could not decompress scene data from " + source.GetName());
+            return false;
+        }
+    }
+    else if (source.Read(dataBuffer.Get(), dataSize) != dataSize)
+    {
+        LOGERROR("Could not read scene data from " + source.GetName());
+        return false;
+    }
+
+    MemoryBuffer data(dataBuffer.Get(), dataSize);
+
+    // Read the saved attribute layouts and compare them to the currently registered attributes
+    unsigned numTypes = data.ReadVLE();
+    if (numTypes < 2 || numTypes > dataSize)
+    {
+        LOGERROR("Corrupt scene data in " + source.GetName());
+        return false;
+    }
+
+    Vector<PackedType> types(numTypes);
+    for (unsigned i = 0; i < numTypes; ++i)
+    {
+        PackedType& type = types[i];
+        type.type_ = data.ReadShortStringHash();
+        type.fixedLayout_ = data.ReadBool();
+        if (!type.fixedLayout_)
+            continue;
+
+        unsigned numSavedAttributes = data.ReadVLE();
+        if (numSavedAttributes > dataSize)
+        {
+            LOGERROR("Corrupt scene data in " + source.GetName());
+            return false;
+        }
+
+        for (unsigned j = 0; j < numSavedAttributes; ++j)
+        {
+            type.names_.Push(data.ReadString());
+            type.types_.Push((VariantType)data.ReadUByte());
+        }
+
+        const Vector<AttributeInfo>* attributes = context_->GetAttributes(type.type_);
+        unsigned numAttributes = attributes ? attributes->Size() : 0;
+        unsigned savedIndex = 0;
+        for (unsigned j = 0; j < numAttributes; ++j)
+        {
+            const AttributeInfo& attr = attributes->At(j);
+            if (!(attr.mode_ & AM_FILE))
+                continue;
+
+            if (savedIndex < numSavedAttributes && type.names_[savedIndex] == attr.name_ && type.types_[savedIndex] == attr.type_)
+                type.remap_.Push(savedIndex);
+            else
+            {
+                type.sameLayout_ = false;
+                unsigned index = type.names_.Find(attr.name_) - type.names_.Begin();
+                type.remap_.Push(index < numSavedAttributes && type.types_[index] == attr.type_ ? index : M_MAX_UNSIGNED);
+            }
+            ++savedIndex;
+        }
+        if (savedIndex != numSavedAttributes)
+            type.sameLayout_ = false;
+    }
+
+    // Create the nodes and components with their original IDs. Check whether any IDs had to be changed
+    unsigned numNodes = data.ReadVLE();
+    if (numNodes > dataSize)
+    {
+        LOGERROR("Corrupt scene data in " + source.GetName());
+        return false;
+    }
+
+    PODVector<Node*> nodes(numNodes);
+    PODVector<unsigned> nodeIDs(numNodes);
+    PODVector<Component*> components;
+    PODVector<unsigned> componentIDs;
+    bool changedIDs = false;
+
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        unsigned nodeID = data.ReadUInt();
+        Node* node = this;
+        if (i)
+        {
+            unsigned parentIndex = data.ReadVLE();
+            if (parentIndex >= i)
+            {
+                LOGERROR("Corrupt scene data in " + source.GetName());
+                return false;
+            }
+            node = nodes[parentIndex]->CreateChild(nodeID, nodeID < FIRST_LOCAL_ID ? REPLICATED : LOCAL);
+            types[1].instances_.Push(node);
+        }
+        else
+            types[0].instances_.Push(node);
+
+        nodes[i] = node;
+        nodeIDs[i] = nodeID;
+        if (node->GetID() != nodeID)
+            changedIDs = true;
+
+        unsigned numComponents = data.ReadVLE();
+        for (unsigned j = 0; j < numComponents; ++j)
+        {
+            unsigned typeIndex = data.ReadVLE();
+            unsigned compID = data.ReadUInt();
+            if (typeIndex < 2 || typeIndex >= numTypes)
+            {
+                LOGERROR("Corrupt scene data in " + source.GetName());
+                return false;
+            }
+
+            Component* newComponent = node->CreateComponent(types[typeIndex].type_, compID < FIRST_LOCAL_ID ? REPLICATED : LOCAL,
+                compID);
+            types[typeIndex].instances_.Push(newComponent);
+            if (newComponent)
+            {
+                components.Push(newComponent);
+                componentIDs.Push(compID);
+                if (newComponent->GetID() != compID)
+                    changedIDs = true;
+            }
+        }
+    }
+
+    // Node and component ID attributes only need to be resolved if some of the IDs were already in use
+    if (changedIDs)
+    {
+        for (unsigned i = 0; i < nodes.Size(); ++i)
+            resolver.AddNode(nodeIDs[i], nodes[i]);
+        for (unsigned i = 0; i < components.Size(); ++i)
+            resolver.AddComponent(componentIDs[i], components[i]);
+    }
+
+    // Set the attributes one type at a time
+    Vector<Variant> savedValues;
+    VectorBuffer remappedData;
+    for (unsigned i = 0; i < numTypes; ++i)
+    {
+        PackedType& type = types[i];
+        const Vector<AttributeInfo>* attributes = context_->GetAttributes(type.type_);
+        unsigned numAttributes = attributes ? attributes->Size() : 0;
+
+        for (unsigned j = 0; j < type.instances_.Size(); ++j)
+        {
+            unsigned size = data.ReadVLE();
+            unsigned start = data.GetPosition();
+            if (start + size > dataSize)
+            {
+                LOGERROR("Corrupt scene data in " + source.GetName());
+                return false;
+            }
+
+            // Skip objects that could not be created
+            Serializable* instance = type.instances_[j];
+            if (!instance)
+            {
+                data.Seek(start + size);
+                continue;
+            }
+
+            MemoryBuffer instanceData(dataBuffer.Get() + start, size);
+            Deserializer* attrSource = &instanceData;
+
+            // If attributes have been added, removed or reordered since saving, rewrite the data in the current layout
+            if (type.fixedLayout_ && !type.sameLayout_)
+            {
+                savedValues.Resize(type.types_.Size());
+                for (unsigned k = 0; k < type.types_.Size(); ++k)
+                    savedValues[k] = instanceData.ReadVariant(type.types_[k]);
+
+                remappedData.Clear();
+                unsigned fileIndex = 0;
+                for (unsigned k = 0; k < numAttributes; ++k)
+                {
+                    const AttributeInfo& attr = attributes->At(k);
+                    if (!(attr.mode_ & AM_FILE))
+                        continue;
+
+                    unsigned savedIndex = type.remap_[fileIndex++];
+                    if (savedIndex != M_MAX_UNSIGNED)
+                        remappedData.WriteVariantData(savedValues[savedIndex]);
+                    else
+                    {
+                        Variant value;
+                        instance->OnGetAttribute(attr, value);
+                        remappedData.WriteVariantData(value);
+                    }
+                }
+
+                remappedData.Seek(0);
+                attrSource = &remappedData;
+            }
+
+            // Node::Load would also read the child nodes, so use the base class implementation for the nodes
+            if (i < 2)
+                instance->Serializable::Load(*attrSource, setInstanceDefault);
+            else
+                instance->Load(*attrSource, setInstanceDefault);
+
+            data.Seek(start + size);
+        }
+    }
+
+    return true;
+}
+
 void Scene::FinishLoading(Deserializer* source)
 {
     if (source)
@@ -911,6 +1749,13 @@ void Scene::FinishLoading(Deserializer* source)
         fileName_ = source->GetName();
         checksum_ = source->GetChecksum();
     }
+
+    // The loaded attributes were not recorded, so recalculate the hash from scratch
+    if (journal_)
+    {
+        journal_->Clear();
+        journal_->CalculateHash(this);
+    }
 }
 
 void Scene::FinishSaving(Serializer* dest) const
@@ -927,7 +1772,9 @@ void RegisterSceneLibrary(Context* context)
 {
     Node::RegisterObject(context);
     Scene::RegisterObject(context);
+    Prefab::RegisterObject(context);
     SmoothedTransform::RegisterObject(context);
+    WorldPartition::RegisterObject(context);
 }
 
 }
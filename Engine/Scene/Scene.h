@@ -22,17 +22,24 @@
 
 #pragma once
 
+#include "AttributeJournal.h"
 #include "HashSet.h"
 #include "Mutex.h"
 #include "Node.h"
 #include "SceneResolver.h"
+#include "SlotMap.h"
+#include "TransformStore.h"
 #include "XMLElement.h"
 
 namespace Urho3D
 {
 
 class File;
+class HiresTimer;
 class PackageFile;
+class Prefab;
+
+struct SceneUpdateInfo;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
 static const unsigned LAST_REPLICATED_ID = 0xffffff;
@@ -52,6 +59,12 @@ struct AsyncProgress
     unsigned loadedNodes_;
     /// Total root-level nodes.
     unsigned totalNodes_;
+    /// Resources from the preload manifest still being loaded in the background.
+    HashSet<StringHash> resources_;
+    /// Loaded preload manifest resources.
+    unsigned loadedResources_;
+    /// Total preload manifest resources.
+    unsigned totalResources_;
 };
 
 /// Root scene node, represents the whole scene.
@@ -83,10 +96,12 @@ public:
     bool LoadXML(Deserializer& source);
     /// Save to an XML file. Return true if successful.
     bool SaveXML(Serializer& dest) const;
-    /// Load from a binary file asynchronously. Return true if started successfully.
-    bool LoadAsync(File* file);
-    /// Load from an XML file asynchronously. Return true if started successfully.
-    bool LoadAsyncXML(File* file);
+    /// Save to the packed binary format, which stores the attributes of each object type contiguously and loads faster. Optionally compress the data. Return true if successful.
+    bool SavePacked(Serializer& dest, bool compress = true) const;
+    /// Load from a binary file asynchronously. Optionally preload the resources listed in a manifest in the background. Return true if started successfully.
+    bool LoadAsync(File* file, XMLFile* manifest = 0);
+    /// Load from an XML file asynchronously. Optionally preload the resources listed in a manifest in the background. Return true if started successfully.
+    bool LoadAsyncXML(File* file, XMLFile* manifest = 0);
     /// Stop asynchronous loading.
     void StopAsyncLoading();
     /// Instantiate scene content from binary data. Return root node if successful.
@@ -95,6 +110,10 @@ public:
     Node* InstantiateXML(const XMLElement& source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
     /// Instantiate scene content from XML data. Return root node if successful.
     Node* InstantiateXML(Deserializer& source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
+    /// Instantiate a prefab. Return root node if successful.
+    Node* InstantiatePrefab(Prefab* prefab, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
+    /// Instantiate a prefab several times at the same position. Append the root nodes to the destination vector. Return number of instances created.
+    unsigned InstantiatePrefab(PODVector<Node*>& dest, Prefab* prefab, unsigned count, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
     /// Clear scene completely of nodes and components.
     void Clear();
     /// Enable or disable scene update.
@@ -107,6 +126,18 @@ public:
     void SetSmoothingConstant(float constant);
     /// Set network client motion smoothing snap threshold.
     void SetSnapThreshold(float threshold);
+    /// Enable or disable batched transform updates. When enabled, listener components of moved nodes are notified when the transforms are updated as a batch, instead of immediately. The physics world updates the batch before each simulation step.
+    void SetTransformBatching(bool enable);
+    /// Set fixed timestep update rate. Zero (default) disables the fixed timestep update events.
+    void SetFixedUpdateFps(int fps);
+    /// Set maximum number of fixed timestep updates per frame. Time in excess of this is dropped so that the update can recover from load spikes.
+    void SetMaxFixedSteps(int steps);
+    /// Set scene update time budget per frame in milliseconds. When exceeded, further fixed timestep updates are postponed to the next frame and the low-priority update is deferred. Zero (default) is unlimited.
+    void SetUpdateBudget(int msec);
+    /// Update the batched transforms now and notify listener components.
+    void UpdateTransforms();
+    /// Set size of the attribute change journal. Zero (default) disables the journal.
+    void SetJournalSize(unsigned size);
     /// Add a required package file for networking. To be called on the server.
     void AddRequiredPackageFile(PackageFile* package);
     /// Clear required package files.
@@ -122,6 +153,10 @@ public:
     Node* GetNode(unsigned id) const;
     /// Return component from the whole scene by ID, or null if not found.
     Component* GetComponent(unsigned id) const;
+    /// Return all components of a type from the whole scene, in unspecified order. Includes components of nodes that have been removed from the hierarchy, but not yet destroyed.
+    const PODVector<Component*>& GetComponentsOfType(ShortStringHash type) const;
+    /// Template version of returning all components of a type from the whole scene.
+    template <class T> void GetComponentsOfType(PODVector<T*>& dest) const;
     /// Return whether updates are enabled.
     bool IsUpdateEnabled() const { return updateEnabled_; }
     /// Return asynchronous loading flag.
@@ -140,6 +175,26 @@ public:
     float GetSmoothingConstant() const { return smoothingConstant_; }
     /// Return motion smoothing snap threshold.
     float GetSnapThreshold() const { return snapThreshold_; }
+    /// Return whether transform updates are batched.
+    bool GetTransformBatching() const { return transformBatching_; }
+    /// Return fixed timestep update rate.
+    int GetFixedUpdateFps() const { return fixedUpdateFps_; }
+    /// Return maximum number of fixed timestep updates per frame.
+    int GetMaxFixedSteps() const { return maxFixedSteps_; }
+    /// Return scene update time budget per frame in milliseconds.
+    int GetUpdateBudget() const { return updateBudget_; }
+    /// Return fractional progress from the last fixed timestep update to the next, for interpolating rendered positions.
+    float GetFixedUpdateAlpha() const { return fixedUpdateAlpha_; }
+    /// Return number of fixed timestep updates performed.
+    unsigned GetFixedTick() const { return fixedTick_; }
+    /// Return number of fixed timestep updates dropped due to the per-frame limit.
+    unsigned GetNumDroppedFixedSteps() const { return numDroppedFixedSteps_; }
+    /// Return number of nodes waiting for a batched transform update.
+    unsigned GetNumQueuedTransforms() const { return transformStore_.GetNumNodes(); }
+    /// Return attribute change journal, or null if disabled.
+    AttributeJournal* GetJournal() const { return journal_; }
+    /// Return size of the attribute change journal.
+    unsigned GetJournalSize() const { return journal_ ? journal_->GetSize() : 0; }
     /// Return required package files.
     const Vector<SharedPtr<PackageFile> >& GetRequiredPackageFiles() const { return requiredPackageFiles_; }
     /// Return a node user variable name, or empty if not registered.
@@ -153,8 +208,12 @@ public:
     void EndThreadedUpdate();
     /// Add a component to the delayed dirty notify queue. Is thread-safe.
     void DelayedMarkedDirty(Component* component);
+    /// Add a component to the threaded update list. Not thread-safe.
+    void AddThreadedUpdate(Component* component);
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
+    /// Queue a dirty node for the batched transform update. Not thread-safe.
+    void QueueTransformUpdate(Node* node);
     /// Get free node ID, either non-local or local.
     unsigned GetFreeNodeID(CreateMode mode);
     /// Get free component ID, either non-local or local.
@@ -185,23 +244,39 @@ public:
 private:
     /// Handle the logic update event to update the scene, if active.
     void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle a background loaded resource during asynchronous loading.
+    void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
+    /// Queue the resources of a preload manifest for background loading at the start of asynchronous loading.
+    void PreloadAsyncResources(XMLFile* manifest);
     /// Update asynchronous loading.
     void UpdateAsyncLoading();
     /// Finish asynchronous loading.
     void FinishAsyncLoading();
-    /// Finish loading. Sets the scene filename and checksum.
+    /// Update the components that have threaded update enabled, using worker threads if available.
+    void UpdateThreadedComponents(const SceneUpdateInfo& info);
+    /// Send the fixed timestep update events that are due.
+    void UpdateFixed(float timeStep, HiresTimer& frameTimer);
+    /// Send the low-priority update event, unless over the update budget.
+    void UpdateLowPriority(float timeStep, HiresTimer& frameTimer);
+    /// Load the scene content from the packed binary format after the file ID has been read. Return true if successful.
+    bool LoadPacked(Deserializer& source, SceneResolver& resolver, bool setInstanceDefault = false);
+    /// Finish loading. Sets the scene filename and checksum, and recalculates the journal hash.
     void FinishLoading(Deserializer* source);
     /// Finish saving. Sets the scene filename and checksum.
     void FinishSaving(Serializer* dest) const;
 
     /// Replicated scene nodes by ID.
-    HashMap<unsigned, Node*> replicatedNodes_;
+    SlotMap<Node> replicatedNodes_;
     /// Local scene nodes by ID.
-    HashMap<unsigned, Node*> localNodes_;
+    SlotMap<Node> localNodes_;
     /// Replicated components by ID.
-    HashMap<unsigned, Component*> replicatedComponents_;
+    SlotMap<Component> replicatedComponents_;
     /// Local components by ID.
-    HashMap<unsigned, Component*> localComponents_;
+    SlotMap<Component> localComponents_;
+    /// Components by type.
+    HashMap<ShortStringHash, PODVector<Component*> > typeComponents_;
+    /// Attribute change journal.
+    SharedPtr<AttributeJournal> journal_;
     /// Asynchronous loading progress.
     AsyncProgress asyncProgress_;
     /// Node and component ID resolver for asynchronous loading.
@@ -218,8 +293,16 @@ private:
     HashSet<unsigned> networkUpdateComponents_;
     /// Delayed dirty notification queue for components.
     PODVector<Component*> delayedDirtyComponents_;
-    /// Mutex for the delayed dirty notification queue.
+    /// Nodes marked for network update during threaded update.
+    PODVector<unsigned> delayedNetworkUpdateNodes_;
+    /// Components marked for network update during threaded update.
+    PODVector<unsigned> delayedNetworkUpdateComponents_;
+    /// Components with threaded update enabled.
+    Vector<WeakPtr<Component> > threadedUpdateComponents_;
+    /// Mutex for the delayed dirty notification and network update queues.
     Mutex sceneMutex_;
+    /// Nodes waiting for a batched transform update.
+    TransformStore transformStore_;
     /// Next free non-local node ID.
     unsigned replicatedNodeID_;
     /// Next free non-local component ID.
@@ -238,14 +321,40 @@ private:
     float smoothingConstant_;
     /// Motion smoothing snap threshold.
     float snapThreshold_;
+    /// Fixed timestep update rate, or zero if disabled.
+    int fixedUpdateFps_;
+    /// Maximum number of fixed timestep updates per frame.
+    int maxFixedSteps_;
+    /// Update time budget per frame in milliseconds, or zero if unlimited.
+    int updateBudget_;
+    /// Fixed timestep update time accumulator.
+    float fixedUpdateAcc_;
+    /// Fixed timestep interpolation factor.
+    float fixedUpdateAlpha_;
+    /// Time accumulator for deferred low-priority updates.
+    float lowPriorityTimeAcc_;
+    /// Fixed timestep update counter.
+    unsigned fixedTick_;
+    /// Number of dropped fixed timestep updates.
+    unsigned numDroppedFixedSteps_;
     /// Update enabled flag.
     bool updateEnabled_;
     /// Asynchronous loading flag.
     bool asyncLoading_;
     /// Threaded update flag.
     bool threadedUpdate_;
+    /// Batched transform update flag.
+    bool transformBatching_;
 };
 
+template <class T> void Scene::GetComponentsOfType(PODVector<T*>& dest) const
+{
+    const PODVector<Component*>& components = GetComponentsOfType(T::GetTypeStatic());
+    dest.Resize(components.Size());
+    for (unsigned i = 0; i < components.Size(); ++i)
+        dest[i] = static_cast<T*>(components[i]);
+}
+
 /// Register Scene library objects.
 void RegisterSceneLibrary(Context* context);
 
@@ -34,6 +34,22 @@ EVENT(E_SCENEUPDATE, SceneUpdate)
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Fixed timestep scene update. Sent zero or more times per frame, after the variable timestep update.
+EVENT(E_SCENEFIXEDUPDATE, SceneFixedUpdate)
+{
+    PARAM(P_SCENE, Scene);                  // Scene pointer
+    PARAM(P_TIMESTEP, TimeStep);            // float
+    PARAM(P_TICK, Tick);                    // unsigned
+}
+
+/// Fixed timestep scene post-update.
+EVENT(E_SCENEFIXEDPOSTUPDATE, SceneFixedPostUpdate)
+{
+    PARAM(P_SCENE, Scene);                  // Scene pointer
+    PARAM(P_TIMESTEP, TimeStep);            // float
+    PARAM(P_TICK, Tick);                    // unsigned
+}
+
 /// Scene subsystem update.
 EVENT(E_SCENESUBSYSTEMUPDATE, SceneSubsystemUpdate)
 {
@@ -72,6 +88,13 @@ EVENT(E_SCENEPOSTUPDATE, ScenePostUpdate)
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Low-priority scene update, sent after the post-update. May be deferred to a later frame when the scene's update budget is exceeded, in which case the timestep covers all the deferred frames.
+EVENT(E_SCENELOWPRIORITYUPDATE, SceneLowPriorityUpdate)
+{
+    PARAM(P_SCENE, Scene);                  // Scene pointer
+    PARAM(P_TIMESTEP, TimeStep);            // float
+}
+
 /// Asynchronous scene loading progress.
 EVENT(E_ASYNCLOADPROGRESS, AsyncLoadProgress)
 {
@@ -79,6 +102,8 @@ EVENT(E_ASYNCLOADPROGRESS, AsyncLoadProgress)
     PARAM(P_PROGRESS, Progress);            // float
     PARAM(P_LOADEDNODES, LoadedNodes);      // int
     PARAM(P_TOTALNODES, TotalNodes);        // int
+    PARAM(P_LOADEDRESOURCES, LoadedResources); // int
+    PARAM(P_TOTALRESOURCES, TotalResources); // int
 };
 
 /// Asynchronous scene loading finished.
@@ -87,6 +112,22 @@ EVENT(E_ASYNCLOADFINISHED, AsyncLoadFinished)
     PARAM(P_SCENE, Scene);                  // Scene pointer
 };
 
+/// World partition cell finished loading.
+EVENT(E_WORLDCELLLOADED, WorldCellLoaded)
+{
+    PARAM(P_NODE, Node);                    // Node pointer
+    PARAM(P_X, X);                          // int
+    PARAM(P_Z, Z);                          // int
+};
+
+/// World partition cell is about to be unloaded.
+EVENT(E_WORLDCELLUNLOADED, WorldCellUnloaded)
+{
+    PARAM(P_NODE, Node);                    // Node pointer
+    PARAM(P_X, X);                          // int
+    PARAM(P_Z, Z);                          // int
+};
+
 /// A child node has been added to a parent node.
 EVENT(E_NODEADDED, NodeAdded)
 {
@@ -21,6 +21,7 @@
 //
 
 #include "Precompiled.h"
+#include "AttributeJournal.h"
 #include "Context.h"
 #include "Deserializer.h"
 #include "Log.h"
@@ -228,6 +229,79 @@ void Serializable::OnGetAttribute(const AttributeInfo& attr, Variant& dest) cons
     }
 }
 
+bool Serializable::AttributeEquals(const AttributeInfo& attr, const Variant& value) const
+{
+    // Check for accessor function mode
+    if (attr.accessor_)
+        return attr.accessor_->Equals(this, value);
+    
+    // Calculate the source address
+    const void* src = attr.ptr_ ? attr.ptr_ : reinterpret_cast<const unsigned char*>(this) + attr.offset_;
+    
+    switch (attr.type_)
+    {
+    case VAR_INT:
+        // If enum type, use the low 8 bits only
+        if (attr.enumNames_)
+            return value == (int)*(reinterpret_cast<const unsigned char*>(src));
+        else
+            return value == *(reinterpret_cast<const int*>(src));
+        
+    case VAR_BOOL:
+        return value == *(reinterpret_cast<const bool*>(src));
+        
+    case VAR_FLOAT:
+        return value == *(reinterpret_cast<const float*>(src));
+        
+    case VAR_VECTOR2:
+        return value == *(reinterpret_cast<const Vector2*>(src));
+        
+    case VAR_VECTOR3:
+        return value == *(reinterpret_cast<const Vector3*>(src));
+        
+    case VAR_VECTOR4:
+        return value == *(reinterpret_cast<const Vector4*>(src));
+        
+    case VAR_QUATERNION:
+        return value == *(reinterpret_cast<const Quaternion*>(src));
+        
+    case VAR_COLOR:
+        return value == *(reinterpret_cast<const Color*>(src));
+        
+    case VAR_STRING:
+        return value == *(reinterpret_cast<const String*>(src));
+        
+    case VAR_BUFFER:
+        return value == *(reinterpret_cast<const PODVector<unsigned char>*>(src));
+        
+    case VAR_RESOURCEREF:
+        return value == *(reinterpret_cast<const ResourceRef*>(src));
+        
+    case VAR_RESOURCEREFLIST:
+        return value == *(reinterpret_cast<const ResourceRefList*>(src));
+        
+    case VAR_VARIANTVECTOR:
+        return value == *(reinterpret_cast<const VariantVector*>(src));
+        
+    case VAR_VARIANTMAP:
+        return value == *(reinterpret_cast<const VariantMap*>(src));
+        
+    case VAR_INTRECT:
+        return value == *(reinterpret_cast<const IntRect*>(src));
+        
+    case VAR_INTVECTOR2:
+        return value == *(reinterpret_cast<const IntVector2*>(src));
+        
+    default:
+        {
+            // Compare other types, for example pointers, by getting the attribute into a variant
+            Variant current;
+            OnGetAttribute(attr, current);
+            return value == current;
+        }
+    }
+}
+
 const Vector<AttributeInfo>* Serializable::GetAttributes() const
 {
     return context_->GetAttributes(GetType());
@@ -280,9 +354,56 @@ bool Serializable::Save(Serializer& dest) const
         if (!(attr.mode_ & AM_FILE))
             continue;
 
-        OnGetAttribute(attr, value);
-
-        if (!dest.WriteVariantData(value))
+        bool success;
+        
+        // Write plain variables directly from memory, otherwise go through a variant
+        if (!attr.accessor_ && !attr.enumNames_)
+        {
+            const void* src = attr.ptr_ ? attr.ptr_ : reinterpret_cast<const unsigned char*>(this) + attr.offset_;
+            
+            switch (attr.type_)
+            {
+            case VAR_INT:
+                success = dest.WriteInt(*(reinterpret_cast<const int*>(src)));
+                break;
+                
+            case VAR_BOOL:
+                success = dest.WriteBool(*(reinterpret_cast<const bool*>(src)));
+                break;
+                
+            case VAR_FLOAT:
+                success = dest.WriteFloat(*(reinterpret_cast<const float*>(src)));
+                break;
+                
+            case VAR_VECTOR3:
+                success = dest.WriteVector3(*(reinterpret_cast<const Vector3*>(src)));
+                break;
+                
+            case VAR_QUATERNION:
+                success = dest.WriteQuaternion(*(reinterpret_cast<const Quaternion*>(src)));
+                break;
+                
+            case VAR_COLOR:
+                success = dest.WriteColor(*(reinterpret_cast<const Color*>(src)));
+                break;
+                
+            case VAR_STRING:
+                success = dest.WriteString(*(reinterpret_cast<const String*>(src)));
+                break;
+                
+            default:
+                OnGetAttribute(attr, value);
+                success = dest.WriteVariantData(value);
+                break;
+            }
+        }
+        else
+        {
+            OnGetAttribute(attr, value);
+            success = dest.WriteVariantData(value);
+        }
+        
+        if (!success)
         {
             LOGERROR("Could not save " + GetTypeName() + ", writing to stream failed");
             return false;
@@ -433,7 +554,11 @@ bool Serializable::SetAttribute(unsigned index, const Variant& value)
     // Check that the new value's type matches the attribute type
     if (value.GetType() == attr.type_)
     {
-        OnSetAttribute(attr, value);
+        AttributeJournal* journal = GetAttributeJournal();
+        if (journal)
+            SetAttributeRecorded(journal, attr, value);
+        else
+            OnSetAttribute(attr, value);
         return true;
     }
     else
@@ -460,7 +585,11 @@ bool Serializable::SetAttribute(const String& name, const Variant& value)
             // Check that the new value's type matches the attribute type
             if (value.GetType() == i->type_)
             {
-                OnSetAttribute(*i, value);
+                AttributeJournal* journal = GetAttributeJournal();
+                if (journal)
+                    SetAttributeRecorded(journal, *i, value);
+                else
+                    OnSetAttribute(*i, value);
                 return true;
             }
             else
@@ -599,6 +728,7 @@ void Serializable::ReadDeltaUpdate(Deserializer& source)
 
     unsigned numAttributes = attributes->Size();
     DirtyBits attributeBits;
+    AttributeJournal* journal = GetAttributeJournal();
 
     source.Read(attributeBits.data_, (numAttributes + 7) >> 3);
 
@@ -607,9 +737,16 @@ void Serializable::ReadDeltaUpdate(Deserializer& source)
         if (attributeBits.IsSet(i))
         {
             const AttributeInfo& attr = attributes->At(i);
-            OnSetAttribute(attr, source.ReadVariant(attr.type_));
+            if (journal)
+                SetAttributeRecorded(journal, attr, source.ReadVariant(attr.type_), false);
+            else
+                OnSetAttribute(attr, source.ReadVariant(attr.type_));
         }
     }
+
+    // Rehash once after all attributes of the update have been applied
+    if (journal)
+        journal->UpdateHash(this);
 }
 
 void Serializable::ReadLatestDataUpdate(Deserializer& source)
@@ -619,13 +756,22 @@ void Serializable::ReadLatestDataUpdate(Deserializer& source)
         return;
 
     unsigned numAttributes = attributes->Size();
+    AttributeJournal* journal = GetAttributeJournal();
 
     for (unsigned i = 0; i < numAttributes && !source.IsEof(); ++i)
     {
         const AttributeInfo& attr = attributes->At(i);
         if (attr.mode_ & AM_LATESTDATA)
-            OnSetAttribute(attr, source.ReadVariant(attr.type_));
+        {
+            if (journal)
+                SetAttributeRecorded(journal, attr, source.ReadVariant(attr.type_), false);
+            else
+                OnSetAttribute(attr, source.ReadVariant(attr.type_));
+        }
     }
+
+    if (journal)
+        journal->UpdateHash(this);
 }
 
 Variant Serializable::GetAttribute(unsigned index) const
@@ -727,6 +873,18 @@ unsigned Serializable::GetNumNetworkAttributes() const
     return attributes ? attributes->Size() : 0;
 }
 
+void Serializable::SetAttributeRecorded(AttributeJournal* journal, const AttributeInfo& attr, const Variant& value, bool rehash)
+{
+    Variant oldValue;
+    OnGetAttribute(attr, oldValue);
+    OnSetAttribute(attr, value);
+    
+    // Read back the value, as the object may have modified it
+    Variant newValue;
+    OnGetAttribute(attr, newValue);
+    journal->Record(this, attr, oldValue, newValue, rehash);
+}
+
 void Serializable::SetInstanceDefault(const String& name, const Variant& defaultValue)
 {
     // Allocate the instance level default value
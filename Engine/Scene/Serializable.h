@@ -30,6 +30,7 @@
 namespace Urho3D
 {
 
+class AttributeJournal;
 class Connection;
 class Deserializer;
 class Serializer;
@@ -54,6 +55,8 @@ public:
     virtual void OnSetAttribute(const AttributeInfo& attr, const Variant& src);
     /// Handle attribute read access. Default implementation reads the variable at offset, or invokes the get accessor.
     virtual void OnGetAttribute(const AttributeInfo& attr, Variant& dest) const;
+    /// Compare an attribute to a value without copying the attribute into a variant. Reads the variable at offset, or invokes the get accessor. Return true if equal.
+    bool AttributeEquals(const AttributeInfo& attr, const Variant& value) const;
     /// Return attribute descriptions, or null if none defined.
     virtual const Vector<AttributeInfo>* GetAttributes() const;
     /// Return network replication attribute descriptions, or null if none defined.
@@ -106,10 +109,15 @@ public:
     unsigned GetNumNetworkAttributes() const;
 
 protected:
+    /// Return the journal to record attribute changes to, or null if not recording.
+    virtual AttributeJournal* GetAttributeJournal() const { return 0; }
+
     /// Network attribute state.
     NetworkState* networkState_;
 
 private:
+    /// Set attribute and record the change to a journal. Optionally rehash the object in the journal.
+    void SetAttributeRecorded(AttributeJournal* journal, const AttributeInfo& attr, const Variant& value, bool rehash = true);
     /// Set instance-level default value. Allocate the internal data structure as necessary.
     void SetInstanceDefault(const String& name, const Variant& defaultValue);
     /// Get instance-level default value.
@@ -150,6 +158,14 @@ public:
         (classPtr->*setFunction_)(value.Get<U>());
     }
 
+    /// Invoke getter function and compare the typed result to a value.
+    virtual bool Equals(const Serializable* ptr, const Variant& value) const
+    {
+        assert(ptr);
+        const T* classPtr = static_cast<const T*>(ptr);
+        return value == (classPtr->*getFunction_)();
+    }
+
     /// Class-specific pointer to getter function.
     GetFunctionPtr getFunction_;
     /// Class-specific pointer to setter function.
@@ -188,6 +204,14 @@ public:
         (classPtr->*setFunction_)(value.Get<U>());
     }
 
+    /// Invoke getter function and compare the referenced value to a value.
+    virtual bool Equals(const Serializable* ptr, const Variant& value) const
+    {
+        assert(ptr);
+        const T* classPtr = static_cast<const T*>(ptr);
+        return value == (classPtr->*getFunction_)();
+    }
+
     /// Class-specific pointer to getter function.
     GetFunctionPtr getFunction_;
     /// Class-specific pointer to setter function.
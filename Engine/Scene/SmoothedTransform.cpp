@@ -37,8 +37,7 @@ SmoothedTransform::SmoothedTransform(Context* context) :
     Component(context),
     targetPosition_(Vector3::ZERO),
     targetRotation_(Quaternion::IDENTITY),
-    smoothingMask_(SMOOTH_NONE),
-    subscribed_(false)
+    smoothingMask_(SMOOTH_NONE)
 {
 }
 
@@ -51,6 +50,11 @@ void SmoothedTransform::RegisterObject(Context* context)
     context->RegisterFactory<SmoothedTransform>();
 }
 
+void SmoothedTransform::ThreadedUpdate(const SceneUpdateInfo& info)
+{
+    Update(info.smoothingConstant_, info.squaredSnapThreshold_);
+}
+
 void SmoothedTransform::Update(float constant, float squaredSnapThreshold)
 {
     if (smoothingMask_ && node_)
@@ -91,12 +95,9 @@ void SmoothedTransform::Update(float constant, float squaredSnapThreshold)
         }
     }
 
-    // If smoothing has completed, unsubscribe from the update event
+    // If smoothing has completed, stop updating. This is safe to do also from a worker thread
     if (!smoothingMask_)
-    {
-        UnsubscribeFromEvent(GetScene(), E_UPDATESMOOTHING);
-        subscribed_ = false;
-    }
+        SetThreadedUpdate(false);
 }
 
 void SmoothedTransform::SetTargetPosition(const Vector3& position)
@@ -104,12 +105,9 @@ void SmoothedTransform::SetTargetPosition(const Vector3& position)
     targetPosition_ = position;
     smoothingMask_ |= SMOOTH_POSITION;
 
-    // Subscribe to smoothing update if not yet subscribed
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
+    // Start updating if not yet updating
+    if (!threadedUpdate_)
+        SetThreadedUpdate(true);
 
     SendEvent(E_TARGETPOSITION);
 }
@@ -119,11 +117,8 @@ void SmoothedTransform::SetTargetRotation(const Quaternion& rotation)
     targetRotation_ = rotation;
     smoothingMask_ |= SMOOTH_ROTATION;
 
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
+    if (!threadedUpdate_)
+        SetThreadedUpdate(true);
 
     SendEvent(E_TARGETROTATION);
 }
@@ -170,13 +165,4 @@ void SmoothedTransform::OnNodeSet(Node* node)
     }
 }
 
-void SmoothedTransform::HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData)
-{
-    using namespace UpdateSmoothing;
-
-    float constant = eventData[P_CONSTANT].GetFloat();
-    float squaredSnapThreshold = eventData[P_SQUAREDSNAPTHRESHOLD].GetFloat();
-    Update(constant, squaredSnapThreshold);
-}
-
 }
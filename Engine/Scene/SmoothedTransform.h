@@ -47,6 +47,9 @@ public:
     /// Register object factory.
     static void RegisterObject(Context* context);
     
+    /// Perform the threaded update. Updates smoothing.
+    virtual void ThreadedUpdate(const SceneUpdateInfo& info);
+    
     /// Update smoothing.
     void Update(float constant, float squaredSnapThreshold);
     /// Set target position relative to parent node.
@@ -74,17 +77,12 @@ protected:
     virtual void OnNodeSet(Node* node);
     
 private:
-    /// Handle smoothing update event.
-    void HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData);
-    
     /// Target position.
     Vector3 targetPosition_;
     /// Target rotation.
     Quaternion targetRotation_;
     /// Active smoothing operations bitmask.
     unsigned char smoothingMask_;
-    /// Subscribed to smoothing update event flag.
-    bool subscribed_;
 };
 
 }
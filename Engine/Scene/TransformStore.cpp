@@ -0,0 +1,243 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Precompiled.h"
+#include "Component.h"
+#include "Node.h"
+#include "TransformStore.h"
+#include "WorkQueue.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned ROOT_INDEX = M_MAX_UNSIGNED;
+static const unsigned SKIP_INDEX = M_MAX_UNSIGNED - 1;
+static const unsigned MIN_NODES_PER_WORK_ITEM = 1024;
+
+void UpdateTransformsWork(const WorkItem* item, unsigned threadIndex)
+{
+    TransformStore* store = reinterpret_cast<TransformStore*>(item->aux_);
+    store->UpdateRange((unsigned)(size_t)item->start_, (unsigned)(size_t)item->end_);
+}
+
+TransformStore::TransformStore() :
+    numComputed_(0)
+{
+}
+
+TransformStore::~TransformStore()
+{
+    for (PODVector<Node*>::Iterator i = nodes_.Begin(); i != nodes_.End(); ++i)
+    {
+        if (*i)
+            (*i)->transformIndex_ = M_MAX_UNSIGNED;
+    }
+}
+
+void TransformStore::AddNode(Node* node)
+{
+    unsigned index = node->transformIndex_;
+    if (index != M_MAX_UNSIGNED)
+    {
+        // Still waiting for its world transform: nothing to do
+        if (index >= numComputed_)
+            return;
+        // Already updated during this update, so a listener has moved it again. Queue again at the end
+        nodes_[index] = 0;
+    }
+    
+    node->transformIndex_ = nodes_.Size();
+    nodes_.Push(node);
+}
+
+void TransformStore::RemoveNode(Node* node)
+{
+    unsigned index = node->transformIndex_;
+    if (index != M_MAX_UNSIGNED)
+    {
+        nodes_[index] = 0;
+        node->transformIndex_ = M_MAX_UNSIGNED;
+    }
+}
+
+void TransformStore::Update(WorkQueue* queue)
+{
+    unsigned start = 0;
+    
+    while (start < nodes_.Size())
+    {
+        unsigned end = nodes_.Size();
+        
+        if (queue && queue->GetNumThreads() && end - start >= 2 * MIN_NODES_PER_WORK_ITEM)
+        {
+            Gather(start, end);
+            Compute(start, end, queue);
+            numComputed_ = end;
+            
+            // Notify the listeners only now, so that they see the final world transforms. They may queue further nodes
+            for (unsigned i = start; i < end; ++i)
+            {
+                Node* node = nodes_[i];
+                if (node)
+                    node->NotifyListeners();
+            }
+        }
+        else
+        {
+            // Without worker threads, compute and notify in the same pass to touch each node only once. As parents are
+            // queued before their children, the parent world transform is already up to date
+            for (unsigned i = start; i < end; ++i)
+            {
+                Node* node = nodes_[i];
+                numComputed_ = i + 1;
+                if (node)
+                {
+                    if (node->dirty_)
+                        node->UpdateWorldTransform();
+                    node->NotifyListeners();
+                }
+            }
+        }
+        
+        start = end;
+    }
+    
+    for (PODVector<Node*>::Iterator i = nodes_.Begin(); i != nodes_.End(); ++i)
+    {
+        if (*i)
+            (*i)->transformIndex_ = M_MAX_UNSIGNED;
+    }
+    
+    nodes_.Clear();
+    numComputed_ = 0;
+}
+
+void TransformStore::UpdateRange(unsigned start, unsigned end)
+{
+    for (unsigned i = start; i < end; ++i)
+    {
+        unsigned parent = parents_[i];
+        if (parent == SKIP_INDEX)
+            continue;
+        
+        if (parent == ROOT_INDEX)
+        {
+            worldTransforms_[i] = worldTransforms_[i] * transforms_[i];
+            worldRotations_[i] = worldRotations_[i] * rotations_[i];
+        }
+        else
+        {
+            worldTransforms_[i] = worldTransforms_[parent] * transforms_[i];
+            worldRotations_[i] = worldRotations_[parent] * rotations_[i];
+        }
+        
+        Node* node = nodes_[i];
+        node->worldTransform_ = worldTransforms_[i];
+        node->worldRotation_ = worldRotations_[i];
+        node->dirty_ = false;
+    }
+}
+
+void TransformStore::Gather(unsigned start, unsigned end)
+{
+    parents_.Resize(end);
+    transforms_.Resize(end);
+    rotations_.Resize(end);
+    worldTransforms_.Resize(end);
+    worldRotations_.Resize(end);
+    
+    for (unsigned i = start; i < end; ++i)
+    {
+        Node* node = nodes_[i];
+        // Removed, or already updated on demand
+        if (!node || !node->dirty_)
+        {
+            parents_[i] = SKIP_INDEX;
+            continue;
+        }
+        
+        transforms_[i] = node->GetTransform();
+        rotations_[i] = node->rotation_;
+        
+        Node* parent = node->parent_;
+        unsigned parentIndex = parent ? parent->transformIndex_ : M_MAX_UNSIGNED;
+        if (parent && parent->dirty_ && parentIndex >= start && parentIndex < i && parents_[parentIndex] != SKIP_INDEX)
+            parents_[i] = parentIndex;
+        else
+        {
+            // The parent is clean or not ahead in the queue: use its world transform, which is computed on demand if needed
+            parents_[i] = ROOT_INDEX;
+            if (parent)
+            {
+                worldTransforms_[i] = parent->GetWorldTransform();
+                worldRotations_[i] = parent->GetWorldRotation();
+            }
+            else
+            {
+                worldTransforms_[i] = Matrix3x4::IDENTITY;
+                worldRotations_[i] = Quaternion::IDENTITY;
+            }
+        }
+    }
+}
+
+void TransformStore::Compute(unsigned start, unsigned end, WorkQueue* queue)
+{
+    unsigned numNodes = end - start;
+    
+    // A range can be computed independently if no node after its start refers to a parent before it. Find the lowest
+    // parent index referred to from each position onward, then cut the ranges where that is not before the cut
+    PODVector<unsigned> minParents(numNodes + 1);
+    minParents[numNodes] = M_MAX_UNSIGNED;
+    for (unsigned i = numNodes - 1; i < numNodes; --i)
+    {
+        unsigned parent = parents_[start + i];
+        minParents[i] = parent < minParents[i + 1] ? parent : minParents[i + 1];
+    }
+    
+    unsigned numThreads = queue->GetNumThreads() + 1;
+    unsigned targetSize = Max((int)(numNodes / numThreads), (int)MIN_NODES_PER_WORK_ITEM);
+    unsigned rangeStart = 0;
+    
+    for (unsigned i = targetSize; i < numNodes; ++i)
+    {
+        if (i - rangeStart >= targetSize && minParents[i] >= start + i)
+        {
+            WorkItem item;
+            item.workFunction_ = UpdateTransformsWork;
+            item.start_ = (void*)(size_t)(start + rangeStart);
+            item.end_ = (void*)(size_t)(start + i);
+            item.aux_ = this;
+            queue->AddWorkItem(item);
+            rangeStart = i;
+        }
+    }
+    
+    // Compute the last range on the main thread while the work items complete
+    UpdateRange(start + rangeStart, end);
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
+}
@@ -0,0 +1,78 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Matrix3x4.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+class Node;
+class WorkQueue;
+
+/// Queue of nodes with changed transforms for batched world transform updates. The transforms are stored as structure of arrays in parent-before-child order, so that the world transforms can be computed in one linear pass, split into independent ranges for worker threads.
+class TransformStore
+{
+public:
+    /// Construct.
+    TransformStore();
+    /// Destruct.
+    ~TransformStore();
+    
+    /// Queue a dirty node. Does nothing if the node is already queued and not yet updated.
+    void AddNode(Node* node);
+    /// Remove a node from the queue.
+    void RemoveNode(Node* node);
+    /// Compute the world transforms of the queued nodes, then notify their listeners. Repeat until no new nodes are queued by the listeners.
+    void Update(WorkQueue* queue);
+    /// Return number of queued nodes.
+    unsigned GetNumNodes() const { return nodes_.Size(); }
+    
+    /// Compute world transforms for a range of queued nodes and store them to the nodes. Called by the work function.
+    void UpdateRange(unsigned start, unsigned end);
+    
+private:
+    /// Gather local transforms and parent indices for a range of queued nodes.
+    void Gather(unsigned start, unsigned end);
+    /// Compute world transforms for a range of queued nodes, split into independent parts for worker threads.
+    void Compute(unsigned start, unsigned end, WorkQueue* queue);
+    
+    /// Queued nodes. Removed nodes are null.
+    PODVector<Node*> nodes_;
+    /// Index of the parent within the queue, or ROOT_INDEX if the parent's world transform was copied to the world arrays.
+    PODVector<unsigned> parents_;
+    /// Local transforms.
+    PODVector<Matrix3x4> transforms_;
+    /// Local rotations.
+    PODVector<Quaternion> rotations_;
+    /// World transforms.
+    PODVector<Matrix3x4> worldTransforms_;
+    /// World rotations.
+    PODVector<Quaternion> worldRotations_;
+    /// Number of queued nodes whose world transforms have been computed during the update.
+    unsigned numComputed_;
+};
+
+}
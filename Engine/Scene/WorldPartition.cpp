@@ -0,0 +1,545 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Precompiled.h"
+#include "Context.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "ResourceCache.h"
+#include "Scene.h"
+#include "SceneEvents.h"
+#include "Timer.h"
+#include "WorldPartition.h"
+#include "XMLFile.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* SUBSYSTEM_CATEGORY;
+
+static const float DEFAULT_CELL_SIZE = 100.0f;
+static const float DEFAULT_LOAD_DISTANCE = 150.0f;
+static const float DEFAULT_UNLOAD_DISTANCE = 200.0f;
+static const int DEFAULT_MAX_LOAD_TIME = 5;
+
+/// Return hash map key of cell coordinates.
+static unsigned GetCellKey(int x, int z)
+{
+    return ((unsigned)x << 16) | ((unsigned)z & 0xffff);
+}
+
+WorldCell::WorldCell() :
+    x_(0),
+    z_(0),
+    loaded_(false),
+    loadedNodes_(0),
+    totalNodes_(0)
+{
+}
+
+OBJECTTYPESTATIC(WorldPartition);
+
+WorldPartition::WorldPartition(Context* context) :
+    Component(context),
+    cellExtension_(".bin"),
+    cellSize_(DEFAULT_CELL_SIZE),
+    loadDistance_(DEFAULT_LOAD_DISTANCE),
+    unloadDistance_(DEFAULT_UNLOAD_DISTANCE),
+    maxLoadTime_(DEFAULT_MAX_LOAD_TIME),
+    releaseResources_(false)
+{
+}
+
+WorldPartition::~WorldPartition()
+{
+}
+
+void WorldPartition::RegisterObject(Context* context)
+{
+    context->RegisterFactory<WorldPartition>(SUBSYSTEM_CATEGORY);
+    
+    ACCESSOR_ATTRIBUTE(WorldPartition, VAR_FLOAT, "Cell Size", GetCellSize, SetCellSize, float, DEFAULT_CELL_SIZE, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE(WorldPartition, VAR_FLOAT, "Load Distance", GetLoadDistance, SetLoadDistance, float, DEFAULT_LOAD_DISTANCE, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE(WorldPartition, VAR_FLOAT, "Unload Distance", GetUnloadDistance, SetUnloadDistance, float, DEFAULT_UNLOAD_DISTANCE, AM_DEFAULT);
+    REF_ACCESSOR_ATTRIBUTE(WorldPartition, VAR_STRING, "Cell Path", GetCellPath, SetCellPath, String, String::EMPTY, AM_DEFAULT);
+    REF_ACCESSOR_ATTRIBUTE(WorldPartition, VAR_STRING, "Cell Extension", GetCellExtension, SetCellExtension, String, String(".bin"), AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE(WorldPartition, VAR_INT, "Max Load Time", GetMaxLoadTime, SetMaxLoadTime, int, DEFAULT_MAX_LOAD_TIME, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE(WorldPartition, VAR_BOOL, "Release Resources", GetReleaseResources, SetReleaseResources, bool, false, AM_DEFAULT);
+}
+
+void WorldPartition::Update()
+{
+    UpdateCells(maxLoadTime_);
+}
+
+void WorldPartition::FinishLoading()
+{
+    UpdateCells(0);
+}
+
+void WorldPartition::UnloadAllCells()
+{
+    if (cells_.Empty())
+        return;
+    
+    for (HashMap<unsigned, WorldCell>::Iterator i = cells_.Begin(); i != cells_.End(); ++i)
+        UnloadCell(i->second_);
+    cells_.Clear();
+}
+
+void WorldPartition::AddFocus(Node* node)
+{
+    if (!node)
+        return;
+    
+    WeakPtr<Node> nodeWeak(node);
+    if (!focusNodes_.Contains(nodeWeak))
+        focusNodes_.Push(nodeWeak);
+}
+
+void WorldPartition::RemoveFocus(Node* node)
+{
+    focusNodes_.Remove(WeakPtr<Node>(node));
+}
+
+void WorldPartition::RemoveAllFocus()
+{
+    focusNodes_.Clear();
+}
+
+void WorldPartition::SetCellSize(float size)
+{
+    size = Max(size, M_EPSILON);
+    if (size != cellSize_)
+    {
+        // The existing cells no longer match the grid
+        UnloadAllCells();
+        missingCells_.Clear();
+        cellSize_ = size;
+        MarkNetworkUpdate();
+    }
+}
+
+void WorldPartition::SetLoadDistance(float distance)
+{
+    loadDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void WorldPartition::SetUnloadDistance(float distance)
+{
+    unloadDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void WorldPartition::SetCellPath(const String& path)
+{
+    if (path != cellPath_)
+    {
+        UnloadAllCells();
+        missingCells_.Clear();
+        cellPath_ = path;
+        MarkNetworkUpdate();
+    }
+}
+
+void WorldPartition::SetCellExtension(const String& extension)
+{
+    if (extension != cellExtension_)
+    {
+        UnloadAllCells();
+        missingCells_.Clear();
+        cellExtension_ = extension;
+        MarkNetworkUpdate();
+    }
+}
+
+void WorldPartition::SetMaxLoadTime(int msec)
+{
+    maxLoadTime_ = Max(msec, 1);
+    MarkNetworkUpdate();
+}
+
+void WorldPartition::SetReleaseResources(bool enable)
+{
+    releaseResources_ = enable;
+    MarkNetworkUpdate();
+}
+
+unsigned WorldPartition::GetNumLoadedCells() const
+{
+    unsigned numLoaded = 0;
+    for (HashMap<unsigned, WorldCell>::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+    {
+        if (i->second_.loaded_)
+            ++numLoaded;
+    }
+    
+    return numLoaded;
+}
+
+bool WorldPartition::IsLoading() const
+{
+    for (HashMap<unsigned, WorldCell>::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+    {
+        if (!i->second_.loaded_)
+            return true;
+    }
+    
+    return false;
+}
+
+IntVector2 WorldPartition::GetCellCoords(const Vector3& worldPosition) const
+{
+    Vector3 position = node_ ? node_->GetWorldTransform().Inverse() * worldPosition : worldPosition;
+    return IntVector2((int)floorf(position.x_ / cellSize_), (int)floorf(position.z_ / cellSize_));
+}
+
+Node* WorldPartition::GetCellNode(int x, int z) const
+{
+    HashMap<unsigned, WorldCell>::ConstIterator i = cells_.Find(GetCellKey(x, z));
+    return (i != cells_.End() && i->second_.loaded_) ? i->second_.node_ : (Node*)0;
+}
+
+String WorldPartition::GetCellFileName(int x, int z) const
+{
+    return cellPath_ + String(x) + "_" + String(z) + cellExtension_;
+}
+
+void WorldPartition::OnNodeSet(Node* node)
+{
+    if (node)
+    {
+        Scene* scene = GetScene();
+        if (scene)
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(WorldPartition, HandleScenePostUpdate));
+    }
+    else
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+}
+
+void WorldPartition::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    if (IsEnabledEffective())
+        Update();
+}
+
+void WorldPartition::UpdateCells(int maxMsec)
+{
+    if (!node_ || cellPath_.Empty())
+        return;
+    
+    PROFILE(UpdateWorldPartition);
+    
+    // Get the focus positions in the partition's local space. Remove expired focus nodes
+    PODVector<Vector3> focusPositions;
+    Matrix3x4 inverseTransform = node_->GetWorldTransform().Inverse();
+    for (Vector<WeakPtr<Node> >::Iterator i = focusNodes_.Begin(); i != focusNodes_.End();)
+    {
+        if (*i)
+        {
+            focusPositions.Push(inverseTransform * (*i)->GetWorldPosition());
+            ++i;
+        }
+        else
+            i = focusNodes_.Erase(i);
+    }
+    
+    // Unload cells that are beyond the unload distance from all focus nodes, including cells that are still being loaded
+    float unloadDistance = Max(unloadDistance_, loadDistance_);
+    for (HashMap<unsigned, WorldCell>::Iterator i = cells_.Begin(); i != cells_.End();)
+    {
+        if (GetCellDistance(i->second_.x_, i->second_.z_, focusPositions) > unloadDistance)
+        {
+            UnloadCell(i->second_);
+            i = cells_.Erase(i);
+        }
+        else
+            ++i;
+    }
+    
+    // Record the resources requested by the cell being loaded, so that they can be released along with it
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    Vector<Pair<ShortStringHash, StringHash> >* previousRecord = cache ? cache->GetRequestRecord() : 0;
+    Timer loadTimer;
+    
+    for (;;)
+    {
+        // Continue the cell currently being loaded
+        WorldCell* loadingCell = 0;
+        for (HashMap<unsigned, WorldCell>::Iterator i = cells_.Begin(); i != cells_.End(); ++i)
+        {
+            if (!i->second_.loaded_)
+            {
+                loadingCell = &i->second_;
+                break;
+            }
+        }
+        
+        // If no cell is being loaded, start loading the nearest cell in range
+        if (!loadingCell)
+        {
+            int nearestX = 0;
+            int nearestZ = 0;
+            float nearestDistance = M_INFINITY;
+            
+            for (unsigned i = 0; i < focusPositions.Size(); ++i)
+            {
+                const Vector3& position = focusPositions[i];
+                int minX = (int)floorf((position.x_ - loadDistance_) / cellSize_);
+                int maxX = (int)floorf((position.x_ + loadDistance_) / cellSize_);
+                int minZ = (int)floorf((position.z_ - loadDistance_) / cellSize_);
+                int maxZ = (int)floorf((position.z_ + loadDistance_) / cellSize_);
+                
+                for (int z = minZ; z <= maxZ; ++z)
+                {
+                    for (int x = minX; x <= maxX; ++x)
+                    {
+                        unsigned key = GetCellKey(x, z);
+                        if (cells_.Contains(key) || missingCells_.Contains(key))
+                            continue;
+                        
+                        float distance = GetCellDistance(x, z, focusPositions);
+                        if (distance <= loadDistance_ && distance < nearestDistance)
+                        {
+                            nearestX = x;
+                            nearestZ = z;
+                            nearestDistance = distance;
+                        }
+                    }
+                }
+            }
+            
+            // All cells in range have been loaded
+            if (nearestDistance == M_INFINITY)
+                break;
+            
+            unsigned key = GetCellKey(nearestX, nearestZ);
+            WorldCell& cell = cells_[key];
+            cell.x_ = nearestX;
+            cell.z_ = nearestZ;
+            if (cache)
+                cache->SetRequestRecord(&cell.resources_);
+            bool success = BeginLoadCell(cell);
+            if (cache)
+                cache->SetRequestRecord(previousRecord);
+            if (!success)
+            {
+                ReleaseCellResources(cell);
+                cells_.Erase(key);
+                missingCells_.Insert(key);
+                continue;
+            }
+            
+            loadingCell = &cell;
+        }
+        else
+        {
+            if (cache)
+                cache->SetRequestRecord(&loadingCell->resources_);
+            LoadCellNode(*loadingCell);
+            if (cache)
+                cache->SetRequestRecord(previousRecord);
+        }
+        
+        // Break if time limit exceeded, so that frame times stay bounded
+        if (maxMsec && loadTimer.GetMSec(false) >= (unsigned)maxMsec)
+            break;
+    }
+}
+
+bool WorldPartition::BeginLoadCell(WorldCell& cell)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    String fileName = GetCellFileName(cell.x_, cell.z_);
+    if (!cache || !cache->Exists(fileName))
+        return false;
+    
+    SharedPtr<File> file = cache->GetFile(fileName);
+    if (!file)
+        return false;
+    
+    // Cell contents are never replicated, and get new IDs like instantiated content. They are not saved with the scene,
+    // as they are streamed in again after loading
+    Node* cellNode = node_->CreateChild(0, LOCAL);
+    cellNode->SetTemporary(true);
+    cell.node_ = cellNode;
+    
+    if (GetExtension(fileName) == ".xml")
+    {
+        SharedPtr<XMLFile> xml(new XMLFile(context_));
+        if (!xml->Load(*file))
+        {
+            cellNode->Remove();
+            return false;
+        }
+        
+        XMLElement rootElem = xml->GetRoot();
+        cell.resolver_.AddNode(rootElem.GetInt("id"), cellNode);
+        if (!cellNode->LoadXML(rootElem, cell.resolver_, false, true, LOCAL))
+        {
+            cellNode->Remove();
+            return false;
+        }
+        
+        cell.xmlFile_ = xml;
+        cell.xmlElement_ = rootElem.GetChild("node");
+        cell.totalNodes_ = 0;
+        for (XMLElement childElem = cell.xmlElement_; childElem; childElem = childElem.GetNext("node"))
+            ++cell.totalNodes_;
+    }
+    else
+    {
+        cell.resolver_.AddNode(file->ReadUInt(), cellNode);
+        if (!cellNode->Load(*file, cell.resolver_, false, true, LOCAL))
+        {
+            cellNode->Remove();
+            return false;
+        }
+        
+        cell.file_ = file;
+        cell.totalNodes_ = file->ReadVLE();
+    }
+    
+    LOGDEBUG("Loading world cell " + fileName);
+    
+    // A cell without child nodes is finished immediately
+    if (!cell.totalNodes_)
+        LoadCellNode(cell);
+    return true;
+}
+
+void WorldPartition::LoadCellNode(WorldCell& cell)
+{
+    // If the cell node was removed from outside, there is nothing left to load
+    Node* cellNode = cell.node_;
+    if (!cellNode)
+    {
+        cell.file_.Reset();
+        cell.xmlFile_.Reset();
+        cell.loaded_ = true;
+        return;
+    }
+    
+    if (cell.loadedNodes_ < cell.totalNodes_)
+    {
+        if (cell.xmlFile_)
+        {
+            unsigned nodeID = cell.xmlElement_.GetInt("id");
+            Node* newNode = cellNode->CreateChild(0, LOCAL);
+            cell.resolver_.AddNode(nodeID, newNode);
+            newNode->LoadXML(cell.xmlElement_, cell.resolver_, true, true, LOCAL);
+            cell.xmlElement_ = cell.xmlElement_.GetNext("node");
+        }
+        else
+        {
+            unsigned nodeID = cell.file_->ReadUInt();
+            Node* newNode = cellNode->CreateChild(0, LOCAL);
+            cell.resolver_.AddNode(nodeID, newNode);
+            newNode->Load(*cell.file_, cell.resolver_, true, true, LOCAL);
+        }
+        
+        ++cell.loadedNodes_;
+    }
+    
+    if (cell.loadedNodes_ >= cell.totalNodes_)
+    {
+        cell.resolver_.Resolve();
+        cellNode->ApplyAttributes();
+        cell.file_.Reset();
+        cell.xmlFile_.Reset();
+        cell.xmlElement_ = XMLElement::EMPTY;
+        cell.loaded_ = true;
+        
+        using namespace WorldCellLoaded;
+        
+        VariantMap eventData;
+        eventData[P_NODE] = (void*)cellNode;
+        eventData[P_X] = cell.x_;
+        eventData[P_Z] = cell.z_;
+        SendEvent(E_WORLDCELLLOADED, eventData);
+    }
+}
+
+void WorldPartition::UnloadCell(WorldCell& cell)
+{
+    Node* cellNode = cell.node_;
+    if (!cellNode)
+    {
+        ReleaseCellResources(cell);
+        return;
+    }
+    
+    if (cell.loaded_)
+    {
+        using namespace WorldCellUnloaded;
+        
+        VariantMap eventData;
+        eventData[P_NODE] = (void*)cellNode;
+        eventData[P_X] = cell.x_;
+        eventData[P_Z] = cell.z_;
+        SendEvent(E_WORLDCELLUNLOADED, eventData);
+    }
+    
+    cell.file_.Reset();
+    cell.xmlFile_.Reset();
+    cellNode->Remove();
+    ReleaseCellResources(cell);
+}
+
+void WorldPartition::ReleaseCellResources(WorldCell& cell)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    if (releaseResources_ && cache)
+    {
+        // Release in reverse order, so that a resource is released before the resources it depends on. Resources still
+        // in use, for example by other cells, are not released
+        for (unsigned i = cell.resources_.Size(); i > 0; --i)
+            cache->ReleaseResource(cell.resources_[i - 1].first_, cell.resources_[i - 1].second_, false);
+    }
+    
+    cell.resources_.Clear();
+}
+
+float WorldPartition::GetCellDistance(int x, int z, const PODVector<Vector3>& focusPositions) const
+{
+    float minX = x * cellSize_;
+    float minZ = z * cellSize_;
+    float nearest = M_INFINITY;
+    
+    for (unsigned i = 0; i < focusPositions.Size(); ++i)
+    {
+        const Vector3& position = focusPositions[i];
+        float dx = Max(Max(minX - position.x_, position.x_ - (minX + cellSize_)), 0.0f);
+        float dz = Max(Max(minZ - position.z_, position.z_ - (minZ + cellSize_)), 0.0f);
+        nearest = Min(nearest, sqrtf(dx * dx + dz * dz));
+    }
+    
+    return nearest;
+}
+
+}
@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "Component.h"
+#include "HashSet.h"
+#include "SceneResolver.h"
+#include "XMLElement.h"
+
+namespace Urho3D
+{
+
+class File;
+class XMLFile;
+
+/// Streamed cell of a world partition.
+struct WorldCell
+{
+    /// Construct.
+    WorldCell();
+    
+    /// Cell X coordinate.
+    int x_;
+    /// Cell Z coordinate.
+    int z_;
+    /// Cell root node.
+    WeakPtr<Node> node_;
+    /// Loaded flag. False while the cell is still being loaded.
+    bool loaded_;
+    /// File being loaded from.
+    SharedPtr<File> file_;
+    /// XML file being loaded from.
+    SharedPtr<XMLFile> xmlFile_;
+    /// Next child node element to load from XML.
+    XMLElement xmlElement_;
+    /// Child nodes loaded so far.
+    unsigned loadedNodes_;
+    /// Total child nodes in the cell.
+    unsigned totalNodes_;
+    /// Node and component ID resolver.
+    SceneResolver resolver_;
+    /// Resources requested while loading the cell, each after the resources it depends on.
+    Vector<Pair<ShortStringHash, StringHash> > resources_;
+};
+
+/// %Scene component that streams a grid of cells, stored as separate node files, in and out around focus nodes.
+class WorldPartition : public Component
+{
+    OBJECT(WorldPartition);
+    
+public:
+    /// Construct.
+    WorldPartition(Context* context);
+    /// Destruct.
+    virtual ~WorldPartition();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+    
+    /// Unload cells that have moved out of range and continue loading the cells in range, within the load time limit. Called automatically on scene post-update.
+    void Update();
+    /// Load all cells within the load distance of the focus nodes immediately, without a time limit.
+    void FinishLoading();
+    /// Unload all cells.
+    void UnloadAllCells();
+    /// Add a focus node, for example the camera or the player.
+    void AddFocus(Node* node);
+    /// Remove a focus node.
+    void RemoveFocus(Node* node);
+    /// Remove all focus nodes.
+    void RemoveAllFocus();
+    /// Set cell size.
+    void SetCellSize(float size);
+    /// Set distance from the nearest focus node within which cells are loaded.
+    void SetLoadDistance(float distance);
+    /// Set distance from the nearest focus node beyond which cells are unloaded. Should be larger than the load distance to avoid cells being repeatedly loaded and unloaded.
+    void SetUnloadDistance(float distance);
+    /// Set resource name prefix of the cell files. The cell coordinates and the extension are appended, for example Cell_0_-1.bin.
+    void SetCellPath(const String& path);
+    /// Set cell file extension. Cells with the .xml extension are loaded from XML.
+    void SetCellExtension(const String& extension);
+    /// Set maximum time in milliseconds to spend loading cells per frame.
+    void SetMaxLoadTime(int msec);
+    /// Set whether to release the resources requested by a cell when it is unloaded, if nothing else uses them.
+    void SetReleaseResources(bool enable);
+    
+    /// Return cell size.
+    float GetCellSize() const { return cellSize_; }
+    /// Return load distance.
+    float GetLoadDistance() const { return loadDistance_; }
+    /// Return unload distance.
+    float GetUnloadDistance() const { return unloadDistance_; }
+    /// Return resource name prefix of the cell files.
+    const String& GetCellPath() const { return cellPath_; }
+    /// Return cell file extension.
+    const String& GetCellExtension() const { return cellExtension_; }
+    /// Return maximum time in milliseconds to spend loading cells per frame.
+    int GetMaxLoadTime() const { return maxLoadTime_; }
+    /// Return whether the resources of unloaded cells are released.
+    bool GetReleaseResources() const { return releaseResources_; }
+    /// Return number of focus nodes.
+    unsigned GetNumFocusNodes() const { return focusNodes_.Size(); }
+    /// Return number of loaded cells, not including the cell being loaded.
+    unsigned GetNumLoadedCells() const;
+    /// Return whether a cell is being loaded.
+    bool IsLoading() const;
+    /// Return coordinates of the cell containing a world space position.
+    IntVector2 GetCellCoords(const Vector3& worldPosition) const;
+    /// Return root node of a loaded cell, or null if not loaded.
+    Node* GetCellNode(int x, int z) const;
+    /// Return resource name of a cell file.
+    String GetCellFileName(int x, int z) const;
+    
+protected:
+    /// Handle node being assigned.
+    virtual void OnNodeSet(Node* node);
+    
+private:
+    /// Handle scene post-update event.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Unload cells out of range and load cells in range. A zero time limit loads without limit.
+    void UpdateCells(int maxMsec);
+    /// Start loading a cell. Return false if the cell file does not exist or is invalid.
+    bool BeginLoadCell(WorldCell& cell);
+    /// Load the next child node of a cell. Finishes the cell after the last node.
+    void LoadCellNode(WorldCell& cell);
+    /// Unload a cell.
+    void UnloadCell(WorldCell& cell);
+    /// Release the resources requested by a cell that are no longer used.
+    void ReleaseCellResources(WorldCell& cell);
+    /// Return distance from the nearest focus position to a cell on the XZ plane.
+    float GetCellDistance(int x, int z, const PODVector<Vector3>& focusPositions) const;
+    
+    /// Cells being loaded or loaded.
+    HashMap<unsigned, WorldCell> cells_;
+    /// Cells that have no file.
+    HashSet<unsigned> missingCells_;
+    /// Focus nodes.
+    Vector<WeakPtr<Node> > focusNodes_;
+    /// Resource name prefix of the cell files.
+    String cellPath_;
+    /// Cell file extension.
+    String cellExtension_;
+    /// Cell size.
+    float cellSize_;
+    /// Load distance.
+    float loadDistance_;
+    /// Unload distance.
+    float unloadDistance_;
+    /// Maximum time in milliseconds to spend loading cells per frame.
+    int maxLoadTime_;
+    /// Release unused resources flag.
+    bool releaseResources_;
+};
+
+}
@@ -508,8 +508,12 @@ void ScriptInstance::UpdateEventSubscription()
             }
             else
             {
-                if (methods_[METHOD_FIXEDUPDATE] || methods_[METHOD_FIXEDPOSTUPDATE])
-                    LOGERROR("No physics world, can not subscribe script object to fixed update events");
+                // Without physics, use the scene's own fixed timestep update. Subscribe even if its rate is zero, as the
+                // events are only sent while a rate is set, and it may be set later
+                if (methods_[METHOD_FIXEDUPDATE])
+                    SubscribeToEvent(scene, E_SCENEFIXEDUPDATE, HANDLER(ScriptInstance, HandlePhysicsPreStep));
+                if (methods_[METHOD_FIXEDPOSTUPDATE])
+                    SubscribeToEvent(scene, E_SCENEFIXEDPOSTUPDATE, HANDLER(ScriptInstance, HandlePhysicsPostStep));
             }
             
             
@@ -527,6 +531,8 @@ void ScriptInstance::UpdateEventSubscription()
         if (subscribedPostFixed_)
         {
             UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
+            UnsubscribeFromEvent(scene, E_SCENEFIXEDUPDATE);
+            UnsubscribeFromEvent(scene, E_SCENEFIXEDPOSTUPDATE);
             
             PhysicsWorld* world = scene->GetComponent<PhysicsWorld>();
             if (world)
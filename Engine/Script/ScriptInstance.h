@@ -157,9 +157,9 @@ private:
     void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle scene post-update event.
     void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
-    /// Handle physics pre-step event.
+    /// Handle physics pre-step or scene fixed update event.
     void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
-    /// Handle physics post-step event.
+    /// Handle physics post-step or scene fixed post-update event.
     void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
     /// Handle an event in script.
     void HandleScriptEvent(StringHash eventType, VariantMap& eventData);
@@ -188,6 +188,7 @@ bool Font::Load(Deserializer& source)
         fontType_ = FONT_BITMAP;
 
     SetMemoryUse(fontDataSize_);
+    SetGPUMemoryUse(0);
     return true;
 }
 
@@ -563,6 +564,7 @@ const FontFace* Font::GetFaceTTF(int pointSize)
     FT_Done_Face(face);
         
     SetMemoryUse(GetMemoryUse() + totalTextureSize);
+    SetGPUMemoryUse(GetGPUMemoryUse() + totalTextureSize);
     faces_[pointSize] = newFace;
     return newFace;
 }
@@ -683,6 +685,7 @@ const FontFace* Font::GetFaceBitmap(int pointSize)
     }
     
     SetMemoryUse(GetMemoryUse() + totalTextureSize);
+    SetGPUMemoryUse(GetGPUMemoryUse() + totalTextureSize);
     faces_[pointSize] = newFace;
     return newFace;
 }
@@ -22,14 +22,21 @@
 
 #include "Context.h"
 #include "ArrayPtr.h"
+#include "Compression.h"
 #include "File.h"
 #include "FileSystem.h"
+#include "MemoryBuffer.h"
+#include "PackageFile.h"
 #include "ProcessUtils.h"
+#include "StringUtils.h"
+#include "VectorBuffer.h"
+#include "XMLFile.h"
 
 #ifdef WIN32
 #include <windows.h>
 #endif
 
+#include <cctype>
 #include <cstdio>
 #include <cstring>
 
@@ -42,7 +49,9 @@ struct FileEntry
     String name_;
     unsigned offset_;
     unsigned size_;
+    unsigned packedSize_;
     unsigned checksum_;
+    bool compressed_;
 };
 
 SharedPtr<Context> context_(new Context());
@@ -50,6 +59,11 @@ SharedPtr<FileSystem> fileSystem_(new FileSystem(context_));
 String basePath_;
 Vector<FileEntry> entries_;
 unsigned checksum_ = 0;
+bool compressAll_ = false;
+bool compileXML_ = false;
+Vector<String> compressExtensions_;
+Vector<String> uncompressedExtensions_;
+unsigned blockSize_ = DEFAULT_PACKAGE_BLOCK_SIZE;
 
 String ignoreExtensions_[] = {
     ".bak",
@@ -61,6 +75,10 @@ int main(int argc, char** argv);
 void Run(const Vector<String>& arguments);
 void ProcessFile(const String& fileName, const String& rootDir);
 void WritePackageFile(const String& fileName, const String& rootDir);
+void WriteHeader(File& dest, bool compressed);
+bool ShouldCompress(const String& fileName);
+unsigned CompressFile(PODVector<unsigned char>& dest, const unsigned char* src, unsigned srcSize);
+bool CompileXML(VectorBuffer& dest, const unsigned char* src, unsigned srcSize, const String& fileName);
 
 int main(int argc, char** argv)
 {
@@ -79,12 +97,57 @@ int main(int argc, char** argv)
 void Run(const Vector<String>& arguments)
 {
     if (arguments.Size() < 2)
-        ErrorExit("Usage: PackageTool <directory to process> <package name> [basepath]\n");
+    {
+        ErrorExit(
+            "Usage: PackageTool <directory to process> <package name> [basepath] [options]\n"
+            "\n"
+            "Options:\n"
+            "-c              Compress all files using LZ4\n"
+            "-c<extensions>  Compress files with the listed extensions only, for example -c.xml,.as,.glsl\n"
+            "-u<extensions>  Never compress files with the listed extensions, for example -u.ogg,.dds\n"
+            "-b<size>        Uncompressed size of the compressed blocks in bytes, default 65536\n"
+            "-x              Store XML files in the compiled binary form, which loads faster\n"
+        );
+    }
     
     const String& dirName = arguments[0];
     const String& packageName = arguments[1];
-    if (arguments.Size() > 2)
-        basePath_ = AddTrailingSlash(arguments[2]);
+    for (unsigned i = 2; i < arguments.Size(); ++i)
+    {
+        const String& arg = arguments[i];
+        if (arg.Length() >= 2 && arg[0] == '-')
+        {
+            String value = arg.Substring(2).ToLower();
+            switch (tolower(arg[1]))
+            {
+            case 'c':
+                if (value.Empty())
+                    compressAll_ = true;
+                else
+                    compressExtensions_.Push(value.Split(','));
+                break;
+                
+            case 'u':
+                uncompressedExtensions_.Push(value.Split(','));
+                break;
+                
+            case 'b':
+                blockSize_ = ToUInt(value);
+                if (blockSize_ < 1024)
+                    ErrorExit("Block size must be at least 1024 bytes");
+                break;
+                
+            case 'x':
+                compileXML_ = true;
+                break;
+                
+            default:
+                ErrorExit("Unrecognized option " + arg);
+            }
+        }
+        else
+            basePath_ = AddTrailingSlash(arg);
+    }
     
     PrintLine("Scanning directory " + dirName + " for files");
     
@@ -127,7 +190,9 @@ void ProcessFile(const String& fileName, const String& rootDir)
     newEntry.name_ = fileName;
     newEntry.offset_ = 0; // Offset not yet known
     newEntry.size_ = file.GetSize();
+    newEntry.packedSize_ = 0; // Will be calculated later
     newEntry.checksum_ = 0; // Will be calculated later
+    newEntry.compressed_ = ShouldCompress(fileName);
     entries_.Push(newEntry);
 }
 
@@ -139,25 +204,23 @@ void WritePackageFile(const String& fileName, const String& rootDir)
     if (!dest.Open(fileName, FILE_WRITE))
         ErrorExit("Could not open output file " + fileName);
     
-    // Write ID, number of files & placeholder for checksum
-    dest.WriteFileID("UPAK");
-    dest.WriteUInt(entries_.Size());
-    dest.WriteUInt(checksum_);
-    
+    // Write the versioned format only if compression was requested, so that uncompressed packages stay readable by
+    // older versions of the engine
+    bool compressed = false;
     for (unsigned i = 0; i < entries_.Size(); ++i)
-    {
-        // Write entry (correct offset is still unknown, will be filled in later)
-        dest.WriteString(entries_[i].name_);
-        dest.WriteUInt(entries_[i].offset_);
-        dest.WriteUInt(entries_[i].size_);
-        dest.WriteUInt(entries_[i].checksum_);
-    }
+        compressed |= entries_[i].compressed_;
+    
+    // Write ID, number of files & placeholders for checksums and offsets (correct values are still unknown, will be
+    // filled in later)
+    WriteHeader(dest, compressed);
+    
+    unsigned totalSize = 0;
+    unsigned totalPackedSize = 0;
+    PODVector<unsigned char> packedBuffer;
     
     // Write file data, calculate checksums & correct offsets
     for (unsigned i = 0; i < entries_.Size(); ++i)
     {
-        PrintLine("Writing file " + entries_[i].name_);
-        
         entries_[i].offset_ = dest.GetSize();
         String fileFullPath = rootDir + "/" + entries_[i].name_;
         
@@ -172,28 +235,146 @@ void WritePackageFile(const String& fileName, const String& rootDir)
             ErrorExit("Could not read file " + fileFullPath);
         srcFile.Close();
         
+        // If requested, replace XML text with the compiled binary form. The file checksum is calculated from the stored data
+        VectorBuffer compiledXML;
+        if (compileXML_ && GetExtension(entries_[i].name_) == ".xml" && CompileXML(compiledXML, &buffer[0], dataSize,
+            entries_[i].name_))
+        {
+            dataSize = compiledXML.GetSize();
+            buffer = new unsigned char[dataSize];
+            memcpy(&buffer[0], compiledXML.GetData(), dataSize);
+            entries_[i].size_ = dataSize;
+        }
+        
         for (unsigned j = 0; j < dataSize; ++j)
         {
             checksum_ = SDBMHash(checksum_, buffer[j]);
             entries_[i].checksum_ = SDBMHash(entries_[i].checksum_, buffer[j]);
         }
         
-        dest.Write(&buffer[0], entries_[i].size_);
+        // If compression does not reduce the size, store the file uncompressed
+        if (entries_[i].compressed_ && CompressFile(packedBuffer, &buffer[0], dataSize) < dataSize)
+        {
+            entries_[i].packedSize_ = packedBuffer.Size();
+            dest.Write(&packedBuffer[0], packedBuffer.Size());
+        }
+        else
+        {
+            entries_[i].compressed_ = false;
+            entries_[i].packedSize_ = dataSize;
+            dest.Write(&buffer[0], dataSize);
+        }
+        
+        totalSize += entries_[i].size_;
+        totalPackedSize += entries_[i].packedSize_;
+        
+        if (entries_[i].compressed_)
+        {
+            PrintLine("Writing file " + entries_[i].name_ + " compressed " + String(entries_[i].size_) + " -> " +
+                String(entries_[i].packedSize_) + " bytes");
+        }
+        else
+            PrintLine("Writing file " + entries_[i].name_);
     }
     
     // Write header again with correct offsets & checksums
     dest.Seek(0);
-    dest.WriteFileID("UPAK");
-    dest.WriteUInt(entries_.Size());
-    dest.WriteUInt(checksum_);
+    WriteHeader(dest, compressed);
     
-    for (unsigned i = 0; i < entries_.Size(); ++i)
+    if (compressed)
+        PrintLine("File data " + String(totalSize) + " bytes, compressed " + String(totalPackedSize) + " bytes");
+    PrintLine("Package total size " + String(dest.GetSize()) + " bytes");
+}
+
+void WriteHeader(File& dest, bool compressed)
+{
+    if (!compressed)
+    {
+        dest.WriteFileID("UPAK");
+        dest.WriteUInt(entries_.Size());
+        dest.WriteUInt(checksum_);
+        
+        for (unsigned i = 0; i < entries_.Size(); ++i)
+        {
+            dest.WriteString(entries_[i].name_);
+            dest.WriteUInt(entries_[i].offset_);
+            dest.WriteUInt(entries_[i].size_);
+            dest.WriteUInt(entries_[i].checksum_);
+        }
+    }
+    else
     {
-        dest.WriteString(entries_[i].name_);
-        dest.WriteUInt(entries_[i].offset_);
-        dest.WriteUInt(entries_[i].size_);
-        dest.WriteUInt(entries_[i].checksum_);
+        dest.WriteFileID("UPKG");
+        dest.WriteUInt(PACKAGE_FORMAT_VERSION);
+        dest.WriteUInt(entries_.Size());
+        dest.WriteUInt(checksum_);
+        dest.WriteUInt(blockSize_);
+        
+        for (unsigned i = 0; i < entries_.Size(); ++i)
+        {
+            dest.WriteString(entries_[i].name_);
+            dest.WriteUInt(entries_[i].offset_);
+            dest.WriteUInt(entries_[i].size_);
+            dest.WriteUInt(entries_[i].packedSize_);
+            dest.WriteUInt(entries_[i].checksum_);
+            dest.WriteBool(entries_[i].compressed_);
+        }
     }
+}
+
+bool ShouldCompress(const String& fileName)
+{
+    String extension = GetExtension(fileName);
+    if (uncompressedExtensions_.Contains(extension))
+        return false;
     
-    PrintLine("Package total size " + String(dest.GetSize()) + " bytes");
+    return compressAll_ || compressExtensions_.Contains(extension);
+}
+
+unsigned CompressFile(PODVector<unsigned char>& dest, const unsigned char* src, unsigned srcSize)
+{
+    // The data is split into blocks which are compressed independently, preceded by a table of block offsets. A block
+    // which does not compress is stored as is
+    unsigned numBlocks = (srcSize + blockSize_ - 1) / blockSize_;
+    unsigned tableSize = (numBlocks + 1) * sizeof(unsigned);
+    dest.Resize(tableSize + numBlocks * EstimateCompressBound(blockSize_));
+    
+    unsigned* blockOffsets = (unsigned*)&dest[0];
+    unsigned offset = tableSize;
+    
+    for (unsigned i = 0; i < numBlocks; ++i)
+    {
+        const unsigned char* blockSrc = src + i * blockSize_;
+        unsigned unpackedSize = Min((int)blockSize_, (int)(srcSize - i * blockSize_));
+        unsigned packedSize = CompressData(&dest[offset], blockSrc, unpackedSize);
+        if (packedSize >= unpackedSize)
+        {
+            memcpy(&dest[offset], blockSrc, unpackedSize);
+            packedSize = unpackedSize;
+        }
+        
+        blockOffsets[i] = offset;
+        offset += packedSize;
+    }
+    
+    blockOffsets[numBlocks] = offset;
+    dest.Resize(offset);
+    return offset;
+}
+
+bool CompileXML(VectorBuffer& dest, const unsigned char* src, unsigned srcSize, const String& fileName)
+{
+    unsigned sourceChecksum = 0;
+    for (unsigned i = 0; i < srcSize; ++i)
+        sourceChecksum = SDBMHash(sourceChecksum, src[i]);
+    
+    MemoryBuffer source(src, srcSize);
+    SharedPtr<XMLFile> xml(new XMLFile(context_));
+    if (!xml->Load(source))
+    {
+        PrintLine("Could not parse " + fileName + ", storing as is");
+        return false;
+    }
+    
+    return xml->SaveBinary(dest, sourceChecksum);
 }
@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Context.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "Image.h"
+#include "ProcessUtils.h"
+#include "StringUtils.h"
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <cctype>
+
+#include "DebugNew.h"
+
+using namespace Urho3D;
+
+SharedPtr<Context> context_(new Context());
+SharedPtr<FileSystem> fileSystem_(new FileSystem(context_));
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+    
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+    
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() < 2)
+    {
+        ErrorExit(
+            "Usage: TextureCompressor <input image> <output DDS file> [options]\n"
+            "\n"
+            "Options:\n"
+            "-f<format>   Compressed format dxt1 or dxt5. Default is dxt5 for images with alpha\n"
+            "-q<quality>  Compression quality fast, normal or high. Default is normal\n"
+            "-n           Do not generate mip levels\n"
+        );
+    }
+    
+    const String& inputName = arguments[0];
+    const String& outputName = arguments[1];
+    CompressedFormat format = CF_NONE;
+    CompressQuality quality = CQ_NORMAL;
+    bool generateLevels = true;
+    
+    for (unsigned i = 2; i < arguments.Size(); ++i)
+    {
+        const String& arg = arguments[i];
+        if (arg.Length() < 2 || arg[0] != '-')
+            ErrorExit("Unrecognized argument " + arg);
+        
+        String value = arg.Substring(2).ToLower();
+        switch (tolower(arg[1]))
+        {
+        case 'f':
+            if (value == "dxt1")
+                format = CF_DXT1;
+            else if (value == "dxt5")
+                format = CF_DXT5;
+            else
+                ErrorExit("Unsupported format " + value);
+            break;
+            
+        case 'q':
+            if (value == "fast")
+                quality = CQ_FAST;
+            else if (value == "normal")
+                quality = CQ_NORMAL;
+            else if (value == "high")
+                quality = CQ_HIGH;
+            else
+                ErrorExit("Unrecognized quality " + value);
+            break;
+            
+        case 'n':
+            generateLevels = false;
+            break;
+            
+        default:
+            ErrorExit("Unrecognized option " + arg);
+        }
+    }
+    
+    File source(context_);
+    if (!source.Open(inputName))
+        ErrorExit("Could not open input file " + inputName);
+    
+    SharedPtr<Image> image(new Image(context_));
+    if (!image->Load(source))
+        ErrorExit("Could not load image " + inputName);
+    
+    if (format == CF_NONE)
+        format = (image->GetComponents() == 2 || image->GetComponents() == 4) ? CF_DXT5 : CF_DXT1;
+    
+    PrintLine("Compressing " + inputName + " (" + String(image->GetWidth()) + "x" + String(image->GetHeight()) + ")");
+    
+    if (!image->Compress(format, quality, generateLevels))
+        ErrorExit("Could not compress image " + inputName);
+    if (!image->SaveDDS(outputName))
+        ErrorExit("Could not write output file " + outputName);
+}